@@ -30,26 +30,23 @@ template <typename T> static inline void really_delete_cont(T cont) {
   }
 }
 
-static void BM_Congruence_full_PBR_monoid(benchmark::State& state) {
+// The template parameter TPBR is PBR or PackedPBR.
+template <class TPBR>
+static void full_PBR_monoid_benchmark(benchmark::State& state) {
   while (state.KeepRunning()) {
     std::vector<Element*> gens = {
-        new PBR(new std::vector<std::vector<u_int32_t>>({{2}, {3}, {0}, {1}})),
-        new PBR(
-            new std::vector<std::vector<u_int32_t>>({{}, {2}, {1}, {0, 3}})),
-        new PBR(
-            new std::vector<std::vector<u_int32_t>>({{0, 3}, {2}, {1}, {}})),
-        new PBR(
-            new std::vector<std::vector<u_int32_t>>({{1, 2}, {3}, {0}, {1}})),
-        new PBR(
-            new std::vector<std::vector<u_int32_t>>({{2}, {3}, {0}, {1, 3}})),
-        new PBR(new std::vector<std::vector<u_int32_t>>({{3}, {1}, {0}, {1}})),
-        new PBR(
-            new std::vector<std::vector<u_int32_t>>({{3}, {2}, {0}, {0, 1}})),
-        new PBR(new std::vector<std::vector<u_int32_t>>({{3}, {2}, {0}, {1}})),
-        new PBR(new std::vector<std::vector<u_int32_t>>({{3}, {2}, {0}, {3}})),
-        new PBR(new std::vector<std::vector<u_int32_t>>({{3}, {2}, {1}, {0}})),
-        new PBR(
-            new std::vector<std::vector<u_int32_t>>({{3}, {2, 3}, {0}, {1}}))};
+        new TPBR(std::vector<std::vector<u_int32_t>>({{2}, {3}, {0}, {1}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{}, {2}, {1}, {0, 3}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{0, 3}, {2}, {1}, {}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{1, 2}, {3}, {0}, {1}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{2}, {3}, {0}, {1, 3}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{3}, {1}, {0}, {1}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{3}, {2}, {0}, {0, 1}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{3}, {2}, {0}, {1}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{3}, {2}, {0}, {3}})),
+        new TPBR(std::vector<std::vector<u_int32_t>>({{3}, {2}, {1}, {0}})),
+        new TPBR(
+            std::vector<std::vector<u_int32_t>>({{3}, {2, 3}, {0}, {1}}))};
 
     Semigroup S = Semigroup(gens);
     S.set_report(false);
@@ -72,11 +69,24 @@ static void BM_Congruence_full_PBR_monoid(benchmark::State& state) {
   }
 }
 
+static void BM_Congruence_full_PBR_monoid(benchmark::State& state) {
+  full_PBR_monoid_benchmark<PBR>(state);
+}
+
 BENCHMARK(BM_Congruence_full_PBR_monoid)
     ->Unit(benchmark::kMillisecond)
     ->Repetitions(2)
     ->UseManualTime();
 
+static void BM_Congruence_full_PBR_monoid_packed(benchmark::State& state) {
+  full_PBR_monoid_benchmark<PackedPBR>(state);
+}
+
+BENCHMARK(BM_Congruence_full_PBR_monoid_packed)
+    ->Unit(benchmark::kMillisecond)
+    ->Repetitions(2)
+    ->UseManualTime();
+
 static void BM_Congruence_full_PBR_monoid_max_2(benchmark::State& state) {
   while (state.KeepRunning()) {
     std::vector<Element*> gens = {
@@ -125,4 +135,111 @@ BENCHMARK(BM_Congruence_full_PBR_monoid_max_2)
     ->Repetitions(2)
     ->UseManualTime();
 
+// The following benchmarks are of Todd-Coxeter applied to the presentations
+// in tests/tc.test.cc, and to a larger one, and depend on the layout of the
+// coset table, see the configure option --with-coset-table.
+
+static void tc_benchmark(benchmark::State&              state,
+                         std::string                    type,
+                         size_t                         nrgens,
+                         std::vector<relation_t> const& rels,
+                         size_t                         pack       = 120000,
+                         size_t                         nr_threads = 1) {
+  size_t nr_defined = 0;
+  while (state.KeepRunning()) {
+    Congruence cong(type, nrgens, rels, std::vector<relation_t>());
+    cong.set_report(false);
+    cong.force_tc();
+    cong.set_pack(pack);
+    cong.set_tc_lookahead_threads(nr_threads);
+    benchmark::DoNotOptimize(cong.nr_classes());
+    nr_defined = cong.metrics().nr_cosets_defined;
+  }
+  state.counters["defined"] = nr_defined;
+}
+
+static std::vector<relation_t> const tc_16_rels
+    = {relation_t({0, 0, 0}, {0}),
+       relation_t({1, 0, 0}, {1, 0}),
+       relation_t({1, 0, 1, 1, 1}, {1, 0}),
+       relation_t({1, 1, 1, 1, 1}, {1, 1}),
+       relation_t({1, 1, 0, 1, 1, 0}, {1, 0, 1, 0, 1, 1}),
+       relation_t({0, 0, 1, 0, 1, 1, 0}, {0, 1, 0, 1, 1, 0}),
+       relation_t({0, 0, 1, 1, 0, 1, 0}, {0, 1, 1, 0, 1, 0}),
+       relation_t({0, 1, 0, 1, 0, 1, 0}, {1, 0, 1, 0, 1, 0}),
+       relation_t({1, 0, 1, 0, 1, 0, 1}, {1, 0, 1, 0, 1, 0}),
+       relation_t({1, 0, 1, 0, 1, 1, 0}, {1, 0, 1, 0, 1, 1}),
+       relation_t({1, 0, 1, 1, 0, 1, 0}, {1, 0, 1, 1, 0, 1}),
+       relation_t({1, 1, 0, 1, 0, 1, 0}, {1, 0, 1, 0, 1, 0}),
+       relation_t({1, 1, 1, 1, 0, 1, 0}, {1, 0, 1, 0}),
+       relation_t({0, 0, 1, 1, 1, 0, 1, 0}, {1, 1, 1, 0, 1, 0})};
+
+static void BM_TC_16_twosided(benchmark::State& state) {
+  tc_benchmark(state, "twosided", 2, tc_16_rels);
+}
+
+static void BM_TC_16_left(benchmark::State& state) {
+  tc_benchmark(state, "left", 2, tc_16_rels);
+}
+
+static void BM_TC_19_PSL_2_7(benchmark::State& state) {
+  tc_benchmark(
+      state,
+      "twosided",
+      3,
+      {relation_t({0, 0}, {0}),
+       relation_t({0, 1}, {1}),
+       relation_t({1, 0}, {1}),
+       relation_t({0, 2}, {2}),
+       relation_t({2, 0}, {2}),
+       relation_t({1, 1}, {0}),
+       relation_t({2, 2, 2}, {0}),
+       relation_t({1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2}, {0}),
+       relation_t({1, 2, 2, 1, 2, 1, 2, 2, 1, 2, 1, 2, 2, 1, 2, 1, 2, 2, 1, 2},
+                  {0})});
+}
+
+// A monoid presentation for the symmetric group of degree 7, where 0 is the
+// identity and 1, ..., 6 are the Coxeter generators.
+static std::vector<relation_t> symmetric_group_7_rels() {
+  std::vector<relation_t> rels;
+  for (letter_t i = 0; i <= 6; i++) {
+    rels.push_back(relation_t({0, i}, {i}));
+    rels.push_back(relation_t({i, 0}, {i}));
+  }
+  for (letter_t i = 1; i <= 6; i++) {
+    rels.push_back(relation_t({i, i}, {0}));
+    for (letter_t j = i + 1; j <= 6; j++) {
+      if (j == i + 1) {
+        rels.push_back(relation_t({i, j, i, j, i, j}, {0}));
+      } else {
+        rels.push_back(relation_t({i, j, i, j}, {0}));
+      }
+    }
+  }
+  return rels;
+}
+
+static void BM_TC_symmetric_group_7(benchmark::State& state) {
+  tc_benchmark(state, "twosided", 7, symmetric_group_7_rels());
+}
+
+// The argument is the number of threads used by each lookahead, and the
+// packing threshold is lowered so that lookaheads take most of the time.
+static void BM_TC_symmetric_group_7_lookahead(benchmark::State& state) {
+  tc_benchmark(
+      state, "twosided", 7, symmetric_group_7_rels(), 20000, state.range(0));
+}
+
+BENCHMARK(BM_TC_16_twosided)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TC_16_left)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TC_19_PSL_2_7)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TC_symmetric_group_7)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TC_symmetric_group_7_lookahead)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->UseRealTime();
+
 BENCHMARK_MAIN();
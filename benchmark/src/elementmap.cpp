@@ -0,0 +1,211 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains some benchmarks comparing libsemigroups/src/elementmap.h
+// with the std::unordered_map previously used by Semigroup. The label of each
+// benchmark is the number of bytes used by the table per element, not
+// including the elements themselves, and items/s is the number of lookups per
+// second.
+
+#include <benchmark/benchmark.h>
+#include <libsemigroups/elementmap.h>
+#include <libsemigroups/semigroups.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace libsemigroups;
+
+template <typename T> static inline void really_delete_cont(T cont) {
+  for (Element* x : cont) {
+    x->really_delete();
+    delete x;
+  }
+}
+
+// An allocator which counts the number of bytes it has allocated, so that the
+// memory used by a std::unordered_map can be measured.
+static size_t nr_bytes_allocated = 0;
+
+template <typename T> struct CountingAllocator {
+  typedef T value_type;
+
+  CountingAllocator() = default;
+  template <typename S> CountingAllocator(CountingAllocator<S> const&) {}
+
+  T* allocate(size_t n) {
+    nr_bytes_allocated += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) {
+    nr_bytes_allocated -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+};
+
+template <typename T, typename S>
+bool operator==(CountingAllocator<T> const&, CountingAllocator<S> const&) {
+  return true;
+}
+
+template <typename T, typename S>
+bool operator!=(CountingAllocator<T> const&, CountingAllocator<S> const&) {
+  return false;
+}
+
+typedef std::unordered_map<
+    Element const*,
+    size_t,
+    Element::Hash,
+    Element::Equal,
+    CountingAllocator<std::pair<Element const* const, size_t>>>
+    unordered_map_t;
+
+// The elements of the full transformation monoid of degree 7.
+static std::vector<Element*> full_transformation_monoid_7() {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 2, 3, 4, 5, 6, 0}),
+         new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5, 6}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5, 6})};
+  Semigroup S = Semigroup(gens);
+  S.set_report(false);
+  really_delete_cont(gens);
+  std::vector<Element*> out;
+  for (size_t i = 0; i < S.size(); i++) {
+    out.push_back(S.at(i)->really_copy());
+  }
+  return out;
+}
+
+// The keys inserted into the tables, and (distinct) copies of them to use in
+// the lookups.
+static std::vector<Element*> const& keys() {
+  static std::vector<Element*> const out = full_transformation_monoid_7();
+  return out;
+}
+
+static std::vector<Element*> const& lookups() {
+  static std::vector<Element*> const out = full_transformation_monoid_7();
+  return out;
+}
+
+static void BM_ElementMap_insert(benchmark::State& state) {
+  std::vector<Element*> const& elts = keys();
+  size_t                       bytes = 0;
+  while (state.KeepRunning()) {
+    ElementMap<size_t> map(&elts);
+    for (size_t i = 0; i < elts.size(); i++) {
+      map.insert(elts[i], i);
+    }
+    bytes = map.bytes();
+  }
+  state.SetItemsProcessed(state.iterations() * elts.size());
+  state.SetLabel(std::to_string(static_cast<double>(bytes) / elts.size())
+                 + " bytes/element");
+}
+
+BENCHMARK(BM_ElementMap_insert)->MinTime(1)->Unit(benchmark::kMillisecond);
+
+static void BM_unordered_map_insert(benchmark::State& state) {
+  std::vector<Element*> const& elts  = keys();
+  size_t                       bytes = 0;
+  while (state.KeepRunning()) {
+    size_t          before = nr_bytes_allocated;
+    unordered_map_t map;
+    for (size_t i = 0; i < elts.size(); i++) {
+      map.insert(std::make_pair(elts[i], i));
+    }
+    bytes = nr_bytes_allocated - before + sizeof(map);
+  }
+  state.SetItemsProcessed(state.iterations() * elts.size());
+  state.SetLabel(std::to_string(static_cast<double>(bytes) / elts.size())
+                 + " bytes/element");
+}
+
+BENCHMARK(BM_unordered_map_insert)->MinTime(1)->Unit(benchmark::kMillisecond);
+
+static void BM_ElementMap_find(benchmark::State& state) {
+  std::vector<Element*> const& elts = keys();
+  std::vector<Element*> const& look = lookups();
+  ElementMap<size_t>           map(&elts);
+  for (size_t i = 0; i < elts.size(); i++) {
+    map.insert(elts[i], i);
+  }
+  while (state.KeepRunning()) {
+    for (Element const* x : look) {
+      benchmark::DoNotOptimize(map.find(x));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * look.size());
+  state.SetLabel(std::to_string(static_cast<double>(map.bytes()) / elts.size())
+                 + " bytes/element");
+}
+
+BENCHMARK(BM_ElementMap_find)->MinTime(1)->Unit(benchmark::kMillisecond);
+
+static void BM_unordered_map_find(benchmark::State& state) {
+  std::vector<Element*> const& elts   = keys();
+  std::vector<Element*> const& look   = lookups();
+  size_t                       before = nr_bytes_allocated;
+  unordered_map_t              map;
+  for (size_t i = 0; i < elts.size(); i++) {
+    map.insert(std::make_pair(elts[i], i));
+  }
+  size_t bytes = nr_bytes_allocated - before + sizeof(map);
+  while (state.KeepRunning()) {
+    for (Element const* x : look) {
+      benchmark::DoNotOptimize(map.find(x));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * look.size());
+  state.SetLabel(std::to_string(static_cast<double>(bytes) / elts.size())
+                 + " bytes/element");
+}
+
+BENCHMARK(BM_unordered_map_find)->MinTime(1)->Unit(benchmark::kMillisecond);
+
+static ElementMap<size_t>* make_map() {
+  std::vector<Element*> const& elts = keys();
+  ElementMap<size_t>*          map  = new ElementMap<size_t>(&elts);
+  for (size_t i = 0; i < elts.size(); i++) {
+    map->insert(elts[i], i);
+  }
+  return map;
+}
+
+// Every thread looks up every element using concurrent_find, so that the cost
+// of locking the shards is included.
+static void BM_ElementMap_concurrent_find(benchmark::State& state) {
+  static ElementMap<size_t>* const map  = make_map();
+  std::vector<Element*> const&     look = lookups();
+  while (state.KeepRunning()) {
+    for (Element const* x : look) {
+      benchmark::DoNotOptimize(map->concurrent_find(x));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * look.size());
+}
+
+BENCHMARK(BM_ElementMap_concurrent_find)
+    ->Threads(4)
+    ->MinTime(1)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
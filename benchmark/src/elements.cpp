@@ -0,0 +1,213 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains some benchmarks for the multiplication of elements in
+// libsemigroups/src/elements.cc. The argument of each benchmark is the degree.
+
+#include <benchmark/benchmark.h>
+#include <libsemigroups/elements.h>
+
+#include <vector>
+
+using namespace libsemigroups;
+
+// A boolean matrix of dimension n with about a third of its entries true
+static std::vector<std::vector<bool>> bmat(size_t n, size_t a) {
+  std::vector<std::vector<bool>> out(n, std::vector<bool>(n));
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      out[i][j] = ((a * i + j) % 3 == 0);
+    }
+  }
+  return out;
+}
+
+template <class TElement>
+static void product_benchmark(benchmark::State& state) {
+  size_t const n = state.range(0);
+  TElement     x(bmat(n, 5)), y(bmat(n, 7)), xy(bmat(n, 1));
+  while (state.KeepRunning()) {
+    xy.redefine(&x, &y);
+    benchmark::DoNotOptimize(xy.hash_value());
+  }
+  state.SetItemsProcessed(state.iterations());
+  x.really_delete();
+  y.really_delete();
+  xy.really_delete();
+}
+
+static void BM_product_bmat(benchmark::State& state) {
+  product_benchmark<BooleanMat>(state);
+}
+
+BENCHMARK(BM_product_bmat)->DenseRange(5, 8)->Arg(16)->Arg(64)->Arg(100);
+
+static void BM_product_packed_bmat(benchmark::State& state) {
+  product_benchmark<PackedBooleanMat>(state);
+}
+
+BENCHMARK(BM_product_packed_bmat)
+    ->DenseRange(5, 8)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(100);
+
+// A matrix of dimension n over the semiring sr with entries from 0 to 9, and
+// about a fifth of its entries equal to the zero of sr.
+static std::vector<std::vector<int64_t>>
+matrix(Semiring const* sr, size_t n, size_t a) {
+  std::vector<std::vector<int64_t>> out(n, std::vector<int64_t>(n));
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      out[i][j] = ((a * i + j) % 5 == 0 ? sr->zero() : (a * i + j) % 10);
+    }
+  }
+  return out;
+}
+
+template <class TSemiring, class TElement = MatrixOverSemiring>
+static void matrix_product_benchmark(benchmark::State& state,
+                                     TSemiring*        sr) {
+  size_t const n = state.range(0);
+  TElement     x(matrix(sr, n, 3), sr), y(matrix(sr, n, 7), sr),
+      xy(matrix(sr, n, 1), sr);
+  while (state.KeepRunning()) {
+    xy.redefine(&x, &y);
+    benchmark::DoNotOptimize(xy.hash_value());
+  }
+  state.SetItemsProcessed(state.iterations());
+  x.really_delete();
+  y.really_delete();
+  xy.really_delete();
+  delete sr;
+}
+
+static void BM_product_int_mat(benchmark::State& state) {
+  matrix_product_benchmark(state, new Integers());
+}
+
+BENCHMARK(BM_product_int_mat)->Arg(3)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_product_max_plus_mat(benchmark::State& state) {
+  matrix_product_benchmark(state, new MaxPlusSemiring());
+}
+
+BENCHMARK(BM_product_max_plus_mat)->Arg(3)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_product_proj_max_plus_mat(benchmark::State& state) {
+  matrix_product_benchmark<MaxPlusSemiring, ProjectiveMaxPlusMatrix>(
+      state, new MaxPlusSemiring());
+}
+
+BENCHMARK(BM_product_proj_max_plus_mat)->Arg(3)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_product_min_plus_mat(benchmark::State& state) {
+  matrix_product_benchmark(state, new MinPlusSemiring());
+}
+
+BENCHMARK(BM_product_min_plus_mat)->Arg(3)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_product_trop_max_plus_mat(benchmark::State& state) {
+  matrix_product_benchmark(state, new TropicalMaxPlusSemiring(33));
+}
+
+BENCHMARK(BM_product_trop_max_plus_mat)->Arg(3)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_product_trop_min_plus_mat(benchmark::State& state) {
+  matrix_product_benchmark(state, new TropicalMinPlusSemiring(11));
+}
+
+BENCHMARK(BM_product_trop_min_plus_mat)->Arg(3)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_product_nat_mat(benchmark::State& state) {
+  matrix_product_benchmark(state, new NaturalSemiring(11, 3));
+}
+
+BENCHMARK(BM_product_nat_mat)->Arg(3)->Arg(8)->Arg(16)->Arg(32);
+
+// The blocks of a bipartition of degree n with at most k blocks
+static std::vector<u_int32_t> bipart(size_t n, size_t k, size_t a) {
+  std::vector<u_int32_t> out(2 * n);
+  std::vector<u_int32_t> lookup(k, static_cast<u_int32_t>(-1));
+  u_int32_t              next = 0;
+  for (size_t i = 0; i < 2 * n; i++) {
+    u_int32_t& block = lookup[(a * i * i + i) % k];
+    if (block == static_cast<u_int32_t>(-1)) {
+      block = next++;
+    }
+    out[i] = block;
+  }
+  return out;
+}
+
+static void BM_product_bipart(benchmark::State& state) {
+  size_t const n = state.range(0);
+  Bipartition  x(bipart(n, n, 3)), y(bipart(n, n, 7)), xy(n);
+  while (state.KeepRunning()) {
+    xy.redefine(&x, &y, 0);
+    benchmark::DoNotOptimize(xy.hash_value());
+  }
+  state.SetItemsProcessed(state.iterations());
+  x.really_delete();
+  y.really_delete();
+  xy.really_delete();
+}
+
+BENCHMARK(BM_product_bipart)->Arg(6)->Arg(16)->Arg(64)->Arg(200)->Arg(1000);
+
+// A PBR of degree n where every point is adjacent to about 2 others
+static std::vector<std::vector<u_int32_t>> pbr(size_t n, size_t a) {
+  std::vector<std::vector<u_int32_t>> out(2 * n);
+  for (size_t i = 0; i < 2 * n; i++) {
+    for (size_t j = 0; j < 2 * n; j++) {
+      if ((a * i * i + j) % n == 0) {
+        out[i].push_back(j);
+      }
+    }
+  }
+  return out;
+}
+
+template <class TPBR>
+static void pbr_product_benchmark(benchmark::State& state) {
+  size_t const n = state.range(0);
+  TPBR         x(pbr(n, 3)), y(pbr(n, 7)), xy(pbr(n, 1));
+  Element&     e = xy;
+  while (state.KeepRunning()) {
+    e.redefine(&x, &y);
+    benchmark::DoNotOptimize(xy.hash_value());
+  }
+  state.SetItemsProcessed(state.iterations());
+  x.really_delete();
+  y.really_delete();
+  xy.really_delete();
+}
+
+static void BM_product_pbr(benchmark::State& state) {
+  pbr_product_benchmark<PBR>(state);
+}
+
+BENCHMARK(BM_product_pbr)->Arg(2)->Arg(8)->Arg(32)->Arg(100);
+
+static void BM_product_packed_pbr(benchmark::State& state) {
+  pbr_product_benchmark<PackedPBR>(state);
+}
+
+BENCHMARK(BM_product_packed_pbr)->Arg(2)->Arg(8)->Arg(32)->Arg(100);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains some benchmarks comparing the functions in
+// libsemigroups/src/kernels.h for u_int8_t (which use SSSE3 if possible) with
+// the portable versions. The argument of each benchmark is the degree.
+
+#include <benchmark/benchmark.h>
+#include <libsemigroups/kernels.h>
+
+#include <vector>
+
+using namespace libsemigroups;
+
+// Returns the images of a transformation of degree n
+static std::vector<u_int8_t> transf(size_t n, size_t a) {
+  std::vector<u_int8_t> out(n);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = static_cast<u_int8_t>((a * i + 1) % n);
+  }
+  return out;
+}
+
+static void BM_compose_scalar(benchmark::State& state) {
+  size_t const          n = state.range(0);
+  std::vector<u_int8_t> x = transf(n, 5), y = transf(n, 7), xy(n);
+  while (state.KeepRunning()) {
+    compose<u_int8_t>(x.data(), y.data(), xy.data(), n);
+    benchmark::DoNotOptimize(xy.data());
+    std::swap(x, xy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_compose_scalar)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
+static void BM_compose_dispatch(benchmark::State& state) {
+  size_t const          n = state.range(0);
+  std::vector<u_int8_t> x = transf(n, 5), y = transf(n, 7), xy(n);
+  while (state.KeepRunning()) {
+    compose(x.data(), y.data(), xy.data(), n);
+    benchmark::DoNotOptimize(xy.data());
+    std::swap(x, xy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_compose_dispatch)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
+static void BM_hash_images(benchmark::State& state) {
+  size_t const          n = state.range(0);
+  std::vector<u_int8_t> x = transf(n, 5);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(hash_images(x.data(), n));
+    x[0]++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_hash_images)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
+// The previous way of hashing the images
+static void BM_hash_images_horner(benchmark::State& state) {
+  size_t const          n = state.range(0);
+  std::vector<u_int8_t> x = transf(n, 5);
+  while (state.KeepRunning()) {
+    size_t seed = 0;
+    for (auto val : x) {
+      seed *= n;
+      seed += val;
+    }
+    benchmark::DoNotOptimize(seed);
+    x[0]++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_hash_images_horner)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
+BENCHMARK_MAIN();
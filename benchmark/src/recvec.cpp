@@ -0,0 +1,120 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains some benchmarks comparing the storage policies for
+// RecVec in libsemigroups/src/storage.h, using the right Cayley graph of the
+// full transformation monoid of degree 7. The label of each benchmark is the
+// number of bits used per entry.
+
+#include <benchmark/benchmark.h>
+#include <libsemigroups/recvec.h>
+#include <libsemigroups/semigroups.h>
+
+#include <string>
+#include <vector>
+
+using namespace libsemigroups;
+
+template <typename T> static inline void really_delete_cont(T cont) {
+  for (Element* x : cont) {
+    x->really_delete();
+    delete x;
+  }
+}
+
+static RecVec<size_t> const& graph() {
+  static RecVec<size_t> out;
+  if (out.nr_rows() == 0) {
+    std::vector<Element*> gens
+        = {new Transformation<u_int8_t>({1, 2, 3, 4, 5, 6, 0}),
+           new Transformation<u_int8_t>({1, 0, 2, 3, 4, 5, 6}),
+           new Transformation<u_int8_t>({0, 0, 2, 3, 4, 5, 6})};
+    FroidurePin<Transformation<u_int8_t>> S(gens);
+    S.set_report(false);
+    really_delete_cont(gens);
+    out = RecVec<size_t>(*S.right_cayley_graph(), 0);
+  }
+  return out;
+}
+
+// The number of bits used per entry by a RecVec whose largest entry is max
+static std::string bits_label(std::vector<size_t>*, size_t) {
+  return std::to_string(8 * sizeof(size_t)) + " bits/entry";
+}
+
+static std::string bits_label(PackedStorage<size_t>*, size_t max) {
+  PackedStorage<size_t> storage;
+  storage.resize(1, max);
+  return std::to_string(storage.width()) + " bits/entry";
+}
+
+#ifdef HAVE_SYS_MMAN_H
+static std::string bits_label(MmapStorage<size_t>*, size_t) {
+  return std::to_string(8 * sizeof(size_t)) + " bits/entry (on disk)";
+}
+#endif
+
+// Fill a RecVec with the entries of the graph, row by row
+template <class TStorage> static void BM_recvec_set(benchmark::State& state) {
+  RecVec<size_t> const& g = graph();
+  while (state.KeepRunning()) {
+    RecVec<size_t, TStorage> rv(g.nr_cols());
+    for (size_t i = 0; i < g.nr_rows(); i++) {
+      rv.add_rows(1);
+      for (size_t j = 0; j < g.nr_cols(); j++) {
+        rv.set(i, j, g.get(i, j));
+      }
+    }
+    benchmark::DoNotOptimize(rv.get(0, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * g.size());
+}
+
+// Follow a path of length 10 ^ 6 in the graph
+template <class TStorage> static void BM_recvec_get(benchmark::State& state) {
+  RecVec<size_t, TStorage> const rv(graph(), 0);
+  while (state.KeepRunning()) {
+    size_t pos = 0;
+    for (size_t k = 0; k < 1000000; k++) {
+      pos = rv.get(pos, k % 3);
+    }
+    benchmark::DoNotOptimize(pos);
+  }
+  state.SetItemsProcessed(state.iterations() * 1000000);
+  state.SetLabel(bits_label(static_cast<TStorage*>(nullptr), rv.nr_rows() - 1));
+}
+
+BENCHMARK_TEMPLATE(BM_recvec_set, std::vector<size_t>)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_recvec_set, PackedStorage<size_t>)
+    ->Unit(benchmark::kMillisecond);
+#ifdef HAVE_SYS_MMAN_H
+BENCHMARK_TEMPLATE(BM_recvec_set, MmapStorage<size_t>)
+    ->Unit(benchmark::kMillisecond);
+#endif
+
+BENCHMARK_TEMPLATE(BM_recvec_get, std::vector<size_t>)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_recvec_get, PackedStorage<size_t>)
+    ->Unit(benchmark::kMillisecond);
+#ifdef HAVE_SYS_MMAN_H
+BENCHMARK_TEMPLATE(BM_recvec_get, MmapStorage<size_t>)
+    ->Unit(benchmark::kMillisecond);
+#endif
+
+BENCHMARK_MAIN();
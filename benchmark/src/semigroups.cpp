@@ -24,6 +24,10 @@
 #include <benchmark/benchmark.h>
 #include <libsemigroups/semigroups.h>
 
+#include <stdio.h>
+
+#include <string>
+
 using namespace libsemigroups;
 
 template <typename T> static inline void really_delete_cont(T cont) {
@@ -4050,4 +4054,608 @@ BENCHMARK(BM_size_reserve_full_pbr_2)
     ->MinTime(1)
     ->UseManualTime();
 
+// The following benchmarks compare Semigroup with FroidurePin, for each type
+// of element for which FroidurePin is provided. The suffix _virtual or
+// _froidure_pin of a benchmark indicates which class is used.
+
+template <class TSemigroup>
+static void size_benchmark(benchmark::State&     state,
+                           std::vector<Element*> gens) {
+  while (state.KeepRunning()) {
+    TSemigroup S(gens);
+    S.set_report(false);
+    auto start = std::chrono::high_resolution_clock::now();
+    S.size();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds
+        = std::chrono::duration_cast<std::chrono::duration<double>>(end
+                                                                    - start);
+    state.SetIterationTime(elapsed_seconds.count());
+  }
+  really_delete_cont(gens);
+}
+
+// The full transformation monoid of degree 7
+static std::vector<Element*> full_trans_7() {
+  return {new Transformation<u_int8_t>({1, 2, 3, 4, 5, 6, 0}),
+          new Transformation<u_int8_t>({1, 0, 2, 3, 4, 5, 6}),
+          new Transformation<u_int8_t>({0, 0, 2, 3, 4, 5, 6})};
+}
+
+static void BM_size_full_trans_7_virtual(benchmark::State& state) {
+  size_benchmark<Semigroup>(state, full_trans_7());
+}
+
+BENCHMARK(BM_size_full_trans_7_virtual)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static void BM_size_full_trans_7_froidure_pin(benchmark::State& state) {
+  size_benchmark<FroidurePin<Transformation<u_int8_t>>>(state,
+                                                         full_trans_7());
+}
+
+BENCHMARK(BM_size_full_trans_7_froidure_pin)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// The symmetric inverse monoid of degree 8
+static std::vector<Element*> sym_inv_8() {
+  return {new PartialPerm<u_int16_t>(
+              {0, 1, 2, 3, 4, 5, 6, 7}, {1, 2, 3, 4, 5, 6, 7, 0}, 8),
+          new PartialPerm<u_int16_t>(
+              {0, 1, 2, 3, 4, 5, 6, 7}, {1, 0, 2, 3, 4, 5, 6, 7}, 8),
+          new PartialPerm<u_int16_t>(
+              {1, 2, 3, 4, 5, 6, 7}, {1, 2, 3, 4, 5, 6, 7}, 8)};
+}
+
+static void BM_size_sym_inv_8_virtual(benchmark::State& state) {
+  size_benchmark<Semigroup>(state, sym_inv_8());
+}
+
+BENCHMARK(BM_size_sym_inv_8_virtual)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static void BM_size_sym_inv_8_froidure_pin(benchmark::State& state) {
+  size_benchmark<FroidurePin<PartialPerm<u_int16_t>>>(state, sym_inv_8());
+}
+
+BENCHMARK(BM_size_sym_inv_8_froidure_pin)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// A monoid of 4 x 4 boolean matrices containing the symmetric group
+static std::vector<Element*> bmat_4() {
+  return {new BooleanMat(
+              {{0, 1, 0, 0}, {1, 0, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}),
+          new BooleanMat(
+              {{0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}, {1, 0, 0, 0}}),
+          new BooleanMat(
+              {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {1, 0, 0, 1}}),
+          new BooleanMat(
+              {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 0}})};
+}
+
+static void BM_size_bmat_4_virtual(benchmark::State& state) {
+  size_benchmark<Semigroup>(state, bmat_4());
+}
+
+BENCHMARK(BM_size_bmat_4_virtual)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static void BM_size_bmat_4_froidure_pin(benchmark::State& state) {
+  size_benchmark<FroidurePin<BooleanMat>>(state, bmat_4());
+}
+
+BENCHMARK(BM_size_bmat_4_froidure_pin)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static std::vector<Element*> packed(std::vector<Element*> gens) {
+  std::vector<Element*> out;
+  for (Element* x : gens) {
+    out.push_back(new PackedBooleanMat(*static_cast<BooleanMat*>(x)));
+  }
+  really_delete_cont(gens);
+  return out;
+}
+
+static void BM_size_bmat_4_packed(benchmark::State& state) {
+  size_benchmark<FroidurePin<PackedBooleanMat>>(state, packed(bmat_4()));
+}
+
+BENCHMARK(BM_size_bmat_4_packed)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// The partition monoid of degree 5
+static std::vector<Element*> partition_monoid_5() {
+  return {new Bipartition({0, 1, 2, 3, 4, 0, 1, 2, 3, 4}),
+          new Bipartition({0, 1, 2, 3, 4, 1, 0, 2, 3, 4}),
+          new Bipartition({0, 1, 2, 3, 4, 1, 2, 3, 4, 0}),
+          new Bipartition({0, 1, 2, 3, 4, 5, 1, 2, 3, 4}),
+          new Bipartition({0, 0, 1, 2, 3, 0, 0, 1, 2, 3})};
+}
+
+static void BM_size_partition_monoid_5_virtual(benchmark::State& state) {
+  size_benchmark<Semigroup>(state, partition_monoid_5());
+}
+
+BENCHMARK(BM_size_partition_monoid_5_virtual)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static void BM_size_partition_monoid_5_froidure_pin(benchmark::State& state) {
+  size_benchmark<FroidurePin<Bipartition>>(state, partition_monoid_5());
+}
+
+BENCHMARK(BM_size_partition_monoid_5_froidure_pin)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// The full PBR monoid of degree 2
+static std::vector<Element*> full_pbr_2() {
+  return {new PBR(new PBR_Input({{}, {2}, {1}, {3, 0}})),
+          new PBR(new PBR_Input({{3, 0}, {2}, {1}, {}})),
+          new PBR(new PBR_Input({{2, 1}, {3}, {0}, {1}})),
+          new PBR(new PBR_Input({{2}, {3}, {0}, {3, 1}})),
+          new PBR(new PBR_Input({{3}, {1}, {0}, {1}})),
+          new PBR(new PBR_Input({{3}, {2}, {0}, {0, 1}})),
+          new PBR(new PBR_Input({{3}, {2}, {0}, {1}})),
+          new PBR(new PBR_Input({{3}, {2}, {0}, {3}})),
+          new PBR(new PBR_Input({{3}, {2}, {1}, {0}})),
+          new PBR(new PBR_Input({{3}, {3, 2}, {0}, {1}}))};
+}
+
+static void BM_size_full_pbr_2_virtual(benchmark::State& state) {
+  size_benchmark<Semigroup>(state, full_pbr_2());
+}
+
+BENCHMARK(BM_size_full_pbr_2_virtual)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static void BM_size_full_pbr_2_froidure_pin(benchmark::State& state) {
+  size_benchmark<FroidurePin<PBR>>(state, full_pbr_2());
+}
+
+BENCHMARK(BM_size_full_pbr_2_froidure_pin)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static std::vector<Element*> packed_pbr(std::vector<Element*> gens) {
+  std::vector<Element*> out;
+  for (Element* x : gens) {
+    out.push_back(new PackedPBR(*static_cast<PBR*>(x)));
+  }
+  really_delete_cont(gens);
+  return out;
+}
+
+static void BM_size_full_pbr_2_packed(benchmark::State& state) {
+  size_benchmark<FroidurePin<PackedPBR>>(state, packed_pbr(full_pbr_2()));
+}
+
+BENCHMARK(BM_size_full_pbr_2_packed)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// The time taken to enumerate the elements of the full transformation monoid
+// of degree 7 (BM_enumerate_full_trans_7) compared with the time taken to load
+// the same data from a file written by Semigroup::save (BM_load_full_trans_7).
+
+static void BM_enumerate_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  while (state.KeepRunning()) {
+    FroidurePin<Transformation<u_int8_t>> S(gens);
+    S.set_report(false);
+    auto start = std::chrono::high_resolution_clock::now();
+    S.size();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds
+        = std::chrono::duration_cast<std::chrono::duration<double>>(end
+                                                                    - start);
+    state.SetIterationTime(elapsed_seconds.count());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_enumerate_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+static void BM_load_full_trans_7(benchmark::State& state) {
+  std::string const     filename = "BM_load_full_trans_7.tmp";
+  std::vector<Element*> gens     = full_trans_7();
+  {
+    FroidurePin<Transformation<u_int8_t>> S(gens);
+    S.set_report(false);
+    S.size();
+    S.save(filename);
+  }
+  while (state.KeepRunning()) {
+    FroidurePin<Transformation<u_int8_t>> S(gens);
+    S.set_report(false);
+    auto start = std::chrono::high_resolution_clock::now();
+    S.load(filename);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds
+        = std::chrono::duration_cast<std::chrono::duration<double>>(end
+                                                                    - start);
+    state.SetIterationTime(elapsed_seconds.count());
+  }
+  std::remove(filename.c_str());
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_load_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// The time taken to find the idempotents of the full transformation monoid of
+// degree 7 once it has been enumerated.
+static void BM_nridempotents_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  while (state.KeepRunning()) {
+    FroidurePin<Transformation<u_int8_t>> S(gens);
+    S.set_report(false);
+    S.size();
+    auto start = std::chrono::high_resolution_clock::now();
+    benchmark::DoNotOptimize(S.nridempotents());
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds
+        = std::chrono::duration_cast<std::chrono::duration<double>>(end
+                                                                    - start);
+    state.SetIterationTime(elapsed_seconds.count());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_nridempotents_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// The time taken to sort the elements of the full transformation monoid of
+// degree 7 once it has been enumerated.
+static void BM_sort_elements_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  while (state.KeepRunning()) {
+    FroidurePin<Transformation<u_int8_t>> S(gens);
+    S.set_report(false);
+    S.size();
+    auto start = std::chrono::high_resolution_clock::now();
+    benchmark::DoNotOptimize(S.sorted_at(0));
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds
+        = std::chrono::duration_cast<std::chrono::duration<double>>(end
+                                                                    - start);
+    state.SetIterationTime(elapsed_seconds.count());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_sort_elements_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1)
+    ->UseManualTime();
+
+// 2^20 words of length 20 in the generators of the full transformation monoid
+// of degree 7.
+static std::vector<word_t> words_full_trans_7() {
+  std::vector<word_t> words(1 << 20, word_t(20));
+  size_t              seed = 1;
+  for (word_t& w : words) {
+    for (letter_t& a : w) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      a    = (seed >> 33) % 4;
+    }
+  }
+  return words;
+}
+
+// The time taken to find the positions of many words in the full
+// transformation monoid of degree 7, one word at a time.
+static void BM_word_to_pos_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  std::vector<word_t>                     words = words_full_trans_7();
+  std::vector<Semigroup::element_index_t> result(words.size());
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < words.size(); i++) {
+      result[i] = S.word_to_pos(words[i]);
+    }
+    benchmark::DoNotOptimize(result.data());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_word_to_pos_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1);
+
+// The time taken to find the positions of many words in the full
+// transformation monoid of degree 7, all at once.
+static void BM_word_to_pos_batch_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  std::vector<word_t>                     words = words_full_trans_7();
+  std::vector<Semigroup::element_index_t> result;
+  while (state.KeepRunning()) {
+    S.word_to_pos(words, result);
+    benchmark::DoNotOptimize(result.data());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_word_to_pos_batch_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1);
+
+// 2^20 pairs of positions in the full transformation monoid of degree 7.
+static std::vector<
+    std::pair<Semigroup::element_index_t, Semigroup::element_index_t>>
+pairs_full_trans_7() {
+  std::vector<std::pair<Semigroup::element_index_t, Semigroup::element_index_t>>
+         pairs(1 << 20);
+  size_t seed = 1;
+  for (auto& p : pairs) {
+    seed    = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    p.first = (seed >> 20) % 823543;
+    seed    = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    p.second = (seed >> 20) % 823543;
+  }
+  return pairs;
+}
+
+// The time taken to find many products in the full transformation monoid of
+// degree 7, one at a time.
+static void BM_fast_product_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  auto pairs = pairs_full_trans_7();
+  std::vector<Semigroup::element_index_t> result(pairs.size());
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < pairs.size(); i++) {
+      result[i] = S.fast_product(pairs[i].first, pairs[i].second);
+    }
+    benchmark::DoNotOptimize(result.data());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_fast_product_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1);
+
+// The time taken to find many products in the full transformation monoid of
+// degree 7, all at once.
+static void BM_fast_product_batch_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  auto pairs = pairs_full_trans_7();
+  std::vector<Semigroup::element_index_t> result;
+  while (state.KeepRunning()) {
+    S.fast_product(pairs, result);
+    benchmark::DoNotOptimize(result.data());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_fast_product_batch_full_trans_7)
+    ->Unit(benchmark::kMillisecond)
+    ->MinTime(1);
+
+// All of the transformations of degree 3, as in the test case Semigroup 60.
+static std::vector<Element*> all_trans_3() {
+  std::vector<Element*> coll;
+  for (u_int16_t a = 0; a < 3; a++) {
+    for (u_int16_t b = 0; b < 3; b++) {
+      for (u_int16_t c = 0; c < 3; c++) {
+        coll.push_back(new Transformation<u_int16_t>({a, b, c}));
+      }
+    }
+  }
+  return coll;
+}
+
+// 40 pseudorandom transformations of degree 7, which generate a semigroup of
+// size 471254 with 30 of them.
+static std::vector<Element*> random_trans_7() {
+  std::vector<Element*> coll;
+  size_t                seed = 7;
+  for (size_t k = 0; k < 40; k++) {
+    std::vector<u_int16_t> im(7);
+    for (u_int16_t& a : im) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      a    = (seed >> 33) % 7;
+    }
+    coll.push_back(new Transformation<u_int16_t>(im));
+  }
+  return coll;
+}
+
+// The time taken by Semigroup::closure for the semigroup generated by the
+// first element of coll and all of coll.
+static void BM_closure(benchmark::State&       state,
+                       std::vector<Element*> (*make)()) {
+  std::vector<Element*> coll = make();
+  while (state.KeepRunning()) {
+    Semigroup S({coll[0]});
+    S.set_report(false);
+    S.closure(coll);
+    benchmark::DoNotOptimize(S.size());
+  }
+  really_delete_cont(coll);
+}
+
+// The same as BM_closure, but adding the elements of coll one at a time, as
+// Semigroup::closure used to.
+static void BM_add_generators_one_at_a_time(benchmark::State&       state,
+                                            std::vector<Element*> (*make)()) {
+  std::vector<Element*> coll = make();
+  while (state.KeepRunning()) {
+    Semigroup S({coll[0]});
+    S.set_report(false);
+    std::vector<Element*> singleton(1, nullptr);
+    for (Element* x : coll) {
+      if (!S.test_membership(x)) {
+        singleton[0] = x;
+        S.add_generators(singleton);
+      }
+    }
+    benchmark::DoNotOptimize(S.size());
+  }
+  really_delete_cont(coll);
+}
+
+BENCHMARK_CAPTURE(BM_closure, all_trans_3, all_trans_3)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_add_generators_one_at_a_time, all_trans_3, all_trans_3)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_closure, random_trans_7, random_trans_7)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_add_generators_one_at_a_time,
+                  random_trans_7,
+                  random_trans_7)
+    ->Unit(benchmark::kMillisecond);
+
+// The relations of the full transformation monoid of degree 7, found one at a
+// time by next_relation, as they were by Congruence::init_relations.
+static void BM_next_relation_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  while (state.KeepRunning()) {
+    std::vector<relation_t> relations;
+    word_t                  relation;
+    S.reset_next_relation();
+    S.next_relation(relation);
+    while (!relation.empty()) {
+      word_t lhs, rhs;
+      S.factorisation(lhs, relation[0]);
+      lhs.push_back(relation[1]);
+      S.factorisation(rhs, relation[2]);
+      relations.push_back(std::make_pair(lhs, rhs));
+      S.next_relation(relation);
+    }
+    benchmark::DoNotOptimize(relations.data());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_next_relation_full_trans_7)
+    ->MinTime(1)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_relations_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  while (state.KeepRunning()) {
+    std::vector<relation_t> relations;
+    S.relations(relations);
+    benchmark::DoNotOptimize(relations.data());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_relations_full_trans_7)
+    ->MinTime(1)
+    ->Unit(benchmark::kMillisecond);
+
+// The minimal factorisations of all of the elements of the full
+// transformation monoid of degree 7, found one at a time.
+static void BM_minimal_factorisation_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  while (state.KeepRunning()) {
+    std::vector<word_t*> words;
+    for (size_t i = 0; i < S.size(); i++) {
+      words.push_back(S.minimal_factorisation(i));
+    }
+    benchmark::DoNotOptimize(words.data());
+    for (word_t* w : words) {
+      delete w;
+    }
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_minimal_factorisation_full_trans_7)
+    ->MinTime(1)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_minimal_factorisations_full_trans_7(benchmark::State& state) {
+  std::vector<Element*> gens = full_trans_7();
+  Semigroup             S(gens);
+  S.set_report(false);
+  S.size();
+  while (state.KeepRunning()) {
+    std::vector<letter_t> letters;
+    std::vector<size_t>   offsets;
+    S.minimal_factorisations(letters, offsets);
+    benchmark::DoNotOptimize(letters.data());
+  }
+  really_delete_cont(gens);
+}
+
+BENCHMARK(BM_minimal_factorisations_full_trans_7)
+    ->MinTime(1)
+    ->Unit(benchmark::kMillisecond);
+
+// Finds the position of an element of the full transformation monoid of
+// degree 7 which is one of the last to be enumerated, starting from a small
+// batch size. When more than one thread is used, the products for a whole
+// chunk of elements are computed even if the batch is much smaller.
+static void BM_position_batch_size(benchmark::State& state, bool adaptive) {
+  std::vector<Element*> gens = full_trans_7();
+  Element*              x    = new Transformation<u_int16_t>(
+      std::vector<u_int16_t>({6, 6, 5, 4, 3, 2, 1}));
+  while (state.KeepRunning()) {
+    Semigroup S(gens);
+    S.set_report(false);
+    S.set_batch_size(128);
+    S.set_adaptive_batch_size(adaptive);
+    S.set_max_threads(2);
+    benchmark::DoNotOptimize(S.position(x));
+  }
+  x->really_delete();
+  delete x;
+  really_delete_cont(gens);
+}
+
+BENCHMARK_CAPTURE(BM_position_batch_size, fixed, false)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_position_batch_size, adaptive, true)
+    ->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
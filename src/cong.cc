@@ -19,6 +19,7 @@
 #include "cong.h"
 
 #include <algorithm>
+#include <exception>
 #include <thread>
 
 #include "cong/kbfp.cc"
@@ -56,6 +57,7 @@ namespace libsemigroups {
         _relations(relations),
         _relations_done(false),
         _semigroup(nullptr),
+        _time_init_relations(0),
         _type(type) {
     // TODO(JDM): check that the entries in extra/relations are properly defined
     // i.e. that every entry is at most nrgens - 1
@@ -89,8 +91,10 @@ namespace libsemigroups {
       bool                                                 ignore_max_threads,
       std::function<bool(Congruence::DATA*)>               goal_func) {
     std::vector<std::thread::id> tids(data.size(), std::this_thread::get_id());
+    // The exceptions thrown by the threads which failed to allocate memory
+    std::vector<std::exception_ptr> errors(data.size());
 
-    auto go = [this, &data, &funcs, &tids, &goal_func](size_t pos) {
+    auto go = [this, &data, &funcs, &tids, &errors, &goal_func](size_t pos) {
       tids[pos] = std::this_thread::get_id();
       if (pos < funcs.size()) {
         funcs.at(pos)(data.at(pos));
@@ -99,6 +103,9 @@ namespace libsemigroups {
         data.at(pos)->run_until(goal_func);
       } catch (std::bad_alloc const& e) {
         REPORT("allocation failed: " << e.what())
+        // Killed so that it cannot be chosen as the winner below
+        data.at(pos)->kill();
+        errors.at(pos) = std::current_exception();
         return;
       }
       _kill_mtx.lock();  // stop two DATA objects from killing each other
@@ -158,7 +165,22 @@ namespace libsemigroups {
         return *winner;
       }
     }
-    REPORT("allocation failed in every thread, aborting!")
+    // Every thread failed to allocate memory, and so we delete the data and
+    // pass the exception on to the caller, which can try again with more
+    // memory.
+    REPORT("allocation failed in every thread!")
+    for (DATA* d : data) {
+      delete d;
+    }
+    if (_partial_data == data) {
+      _partial_data.clear();
+    }
+    for (std::exception_ptr const& e : errors) {
+      if (e != nullptr) {
+        std::rethrow_exception(e);
+      }
+    }
+    LIBSEMIGROUPS_ASSERT(false);
     std::abort();
   }
 
@@ -359,34 +381,46 @@ namespace libsemigroups {
     semigroup->enumerate(killed);
 
     if (!killed) {
-      std::vector<size_t> relation;  // a triple
-      semigroup->reset_next_relation();
-      semigroup->next_relation(relation);
-
-      while (relation.size() == 2 && !relation.empty()) {
-        // This is for the case when there are duplicate gens
-        word_t lhs = {relation[0]};
-        word_t rhs = {relation[1]};
-        _relations.push_back(std::make_pair(lhs, rhs));
-        semigroup->next_relation(relation);
-        // We could remove the duplicate generators, and update any relation
-        // that contains a removed generator but this would be more complicated
-      }
-      word_t lhs, rhs;  // changed in-place by factorisation
-      while (!relation.empty()) {
-        semigroup->factorisation(lhs, relation[0]);
-        lhs.push_back(relation[1]);
-
-        semigroup->factorisation(rhs, relation[2]);
-
-        _relations.push_back(std::make_pair(lhs, rhs));
-        semigroup->next_relation(relation);
+      Timer timer;
+      timer.start();
+      // If there are duplicate generators, then the first relations are of
+      // the form {a} = {b}. We could remove the duplicate generators, and
+      // update any relation that contains a removed generator but this would
+      // be more complicated.
+      semigroup->relations(_relations, killed);
+      if (!killed) {
+        _time_init_relations = timer.elapsed();
+        _relations_done      = true;
       }
-      _relations_done = true;
     }
     _init_mtx.unlock();
   }
 
+  Congruence::metrics_t Congruence::metrics() const {
+    metrics_t out;
+    if (_semigroup == nullptr || _relations_done) {
+      out.nr_relations        = _relations.size();
+      out.time_init_relations = _time_init_relations;
+    } else {
+      out.nr_relations        = 0;
+      out.time_init_relations = 0;
+    }
+    out.nr_extra            = _extra.size();
+    out.nr_cosets_defined   = 0;
+    out.nr_cosets_active    = 0;
+    out.nr_cosets_killed    = 0;
+    out.nr_cosets_max       = 0;
+    out.nr_lookaheads       = 0;
+    out.nr_lookahead_killed = 0;
+    out.nr_deductions       = 0;
+    out.nr_table_rewrites   = 0;
+    out.tc_felsch           = false;
+    if (_data != nullptr) {
+      _data->metrics(out);
+    }
+    return out;
+  }
+
   // This is the default method used by a DATA object, and is used only by TC
   // and KBFP; the P and KBP subclasses override with their own superior method.
   // This method requires a Semigroup pointer and therefore does not allow fp
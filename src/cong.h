@@ -279,6 +279,70 @@ namespace libsemigroups {
       return _extra;
     }
 
+    //! Type for the metrics of a congruence returned by Congruence::metrics.
+    struct metrics_t {
+      //! The number of relations of the semigroup over which \c this is
+      //! defined, or \c 0 if they have not been found yet.
+      size_t nr_relations;
+
+      //! The number of extra relations, see Congruence::extra.
+      size_t nr_extra;
+
+      //! The time, in nanoseconds, spent finding the relations of the
+      //! Semigroup over which \c this is defined, if any.
+      int64_t time_init_relations;
+
+      //! The number of cosets defined by the Todd-Coxeter algorithm, if it is
+      //! being used to determine \c this, and \c 0 otherwise.
+      size_t nr_cosets_defined;
+
+      //! The number of cosets which are currently active in the Todd-Coxeter
+      //! algorithm, including the coset of the empty word, if it is being
+      //! used to determine \c this, and \c 0 otherwise.
+      size_t nr_cosets_active;
+
+      //! The number of cosets killed by coincidences in the Todd-Coxeter
+      //! algorithm, if it is being used to determine \c this, and \c 0
+      //! otherwise.
+      size_t nr_cosets_killed;
+
+      //! The maximum number of cosets which the Todd-Coxeter algorithm has
+      //! had to store at any one time, if it is being used to determine \c
+      //! this, and \c 0 otherwise.
+      size_t nr_cosets_max;
+
+      //! The number of lookahead phases performed by the HLT strategy of the
+      //! Todd-Coxeter algorithm, see Congruence::set_tc_lookahead.
+      size_t nr_lookaheads;
+
+      //! The number of cosets killed during lookahead phases.
+      size_t nr_lookahead_killed;
+
+      //! The number of deductions processed by the Felsch strategy of the
+      //! Todd-Coxeter algorithm, see Congruence::set_tc_strategy.
+      size_t nr_deductions;
+
+      //! The number of times the Todd-Coxeter algorithm has rewritten its
+      //! whole coset table after a large coincidence, rather than updating
+      //! the table one killed coset at a time.
+      size_t nr_table_rewrites;
+
+      //! \c true if the Todd-Coxeter algorithm is being used to determine \c
+      //! this and is currently using the Felsch strategy, i.e. if the
+      //! strategy is Congruence::TC_FELSCH, or is Congruence::TC_HYBRID and
+      //! it has switched to Felsch, and \c false otherwise.
+      bool tc_felsch;
+    };
+
+    //! Returns the current metrics of \c this.
+    //!
+    //! The metrics of the Semigroup over which \c this is defined, if any,
+    //! are available from Semigroup::metrics. The metrics about the
+    //! Todd-Coxeter algorithm are only available once an algorithm has been
+    //! chosen to determine \c this, i.e. after any method which requires
+    //! this to be known has been called.
+    metrics_t metrics() const;
+
     //!  Define the relations defining the semigroup over which \c this
     //! is defined.
     //!
@@ -318,9 +382,13 @@ namespace libsemigroups {
     //!
     //! If this method is called after anything has been computed about the
     //! congruence, it has no effect.
-    void set_prefill(RecVec<class_index_t> const& table) {
+    //!
+    //! The parameter \p table can use any storage policy, for example, it
+    //! can be a Semigroup::cayley_graph_t.
+    template <class TStorage>
+    void set_prefill(RecVec<class_index_t, TStorage> const& table) {
       if (_data == nullptr) {
-        _prefill = table;
+        _prefill = RecVec<class_index_t>(table, 0);
       }
     }
 
@@ -349,6 +417,111 @@ namespace libsemigroups {
       }
     }
 
+    //! The strategies which can be used by the Todd-Coxeter algorithm, see
+    //! Congruence::set_tc_strategy.
+    enum tc_strategy_t {
+      //! The Hazelgrove-Leech-Trotter strategy: every relation is applied to
+      //! every coset in turn, defining new cosets whenever necessary, with a
+      //! lookahead phase whenever there are too many active cosets, see
+      //! Congruence::set_pack and Congruence::set_tc_lookahead.
+      TC_HLT = 0,
+      //! The Felsch strategy: the images of every coset under every
+      //! generator are defined in turn, and every relation is applied to
+      //! every coset whose trace passes through a new entry in the coset
+      //! table, without defining any further cosets.
+      TC_FELSCH = 1,
+      //! The HLT strategy, which switches to the Felsch strategy if, after
+      //! a lookahead phase, fewer than half of the cosets ever defined
+      //! are still active.
+      TC_HYBRID = 2
+    };
+
+    //! The lookahead policies which can be used by the HLT strategy of the
+    //! Todd-Coxeter algorithm, see Congruence::set_tc_lookahead.
+    enum tc_lookahead_t {
+      //! Apply the relations to the cosets after the current one.
+      TC_LOOKAHEAD_PARTIAL = 0,
+      //! Apply the relations to every active coset.
+      TC_LOOKAHEAD_FULL = 1,
+      //! Never perform a lookahead.
+      TC_LOOKAHEAD_NONE = 2
+    };
+
+    //! Set the strategy used by the Todd-Coxeter algorithm.
+    //!
+    //! The default strategy is Congruence::TC_HLT. The strategy can be
+    //! changed between runs of the algorithm, but cosets may have to be
+    //! processed again after doing so. The statistics about each strategy
+    //! are available from Congruence::metrics.
+    //!
+    //! This method only has any effect if used after Congruence::force_tc.
+    void set_tc_strategy(tc_strategy_t val) {
+      if (_data != nullptr) {
+        _data->set_tc_strategy(val);
+      }
+    }
+
+    //! Set the lookahead policy of the HLT strategy of the Todd-Coxeter
+    //! algorithm.
+    //!
+    //! A lookahead phase starts when the number of active cosets exceeds the
+    //! value set by Congruence::set_pack, and uses the policy \p val, which
+    //! defaults to Congruence::TC_LOOKAHEAD_PARTIAL. Afterwards this value is
+    //! raised to \p growth percent more than the larger of its old value and
+    //! the number of active cosets (by default \c 10 percent).
+    //!
+    //! This method only has any effect if used after Congruence::force_tc.
+    void set_tc_lookahead(tc_lookahead_t val, size_t growth = 10) {
+      if (_data != nullptr) {
+        _data->set_tc_lookahead(val, growth);
+      }
+    }
+
+    //! Set the number of threads used by a lookahead phase of the HLT
+    //! strategy of the Todd-Coxeter algorithm.
+    //!
+    //! If \p nr_threads is greater than \c 1, then the relations are traced
+    //! from the cosets in a lookahead phase by \p nr_threads threads, which
+    //! do not modify the coset table, and any coincidences found are then
+    //! processed by a single thread. The default is \c 1, since the
+    //! Todd-Coxeter algorithm may be run at the same time as other methods,
+    //! see Congruence::set_max_threads. The number of threads is not limited
+    //! by the number supported by the hardware.
+    //!
+    //! This method only has any effect if used after Congruence::force_tc.
+    void set_tc_lookahead_threads(size_t nr_threads) {
+      if (_data != nullptr) {
+        _data->set_tc_lookahead_threads(nr_threads);
+      }
+    }
+
+    //! Set the maximum number of bytes used by the coset table of the
+    //! Todd-Coxeter algorithm.
+    //!
+    //! The coset table never shrinks, but the rows of cosets killed by
+    //! coincidences are reused. If defining a coset may soon require a new
+    //! row which would take the table over \p bytes, then a lookahead phase
+    //! is forced, which applies the relations to every coset and does not
+    //! stop early, see Congruence::set_tc_lookahead. If a new row is still
+    //! required, then \c std::bad_alloc is thrown, and the Todd-Coxeter
+    //! algorithm can be continued after this limit is raised. The default
+    //! value \c 0 means there is no limit.
+    //!
+    //! The memory for the coset table, up to \p bytes, is allocated when
+    //! this method is called, so that the table is never reallocated, but
+    //! only the parts of it which are used are resident. When the algorithm
+    //! finishes, the table is compressed into a second table with one row
+    //! per class, which is allocated in addition to the first. If the memory
+    //! for the coset table cannot be allocated, then \c std::bad_alloc is
+    //! thrown by this method.
+    //!
+    //! This method only has any effect if used after Congruence::force_tc.
+    void set_tc_memory_limit(size_t bytes) {
+      if (_data != nullptr) {
+        _data->set_tc_memory_limit(bytes);
+      }
+    }
+
     //! Sets how often the core methods of Congruence report.
     //!
     //! The smaller this value, the more often information will be reported.
@@ -531,6 +704,12 @@ namespace libsemigroups {
       // element of the semigroup defined by word.
       virtual class_index_t word_to_class_index(word_t const& word) = 0;
 
+      // This method puts the metrics specific to the algorithm used into out,
+      // and by default does nothing.
+      virtual void metrics(metrics_t& out) const {
+        (void) out;
+      }
+
       // Possible result of questions that might not be answerable.
       enum result_t { TRUE = 0, FALSE = 1, UNKNOWN = 2 };
 
@@ -599,6 +778,23 @@ namespace libsemigroups {
         (void) val;
       }
 
+      virtual void set_tc_strategy(tc_strategy_t val) {
+        (void) val;
+      }
+
+      virtual void set_tc_lookahead(tc_lookahead_t val, size_t growth) {
+        (void) val;
+        (void) growth;
+      }
+
+      virtual void set_tc_lookahead_threads(size_t nr_threads) {
+        (void) nr_threads;
+      }
+
+      virtual void set_tc_memory_limit(size_t bytes) {
+        (void) bytes;
+      }
+
       void set_report_interval(size_t val) {
         _report_interval = val;
       }
@@ -660,6 +856,7 @@ namespace libsemigroups {
     std::vector<relation_t> _relations;
     std::atomic<bool>       _relations_done;
     Semigroup*              _semigroup;
+    int64_t                 _time_init_relations;
     cong_t                  _type;
 
     static size_t const INFTY;
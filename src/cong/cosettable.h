@@ -0,0 +1,259 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains the layouts which can be used for the coset table of
+// Congruence::TC, and the alias <CosetTable> which selects the layout used.
+//
+// A coset table has one row for every coset and one column for every
+// generator, and stores three values in every position: the image of the
+// coset under the generator, one of its preimages under the generator, and
+// the next preimage of its image under the generator, see tc.cc. A layout
+// provides the methods **nr_rows**, **nr_cols**, **bytes_per_row**,
+// **add_rows**, **reserve** (which takes the total number of rows), **get**
+// and **set** (for the images), **preim_init** and **set_preim_init**, and
+// **preim_next** and **set_preim_next**. Every value in a new row is
+// <UNDEFINED>.
+
+#ifndef LIBSEMIGROUPS_SRC_CONG_COSETTABLE_H_
+#define LIBSEMIGROUPS_SRC_CONG_COSETTABLE_H_
+
+#include <stdint.h>
+
+#include <limits>
+#include <vector>
+
+#include "../libsemigroups-debug.h"
+#include "../recvec.h"
+
+namespace libsemigroups {
+
+  //
+  // Layout which stores the images, first preimages, and next preimages in
+  // three separate <RecVec>s, with the storage policy <GraphStorage>.
+
+  class SplitCosetTable {
+    typedef RecVec<size_t, GraphStorage<size_t>> table_t;
+
+   public:
+    // The value of an undefined position.
+    static size_t const UNDEFINED = std::numeric_limits<size_t>::max();
+
+    explicit SplitCosetTable(size_t nr_cols = 0, size_t nr_rows = 0)
+        : _preim_init(nr_cols, nr_rows, UNDEFINED),
+          _preim_next(nr_cols, nr_rows, UNDEFINED),
+          _table(nr_cols, nr_rows, UNDEFINED) {}
+
+    size_t nr_rows() const {
+      return _table.nr_rows();
+    }
+
+    size_t nr_cols() const {
+      return _table.nr_cols();
+    }
+
+    // This method returns the number of bytes used by a row.
+    size_t bytes_per_row() const {
+      return 3 * nr_cols() * sizeof(size_t);
+    }
+
+    void add_rows(size_t nr = 1) {
+      _table.add_rows(nr);
+      _preim_init.add_rows(nr);
+      _preim_next.add_rows(nr);
+    }
+
+    void reserve(size_t nr_rows) {
+      _table.reserve(nr_rows);
+      _preim_init.reserve(nr_rows);
+      _preim_next.reserve(nr_rows);
+    }
+
+    size_t get(size_t c, size_t i) const {
+      return _table.get(c, i);
+    }
+
+    void set(size_t c, size_t i, size_t val) {
+      _table.set(c, i, val);
+    }
+
+    size_t preim_init(size_t c, size_t i) const {
+      return _preim_init.get(c, i);
+    }
+
+    void set_preim_init(size_t c, size_t i, size_t val) {
+      _preim_init.set(c, i, val);
+    }
+
+    size_t preim_next(size_t c, size_t i) const {
+      return _preim_next.get(c, i);
+    }
+
+    void set_preim_next(size_t c, size_t i, size_t val) {
+      _preim_next.set(c, i, val);
+    }
+
+   private:
+    table_t _preim_init;
+    table_t _preim_next;
+    table_t _table;
+  };
+
+  //
+  // Layout which stores the image, first preimage, and next preimage of a
+  // coset under a generator next to each other, and so the three values for
+  // every generator of one coset are consecutive in memory, in a single
+  // std::vector. The values are stored as 32-bit unsigned integers until a
+  // value which does not fit is set, when every value is converted to a
+  // 64-bit unsigned integer; <UNDEFINED> is stored as the maximum value of
+  // the type used.
+  //
+  // For example, identifying two cosets reads and writes the image and next
+  // preimage in the same position of the table, which are usually in the
+  // same cache line, and half as much memory is used as by <SplitCosetTable>
+  // with 64-bit integers.
+
+  class InterleavedCosetTable {
+   public:
+    // The value of an undefined position.
+    static size_t const UNDEFINED = std::numeric_limits<size_t>::max();
+
+    explicit InterleavedCosetTable(size_t nr_cols = 0, size_t nr_rows = 0)
+        : _nr_cols(nr_cols),
+          _nr_rows(0),
+          _narrow(),
+          _wide(),
+          _is_wide(false) {
+      add_rows(nr_rows);
+    }
+
+    size_t nr_rows() const {
+      return _nr_rows;
+    }
+
+    size_t nr_cols() const {
+      return _nr_cols;
+    }
+
+    // This method returns the number of bytes used by a row.
+    size_t bytes_per_row() const {
+      return 3 * _nr_cols * (_is_wide ? sizeof(size_t) : sizeof(uint32_t));
+    }
+
+    // This method returns true if the values are stored as 64-bit integers.
+    bool is_wide() const {
+      return _is_wide;
+    }
+
+    void add_rows(size_t nr = 1) {
+      _nr_rows += nr;
+      if (_is_wide) {
+        _wide.resize(3 * _nr_cols * _nr_rows,
+                     static_cast<size_t>(UNDEFINED));
+      } else {
+        _narrow.resize(3 * _nr_cols * _nr_rows,
+                       static_cast<uint32_t>(NARROW_UNDEFINED));
+      }
+    }
+
+    void reserve(size_t nr_rows) {
+      if (_is_wide) {
+        _wide.reserve(3 * _nr_cols * nr_rows);
+      } else {
+        _narrow.reserve(3 * _nr_cols * nr_rows);
+      }
+    }
+
+    size_t get(size_t c, size_t i) const {
+      return load(index(c, i));
+    }
+
+    void set(size_t c, size_t i, size_t val) {
+      store(index(c, i), val);
+    }
+
+    size_t preim_init(size_t c, size_t i) const {
+      return load(index(c, i) + 1);
+    }
+
+    void set_preim_init(size_t c, size_t i, size_t val) {
+      store(index(c, i) + 1, val);
+    }
+
+    size_t preim_next(size_t c, size_t i) const {
+      return load(index(c, i) + 2);
+    }
+
+    void set_preim_next(size_t c, size_t i, size_t val) {
+      store(index(c, i) + 2, val);
+    }
+
+   private:
+    static uint32_t const NARROW_UNDEFINED
+        = std::numeric_limits<uint32_t>::max();
+
+    size_t index(size_t c, size_t i) const {
+      LIBSEMIGROUPS_ASSERT(c < _nr_rows && i < _nr_cols);
+      return 3 * (c * _nr_cols + i);
+    }
+
+    size_t load(size_t pos) const {
+      if (_is_wide) {
+        return _wide[pos];
+      }
+      uint32_t const val = _narrow[pos];
+      return (val == NARROW_UNDEFINED ? UNDEFINED : val);
+    }
+
+    void store(size_t pos, size_t val) {
+      if (!_is_wide) {
+        if (val < NARROW_UNDEFINED || val == UNDEFINED) {
+          _narrow[pos] = static_cast<uint32_t>(val);
+          return;
+        }
+        widen();
+      }
+      _wide[pos] = val;
+    }
+
+    // Convert every value to a 64-bit integer.
+    void widen() {
+      _wide.reserve(_narrow.capacity());
+      for (uint32_t val : _narrow) {
+        _wide.push_back(val == NARROW_UNDEFINED ? UNDEFINED : val);
+      }
+      std::vector<uint32_t>().swap(_narrow);
+      _is_wide = true;
+    }
+
+    size_t                _nr_cols;
+    size_t                _nr_rows;
+    std::vector<uint32_t> _narrow;
+    std::vector<size_t>   _wide;
+    bool                  _is_wide;
+  };
+
+  // The layout used by Congruence::TC, which is selected by the configure
+  // option --with-coset-table.
+#if defined(LIBSEMIGROUPS_INTERLEAVED_COSET_TABLES)
+  typedef InterleavedCosetTable CosetTable;
+#else
+  typedef SplitCosetTable CosetTable;
+#endif
+}  // namespace libsemigroups
+
+#endif  // LIBSEMIGROUPS_SRC_CONG_COSETTABLE_H_
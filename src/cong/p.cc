@@ -37,7 +37,7 @@ namespace libsemigroups {
         _done(false),
         _found_pairs(new std::unordered_set<p_pair_const_t, PHash, PEqual>()),
         _lookup(0),
-        _map(),
+        _map(&_reverse_map),
         _map_next(0),
         _next_class(0),
         _pairs_to_mult(new std::queue<p_pair_const_t>()),
@@ -63,9 +63,9 @@ namespace libsemigroups {
 
   Congruence::P::~P() {
     delete_tmp_storage();
-    for (auto& x : _map) {
-      const_cast<Element*>(x.first)->really_delete();
-      delete x.first;
+    for (Element* x : _reverse_map) {
+      x->really_delete();
+      delete x;
     }
   }
 
@@ -191,37 +191,25 @@ namespace libsemigroups {
 
   void Congruence::P::add_pair(Element const* x, Element const* y) {
     if (!(*x == *y)) {
-      Element const *xx = nullptr, *yy = nullptr;
-      p_index_t      i, j;
-
-      auto it_x = _map.find(x);
-      if (it_x == _map.end()) {
-        xx = x->really_copy();
-        i  = add_index(xx);
-      } else {
-        i = it_x->second;
+      bool      is_new = false;
+      p_index_t i      = _map.find(x);
+      if (i == ElementMap<p_index_t>::UNDEFINED) {
+        i      = add_index(x->really_copy());
+        is_new = true;
       }
 
-      auto it_y = _map.find(y);
-      if (it_y == _map.end()) {
-        yy = y->really_copy();
-        j  = add_index(yy);
-      } else {
-        j = it_y->second;
+      p_index_t j = _map.find(y);
+      if (j == ElementMap<p_index_t>::UNDEFINED) {
+        j      = add_index(y->really_copy());
+        is_new = true;
       }
 
       LIBSEMIGROUPS_ASSERT(i != j);
-      p_pair_const_t pair;
-      if (xx != nullptr || yy != nullptr) {  // it's a new pair
-        xx   = (xx == nullptr ? it_x->first : xx);
-        yy   = (yy == nullptr ? it_y->first : yy);
-        pair = (i < j ? p_pair_const_t(xx, yy) : p_pair_const_t(yy, xx));
-      } else {
-        pair = (i < j ? p_pair_const_t(it_x->first, it_y->first)
-                      : p_pair_const_t(it_y->first, it_x->first));
-        if (_found_pairs->find(pair) != _found_pairs->end()) {
-          return;
-        }
+      p_pair_const_t pair
+          = (i < j ? p_pair_const_t(_reverse_map[i], _reverse_map[j])
+                   : p_pair_const_t(_reverse_map[j], _reverse_map[i]));
+      if (!is_new && _found_pairs->find(pair) != _found_pairs->end()) {
+        return;
       }
       _found_pairs->insert(pair);
       _pairs_to_mult->push(pair);
@@ -230,18 +218,18 @@ namespace libsemigroups {
   }
 
   Congruence::P::p_index_t Congruence::P::get_index(Element const* x) {
-    auto it = _map.find(x);
-    if (it == _map.end()) {
+    p_index_t i = _map.find(x);
+    if (i == ElementMap<p_index_t>::UNDEFINED) {
       return add_index(x->really_copy());
     }
-    return it->second;
+    return i;
   }
 
-  Congruence::P::p_index_t Congruence::P::add_index(Element const* x) {
+  Congruence::P::p_index_t Congruence::P::add_index(Element* x) {
     LIBSEMIGROUPS_ASSERT(_reverse_map.size() == _map_next);
     LIBSEMIGROUPS_ASSERT(_map.size() == _map_next);
-    _map.emplace(x, _map_next);
     _reverse_map.push_back(x);
+    _map.insert(x, _map_next);
     _lookup.add_entry();
     if (_done) {
       _class_lookup.push_back(_next_class++);
@@ -294,7 +282,7 @@ namespace libsemigroups {
     Partition<word_t>* classes = new Partition<word_t>(_nr_nontrivial_classes);
 
     for (p_index_t ind = 0; ind < _nr_nontrivial_elms; ind++) {
-      Element* elm  = const_cast<Element*>(_reverse_map[ind]);
+      Element* elm  = _reverse_map[ind];
       word_t*  word = _cong._semigroup->factorisation(elm);
       (*classes)[_class_lookup[ind]]->push_back(word);
     }
@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "../cong.h"
+#include "../elementmap.h"
 #include "../uf.h"
 
 namespace libsemigroups {
@@ -80,20 +81,19 @@ namespace libsemigroups {
     void delete_tmp_storage();
 
     p_index_t get_index(Element const* x);
-    p_index_t add_index(Element const* x);
+    p_index_t add_index(Element* x);
 
     std::vector<class_index_t> _class_lookup;
     bool                       _done;
     std::unordered_set<p_pair_const_t, PHash, PEqual>* _found_pairs;
     UF _lookup;
-    std::unordered_map<const Element*, p_index_t, Element::Hash, Element::Equal>
-                                _map;
+    ElementMap<p_index_t>       _map;
     p_index_t                   _map_next;
     class_index_t               _next_class;
     p_index_t                   _nr_nontrivial_classes;
     p_index_t                   _nr_nontrivial_elms;
     std::queue<p_pair_const_t>* _pairs_to_mult;
-    std::vector<Element const*> _reverse_map;
+    std::vector<Element*>       _reverse_map;
     Element*                    _tmp1;
     Element*                    _tmp2;
   };
@@ -23,6 +23,9 @@
 #include "tc.h"
 
 #include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
 
 #define TC_KILLED                      \
   if (_killed) {                       \
@@ -36,6 +39,25 @@
 
 namespace libsemigroups {
 
+  size_t const SplitCosetTable::UNDEFINED;
+  size_t const InterleavedCosetTable::UNDEFINED;
+  uint32_t const InterleavedCosetTable::NARROW_UNDEFINED;
+
+  // The hybrid strategy switches from HLT to Felsch if, after a lookahead,
+  // fewer than 1 in HYBRID_RATIO of the cosets defined so far are active.
+  static size_t const HYBRID_RATIO = 2;
+
+  // A parallel lookahead traces the relations from at most
+  // LOOKAHEAD_ROUND_SIZE cosets before processing the coincidences found,
+  // and each thread takes LOOKAHEAD_CHUNK_SIZE of these cosets at a time.
+  static size_t const LOOKAHEAD_ROUND_SIZE = 65536;
+  static size_t const LOOKAHEAD_CHUNK_SIZE = 1024;
+
+  // If one call to identify_cosets kills more than 1 in DEFER_REWRITE_RATIO
+  // of the active cosets, then it stops updating the preimages of the killed
+  // cosets, and rewrites the whole table once at the end instead.
+  static size_t const DEFER_REWRITE_RATIO = 16;
+
   // COSET LISTS:
   //
   // We use these two arrays to simulate a doubly-linked list of active
@@ -49,6 +71,8 @@ namespace libsemigroups {
   // with.  To indicate this alternative use of the list, the entry is
   // negated
   // (_backwd[c] == -3 indicates that c was identified with coset 3).
+  // These forwarding addresses form a forest whose roots are the active
+  // cosets, and find_coset shortens the paths in it as it follows them.
 
   // We also store some special locations in the list:
   //   _current is the coset to which we are currently applying relations.
@@ -60,51 +84,97 @@ namespace libsemigroups {
 
   // COSET TABLES:
   //
-  // We use these three tables to store all a coset's images and preimages.
-  //   _table[c][i] is coset c's image under generator i.
-  //   _preim_init[c][i] is ONE of coset c's preimages under generator i.
-  //   _preim_next[c][i] is a coset that has THE SAME IMAGE as coset c
-  //   (under
-  //   i)
+  // We use _table to store all a coset's images and preimages.
+  //   _table.get(c, i) is coset c's image under generator i.
+  //   _table.preim_init(c, i) is ONE of coset c's preimages under generator
+  //   i.
+  //   _table.preim_next(c, i) is a coset that has THE SAME IMAGE as coset c
+  //   (under i).
   //
   // Hence to find all the preimages of c under i:
-  //   - Let u = _preim_init[c][i] ONCE.
-  //   - Let u = _preim_next[u][i] REPEATEDLY until it becomes UNDEFINED.
+  //   - Let u = _table.preim_init(c, i) ONCE.
+  //   - Let u = _table.preim_next(u, i) REPEATEDLY until it becomes
+  //   UNDEFINED.
   // Each u is one preimage.
   //
   // To add v, a new preimage of c under i:
-  //   - Set _preim_next[v][i] to point to the current _preim_init[c][i].
-  //   - Then change _preim_init[c][i] to point to v.
+  //   - Set _table.preim_next(v, i) to the current _table.preim_init(c, i).
+  //   - Then change _table.preim_init(c, i) to v.
   // Now the new preimage and all the old preimages are stored.
+  //
+  // How these values are stored is determined by the layout CosetTable, see
+  // cosettable.h.
+
+  // STRATEGIES:
+  //
+  // The HLT strategy applies every relation to _current, defining new cosets
+  // whenever necessary, and then moves _current on to the next active coset.
+  // Every coset before _current is one at which every relation holds. When
+  // there are more than _pack active cosets, the relations are applied to
+  // cosets without defining new cosets (a "lookahead") to find coincidences.
+  //
+  // The Felsch strategy defines the image of _current under every generator
+  // in turn. Whenever an entry of the table is set or changed, the pair
+  // (coset, generator) is pushed onto _deductions; every relation is then
+  // applied, without defining new cosets, to every coset whose trace passes
+  // through that entry, which is found by following the preimages. Hence
+  // far fewer cosets are defined than by HLT, but each definition is more
+  // expensive.
 
   Congruence::TC::TC(Congruence& cong)
       : DATA(cong, 1000, 2000000),
         _active(1),
         _already_reported_killed(false),
         _bckwd(1, 0),
+        _coincidences(),
         _cosets_killed(0),
         _current(0),
         _current_no_add(UNDEFINED),
         _defined(1),
+        _deductions(),
         _extra(),
+        _felsch(false),
+        _forced_lookahead_active(0),
         _forwd(1, UNDEFINED),
         _id_coset(0),
         _init_done(false),
         _last(0),
+        _lookahead(TC_LOOKAHEAD_PARTIAL),
+        _lookahead_growth(10),
+        _lookahead_threads(1),
+        _max_new_cosets(0),
+        _memory_limit(0),
         _next(UNDEFINED),
+        _nr_deductions(0),
+        _nr_lookahead_killed(0),
+        _nr_lookaheads(0),
+        _nr_table_rewrites(0),
         _pack(120000),
         _prefilled(false),
-        _preim_init(cong._nrgens, 1, UNDEFINED),
-        _preim_next(cong._nrgens, 1, UNDEFINED),
+        _relations_done(false),
         _stop_packing(false),
-        _table(cong._nrgens, 1, UNDEFINED),
-        _tc_done(false) {}
+        _strategy(TC_HLT),
+        _table(cong._nrgens, 1),
+        _tc_done(false),
+        _felsch_cosets(),
+        _felsch_stack(),
+        _occurrences() {}
 
   void Congruence::TC::init() {
     if (!_init_done) {
-      // This is the first run
-      init_tc_relations();
-      // Apply each "extra" relation to the first coset only
+      // This is the first run, or the previous run was interrupted by
+      // new_coset throwing std::bad_alloc while tracing the extra relations.
+      if (!_relations_done) {
+        init_tc_relations();
+        // Applying every relation to one coset defines at most this many
+        // cosets
+        for (relation_t const& rel : _relations) {
+          _max_new_cosets += rel.first.size() + rel.second.size() - 2;
+        }
+        _relations_done = true;
+      }
+      // Apply each "extra" relation to the first coset only, which can be
+      // repeated safely
       for (relation_t const& rel : _extra) {
         trace(_id_coset, rel);  // Allow new cosets
       }
@@ -117,14 +187,16 @@ namespace libsemigroups {
     if (semigroup == nullptr) {
       return;
     }
-    if (_cong._type == LEFT) {
-      _table.append(*semigroup->left_cayley_graph());
-    } else {
-      _table.append(*semigroup->right_cayley_graph());
-    }
+    Semigroup::cayley_graph_t const* graph
+        = (_cong._type == LEFT ? semigroup->left_cayley_graph()
+                               : semigroup->right_cayley_graph());
     TC_KILLED
-    for (auto it = _table.begin(); it < _table.end(); it++) {
-      (*it)++;
+    // Coset i + 1 corresponds to element i of the semigroup
+    _table.add_rows(graph->nr_rows());
+    for (size_t i = 0; i < graph->nr_rows(); i++) {
+      for (size_t j = 0; j < graph->nr_cols(); j++) {
+        _table.set(i + 1, j, graph->get(i, j) + 1);
+      }
     }
     TC_KILLED
     for (size_t i = 0; i < _cong._nrgens; i++) {
@@ -139,7 +211,12 @@ namespace libsemigroups {
     LIBSEMIGROUPS_ASSERT(table.nr_cols() == _cong._nrgens);
     LIBSEMIGROUPS_ASSERT(table.nr_rows() > 0);
 
-    _table = table;
+    _table = CosetTable(table.nr_cols(), table.nr_rows());
+    for (size_t i = 0; i < table.nr_rows(); i++) {
+      for (size_t j = 0; j < table.nr_cols(); j++) {
+        _table.set(i, j, table.get(i, j));
+      }
+    }
     init_after_prefill();
   }
 
@@ -163,14 +240,11 @@ namespace libsemigroups {
 
     _last = _active - 1;
 
-    _preim_init.add_rows(_table.nr_rows());
-    _preim_next.add_rows(_table.nr_rows());
-
     for (class_index_t c = 0; c < _active; c++) {
       for (letter_t i = 0; i < _cong._nrgens; i++) {
         class_index_t b = _table.get(c, i);
-        _preim_next.set(c, i, _preim_init.get(b, i));
-        _preim_init.set(b, i, c);
+        _table.set_preim_next(c, i, _table.preim_init(b, i));
+        _table.set_preim_init(b, i, c);
       }
       // TC_KILLED?
     }
@@ -179,7 +253,7 @@ namespace libsemigroups {
 
   void Congruence::TC::init_tc_relations() {
     // This should not have been run before
-    LIBSEMIGROUPS_ASSERT(!_init_done);
+    LIBSEMIGROUPS_ASSERT(!_init_done && !_relations_done);
 
     // Handle _extra first!
     switch (_cong._type) {
@@ -213,6 +287,7 @@ namespace libsemigroups {
     _cong.init_relations(_cong._semigroup, _killed);
 
     // Must insert at _relations.end() since it might be non-empty
+    _relations.reserve(_relations.size() + _cong._relations.size());
     _relations.insert(
         _relations.end(), _cong._relations.begin(), _cong._relations.end());
     // FIXME avoid copying in the RIGHT case
@@ -239,7 +314,7 @@ namespace libsemigroups {
       return;
     }
 
-    RecVec<class_index_t> table(_cong._nrgens, _active);
+    CosetTable table(_cong._nrgens, _active);
 
     class_index_t pos = _id_coset;
     // old number to new numbers lookup
@@ -331,6 +406,16 @@ namespace libsemigroups {
   void Congruence::TC::new_coset(class_index_t const& c, letter_t const& a) {
     TC_KILLED
 
+    if (_next == UNDEFINED && _memory_limit != 0
+        && _forwd.size() >= max_cosets()) {
+      // Nothing has been changed, so that this can be continued if the limit
+      // is raised
+      REPORT("memory limit of " << _memory_limit << " bytes reached with "
+                                << _active
+                                << " active cosets");
+      throw std::bad_alloc();
+    }
+
     _active++;
     _defined++;
     _report_next++;
@@ -342,8 +427,6 @@ namespace libsemigroups {
       _forwd.push_back(UNDEFINED);
       _bckwd.push_back(_last);
       _table.add_rows();
-      _preim_init.add_rows();
-      _preim_next.add_rows();
     } else {
       _bckwd[_next] = _last;
     }
@@ -355,45 +438,65 @@ namespace libsemigroups {
     // Clear the new coset's row in each table
     for (letter_t i = 0; i < _cong._nrgens; i++) {
       _table.set(_last, i, UNDEFINED);
-      _preim_init.set(_last, i, UNDEFINED);
+      _table.set_preim_init(_last, i, UNDEFINED);
     }
 
     // Set the new coset as the image of c under a
     _table.set(c, a, _last);
+    push_deduction(c, a);
 
     // Set c as the one preimage of the new coset
-    _preim_init.set(_last, a, c);
-    _preim_next.set(c, a, UNDEFINED);
+    _table.set_preim_init(_last, a, c);
+    _table.set_preim_next(c, a, UNDEFINED);
+  }
+
+  // Returns the active coset which <c> has been identified with, and makes
+  // the forwarding address of every coset on the way point to it.
+  Congruence::class_index_t Congruence::TC::find_coset(class_index_t c) {
+    class_index_t root = c;
+    while (_bckwd[root] < 0) {
+      root = -_bckwd[root];
+    }
+    while (_bckwd[c] < 0) {
+      class_index_t next = -_bckwd[c];
+      _bckwd[c]          = -static_cast<signed_class_index_t>(root);
+      c                  = next;
+    }
+    return root;
   }
 
   // Identify lhs with rhs, and process any further coincidences
   void Congruence::TC::identify_cosets(class_index_t lhs, class_index_t rhs) {
     TC_KILLED
 
-    // Note that _lhs_stack and _rhs_stack may not be empty, if this was killed
-    // before and has been restarted.
+    // Note that _coincidences may not be empty, if this was killed before and
+    // has been restarted.
 
-    // Make sure lhs < rhs
     if (lhs == rhs) {
       return;
-    } else if (rhs < lhs) {
-      class_index_t tmp = lhs;
-      lhs               = rhs;
-      rhs               = tmp;
     }
 
+    // If more than <max_eager> cosets are killed by this call, then we stop
+    // updating the preimages, and rewrite the table in one pass at the end.
+    size_t const max_eager = _active / DEFER_REWRITE_RATIO + 1;
+    size_t       nr_killed = 0;
+    bool         deferred  = false;
+
     while (!_killed) {
-      // If <lhs> is not active, use the coset it was identified with
-      while (_bckwd[lhs] < 0) {
-        lhs = -_bckwd[lhs];
-      }
-      // Same with <rhs>
-      while (_bckwd[rhs] < 0) {
-        rhs = -_bckwd[rhs];
+      // If <lhs> or <rhs> is not active, use the coset it was identified with
+      lhs = find_coset(lhs);
+      rhs = find_coset(rhs);
+      // Make sure lhs < rhs, so that every forwarding address is less than
+      // the coset it belongs to, and the identity coset is never killed.
+      if (rhs < lhs) {
+        std::swap(lhs, rhs);
       }
 
       if (lhs != rhs) {
         _active--;
+        if (!deferred && ++nr_killed > max_eager) {
+          deferred = true;
+        }
         // If any "controls" point to <rhs>, move them back one in the list
         if (rhs == _current) {
           _current = _bckwd[_current];
@@ -421,14 +524,30 @@ namespace libsemigroups {
         _bckwd[rhs] = -static_cast<signed_class_index_t>(lhs);
 
         for (letter_t i = 0; i < _cong._nrgens; i++) {
+          if (deferred) {
+            // The entries equal to <rhs>, and the preimages, are fixed by
+            // rewrite_table
+            class_index_t const v = _table.get(rhs, i);
+            if (v != UNDEFINED) {
+              class_index_t const u = _table.get(lhs, i);
+              if (u == UNDEFINED) {
+                _table.set(lhs, i, v);
+                push_deduction(lhs, i);
+              } else {
+                _coincidences.emplace_back(u, v);
+              }
+            }
+            continue;
+          }
           // Let <v> be the first PREIMAGE of <rhs>
-          class_index_t v = _preim_init.get(rhs, i);
+          class_index_t v = _table.preim_init(rhs, i);
           while (v != UNDEFINED) {
             _table.set(v, i, lhs);  // Replace <rhs> by <lhs> in the table
+            push_deduction(v, i);
             class_index_t u
-                = _preim_next.get(v, i);  // Get <rhs>'s next preimage
-            _preim_next.set(v, i, _preim_init.get(lhs, i));
-            _preim_init.set(lhs, i, v);
+                = _table.preim_next(v, i);  // Get <rhs>'s next preimage
+            _table.set_preim_next(v, i, _table.preim_init(lhs, i));
+            _table.set_preim_init(lhs, i, v);
             // v is now a preimage of <lhs>, not <rhs>
             v = u;  // Let <v> be <rhs>'s next preimage, and repeat
           }
@@ -436,46 +555,75 @@ namespace libsemigroups {
           // Now let <v> be the IMAGE of <rhs>
           v = _table.get(rhs, i);
           if (v != UNDEFINED) {
-            class_index_t u = _preim_init.get(v, i);
+            class_index_t u = _table.preim_init(v, i);
             LIBSEMIGROUPS_ASSERT(u != UNDEFINED);
             if (u == rhs) {
               // Remove <rhs> from the start of the list of <v>'s preimages
-              _preim_init.set(v, i, _preim_next.get(rhs, i));
+              _table.set_preim_init(v, i, _table.preim_next(rhs, i));
             } else {
               // Go through all <v>'s preimages until we find <rhs>
-              while (_preim_next.get(u, i) != rhs) {
-                u = _preim_next.get(u, i);
+              while (_table.preim_next(u, i) != rhs) {
+                u = _table.preim_next(u, i);
               }
               // Remove <rhs> from the list of <v>'s preimages
-              _preim_next.set(u, i, _preim_next.get(rhs, i));
+              _table.set_preim_next(u, i, _table.preim_next(rhs, i));
             }
 
             // Let <u> be the image of <lhs>, and ensure <u> = <v>
             u = _table.get(lhs, i);
             if (u == UNDEFINED) {
               _table.set(lhs, i, v);
-              _preim_next.set(lhs, i, _preim_init.get(v, i));
-              _preim_init.set(v, i, lhs);
+              push_deduction(lhs, i);
+              _table.set_preim_next(lhs, i, _table.preim_init(v, i));
+              _table.set_preim_init(v, i, lhs);
             } else {
               // Add (u,v) to the stack of pairs to be identified
-              _lhs_stack.push(std::min(u, v));
-              _rhs_stack.push(std::max(u, v));
+              _coincidences.emplace_back(u, v);
             }
           }
         }
       }
-      if (_lhs_stack.empty()) {
-        LIBSEMIGROUPS_ASSERT(_rhs_stack.empty());
+      if (_coincidences.empty()) {
         break;
       }
       // Get the next pair to be identified
-      lhs = _lhs_stack.top();
-      _lhs_stack.pop();
-      rhs = _rhs_stack.top();
-      _rhs_stack.pop();
+      lhs = _coincidences.back().first;
+      rhs = _coincidences.back().second;
+      _coincidences.pop_back();
+    }
+
+    if (deferred) {
+      rewrite_table();
     }
+    LIBSEMIGROUPS_ASSERT(_coincidences.empty() || _killed);
+  }
 
-    LIBSEMIGROUPS_ASSERT((_lhs_stack.empty() && _rhs_stack.empty()) || _killed);
+  // Replace every entry of the table of an active coset by the active coset
+  // it has been identified with, and recompute the preimages. This is used
+  // by identify_cosets once many cosets have been killed, since it is then
+  // cheaper than updating the preimages of every killed coset.
+  void Congruence::TC::rewrite_table() {
+    REPORT("rewriting the table with " << _active << " active cosets");
+    _nr_table_rewrites++;
+    for (class_index_t c = _id_coset; c != _next; c = _forwd[c]) {
+      for (letter_t i = 0; i < _cong._nrgens; i++) {
+        _table.set_preim_init(c, i, UNDEFINED);
+      }
+    }
+    for (class_index_t c = _id_coset; c != _next; c = _forwd[c]) {
+      for (letter_t i = 0; i < _cong._nrgens; i++) {
+        class_index_t v = _table.get(c, i);
+        if (v != UNDEFINED) {
+          if (_bckwd[v] < 0) {
+            v = find_coset(v);
+            _table.set(c, i, v);
+            push_deduction(c, i);
+          }
+          _table.set_preim_next(c, i, _table.preim_init(v, i));
+          _table.set_preim_init(v, i, c);
+        }
+      }
+    }
   }
 
   // Take the two words of the relation <rel>, apply them both to the coset
@@ -541,12 +689,13 @@ namespace libsemigroups {
         // Create a new coset and set both lhs^a and rhs^b to it
         new_coset(lhs, a);
         _table.set(rhs, b, _last);
+        push_deduction(rhs, b);
         if (a == b) {
-          _preim_next.set(lhs, a, rhs);
-          _preim_next.set(rhs, a, UNDEFINED);
+          _table.set_preim_next(lhs, a, rhs);
+          _table.set_preim_next(rhs, a, UNDEFINED);
         } else {
-          _preim_init.set(_last, b, rhs);
-          _preim_next.set(rhs, b, UNDEFINED);
+          _table.set_preim_init(_last, b, rhs);
+          _table.set_preim_next(rhs, b, UNDEFINED);
         }
       } else {
         return;  // Packing phase: do nothing
@@ -554,13 +703,15 @@ namespace libsemigroups {
     } else if (u == UNDEFINED && v != UNDEFINED) {
       // Set lhs^a to v
       _table.set(lhs, a, v);
-      _preim_next.set(lhs, a, _preim_init.get(v, a));
-      _preim_init.set(v, a, lhs);
+      push_deduction(lhs, a);
+      _table.set_preim_next(lhs, a, _table.preim_init(v, a));
+      _table.set_preim_init(v, a, lhs);
     } else if (u != UNDEFINED && v == UNDEFINED) {
       // Set rhs^b to u
       _table.set(rhs, b, u);
-      _preim_next.set(rhs, b, _preim_init.get(u, b));
-      _preim_init.set(u, b, rhs);
+      push_deduction(rhs, b);
+      _table.set_preim_next(rhs, b, _table.preim_init(u, b));
+      _table.set_preim_init(u, b, rhs);
     } else {
       // lhs^a and rhs^b are both defined
       identify_cosets(u, v);
@@ -585,53 +736,73 @@ namespace libsemigroups {
       return;
     }
 
+    if (_strategy == TC_FELSCH && !_felsch) {
+      start_felsch();
+    } else if (_strategy == TC_HLT && _felsch) {
+      // The relations may not hold at cosets before _current, since the
+      // deductions are no longer processed, and so we start again.
+      _felsch = false;
+      _deductions.clear();
+      _current = _id_coset;
+    }
+
     // Run a batch
     REPORT("number of steps: " << _steps);
-    do {
-      // Apply each relation to the "_current" coset
-      for (relation_t const& rel : _relations) {
-        trace(_current, rel);  // Allow new cosets
-      }
+    if (!_felsch) {
+      do {
+        // If the rows of the table may soon run out, then try to free some
+        if (near_memory_limit()) {
+          REPORT("forcing a lookahead, since the memory limit is near");
+          lookahead(TC_LOOKAHEAD_FULL, false);
+          _forced_lookahead_active = _active;
+        }
 
-      // If the number of active cosets is too high, start a packing phase
-      if (_active > _pack) {
-        REPORT(_defined << " defined, " << _forwd.size() << " max, " << _active
-                        << " active, "
-                        << (_defined - _active) - _cosets_killed
-                        << " killed, "
-                        << "current "
-                        << _current);
-        REPORT("Entering lookahead phase . . .");
-        _cosets_killed = _defined - _active;
-
-        size_t oldactive = _active;       // Keep this for stats
-        _current_no_add  = _current + 1;  // Start packing from _current
-
-        do {
-          // Apply every relation to the "_current_no_add" coset
-          for (relation_t const& rel : _relations) {
-            trace(_current_no_add, rel, false);  // Don't allow new cosets
+        // Apply each relation to the "_current" coset
+        for (relation_t const& rel : _relations) {
+          trace(_current, rel);  // Allow new cosets
+        }
+
+        // If the number of active cosets is too high, start a packing phase
+        if (_active > _pack) {
+          if (_lookahead != TC_LOOKAHEAD_NONE) {
+            lookahead(_lookahead, true);
+          }
+          if (_strategy == TC_HYBRID && _active * HYBRID_RATIO < _defined) {
+            REPORT("switching to Felsch with " << _active << " active, "
+                                               << _defined
+                                               << " defined");
+            start_felsch();
+            break;
           }
-          _current_no_add = _forwd[_current_no_add];
+          size_t const pack = std::max(_pack, _active);
+          _pack             = pack + (pack * _lookahead_growth) / 100;
+        }
 
-          // Quit loop if we reach an inactive coset OR we get a "stop" signal
-          TC_KILLED
-        } while (_current_no_add != _next && !_stop_packing);
+        // Move onto the next coset
+        _current = _forwd[_current];
 
-        REPORT("Entering lookahead complete " << oldactive - _active
-                                              << " killed");
+        // Quit loop when we reach an inactive coset
+        TC_KILLED
+      } while (_current != _next && --_steps > 0);
+    }
 
-        _pack += _pack / 10;  // Raise packing threshold 10%
-        _stop_packing   = false;
-        _current_no_add = UNDEFINED;
-      }
+    if (_felsch && !_killed) {
+      do {
+        // Define the image of the "_current" coset under every generator
+        for (letter_t a = 0; a < _cong._nrgens; a++) {
+          if (_table.get(_current, a) == UNDEFINED) {
+            new_coset(_current, a);
+            process_deductions();
+          }
+        }
 
-      // Move onto the next coset
-      _current = _forwd[_current];
+        // Move onto the next coset
+        _current = _forwd[_current];
 
-      // Quit loop when we reach an inactive coset
-      TC_KILLED
-    } while (_current != _next && --_steps > 0);
+        // Quit loop when we reach an inactive coset
+        TC_KILLED
+      } while (_current != _next && --_steps > 0);
+    }
 
     // Final report
     REPORT("stopping with " << _defined << " cosets defined,"
@@ -639,8 +810,12 @@ namespace libsemigroups {
                             << _forwd.size()
                             << ", "
                             << _active
-                            << " survived");
-    if (_current == _next) {
+                            << " survived, "
+                            << _nr_lookaheads
+                            << " lookaheads, "
+                            << _nr_deductions
+                            << " deductions");
+    if (_current == _next && _deductions.empty()) {
       _tc_done = true;
       compress();
       REPORT("finished!");
@@ -649,4 +824,245 @@ namespace libsemigroups {
     // No return value: all info is now stored in the class
   }
 
+  // Memory for all the rows which fit in the limit is allocated now, so that
+  // the table and coset lists are never reallocated, which would use up to
+  // twice as much memory as they require. The pages of the unused rows are
+  // not touched, and so they are not resident.
+  void Congruence::TC::set_tc_memory_limit(size_t bytes) {
+    _memory_limit = bytes;
+    if (_memory_limit != 0) {
+      size_t const nr = max_cosets();
+      _table.reserve(nr);
+      _forwd.reserve(nr);
+      _bckwd.reserve(nr);
+    }
+  }
+
+  // Returns the number of cosets whose rows fit in _memory_limit bytes, if
+  // it is not 0.
+  size_t Congruence::TC::max_cosets() const {
+    return _memory_limit
+           / (_table.bytes_per_row() + sizeof(class_index_t)
+              + sizeof(signed_class_index_t));
+  }
+
+  // Returns true if applying the relations to the next coset might require
+  // more rows than fit in _memory_limit bytes, and so a lookahead should be
+  // forced. A lookahead is only forced again once the number of active
+  // cosets has grown by as much as one coset can define, since otherwise
+  // the previous lookahead would be repeated for little benefit.
+  bool Congruence::TC::near_memory_limit() const {
+    return _memory_limit != 0 && _active + _max_new_cosets > max_cosets()
+           && _active >= _forced_lookahead_active + _max_new_cosets;
+  }
+
+  // Apply the relations to the cosets after _current (or to every coset),
+  // without defining any new cosets, until the end of the active list is
+  // reached or, if <stop_early> is true, cosets are being killed too slowly.
+  void Congruence::TC::lookahead(tc_lookahead_t policy, bool stop_early) {
+    REPORT(_defined << " defined, " << _forwd.size() << " max, " << _active
+                    << " active, "
+                    << (_defined - _active) - _cosets_killed
+                    << " killed, "
+                    << "current "
+                    << _current);
+    REPORT("Entering lookahead phase . . .");
+    _cosets_killed = _defined - _active;
+    _stop_packing  = false;
+
+    size_t oldactive = _active;  // Keep this for stats
+    _current_no_add
+        = (policy == TC_LOOKAHEAD_FULL ? _id_coset : _forwd[_current]);
+
+    if (_lookahead_threads > 1) {
+      parallel_lookahead(stop_early);
+    } else {
+      while (_current_no_add != _next && !(stop_early && _stop_packing)
+             && !_killed) {
+        // Apply every relation to the "_current_no_add" coset
+        for (relation_t const& rel : _relations) {
+          trace(_current_no_add, rel, false);  // Don't allow new cosets
+        }
+        _current_no_add = _forwd[_current_no_add];
+
+        // Quit loop if we reach an inactive coset OR we get a "stop" signal
+        TC_KILLED
+      }
+    }
+
+    _nr_lookaheads++;
+    _nr_lookahead_killed += oldactive - _active;
+    REPORT("Lookahead complete " << oldactive - _active << " killed");
+
+    _stop_packing   = false;
+    _current_no_add = UNDEFINED;
+  }
+
+  // The same as the loop in lookahead, except that the relations are traced
+  // from a round of cosets by several threads, which only record the pairs
+  // (coset, relation) where trace would change the table. These are then
+  // traced by this thread, in the same order as the cosets, and so the
+  // result does not depend on the number of threads.
+  void Congruence::TC::parallel_lookahead(bool stop_early) {
+    std::vector<class_index_t> cosets;
+    std::vector<std::vector<std::pair<class_index_t, size_t>>> found;
+
+    while (_current_no_add != _next && !(stop_early && _stop_packing)
+           && !_killed) {
+      cosets.clear();
+      for (class_index_t c = _current_no_add;
+           c != _next && cosets.size() < LOOKAHEAD_ROUND_SIZE;
+           c = _forwd[c]) {
+        cosets.push_back(c);
+      }
+      size_t const nr_chunks
+          = (cosets.size() + LOOKAHEAD_CHUNK_SIZE - 1) / LOOKAHEAD_CHUNK_SIZE;
+      found.resize(nr_chunks);
+
+      std::atomic<size_t> next_chunk(0);
+      auto                func = [this, &cosets, &found, &next_chunk]() {
+        size_t k;
+        while ((k = next_chunk++) < found.size() && !_killed) {
+          found[k].clear();
+          size_t const last
+              = std::min((k + 1) * LOOKAHEAD_CHUNK_SIZE, cosets.size());
+          for (size_t i = k * LOOKAHEAD_CHUNK_SIZE; i < last; i++) {
+            for (size_t j = 0; j < _relations.size(); j++) {
+              if (trace_changes(cosets[i], _relations[j])) {
+                found[k].emplace_back(cosets[i], j);
+              }
+            }
+          }
+        }
+      };
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < std::min(_lookahead_threads, nr_chunks); i++) {
+        threads.push_back(std::thread(func));
+      }
+      for (std::thread& t : threads) {
+        t.join();
+      }
+      TC_KILLED
+      if (_killed) {
+        break;
+      }
+
+      // identify_cosets moves _current_no_add back if it is killed
+      _current_no_add     = cosets.back();
+      size_t const active = _active;
+      for (auto const& chunk : found) {
+        for (auto const& x : chunk) {
+          if (_bckwd[x.first] >= 0) {
+            trace(x.first, _relations[x.second], false);
+          }
+        }
+      }
+      _current_no_add = _forwd[_current_no_add];
+
+      // If we are killing cosets more slowly than the serial lookahead would
+      // allow, then stop packing
+      if ((active - _active) * _report_interval
+          < 100 * cosets.size() * _relations.size()) {
+        _stop_packing = true;
+      }
+      TC_KILLED
+    }
+  }
+
+  // Returns true if trace(c, rel, false) would change the table, without
+  // changing anything, so that this can be called by several threads.
+  bool Congruence::TC::trace_changes(class_index_t     c,
+                                     relation_t const& rel) const {
+    class_index_t lhs = c;
+    for (auto it = rel.first.cbegin(); it < rel.first.cend() - 1; it++) {
+      lhs = _table.get(lhs, *it);
+      if (lhs == UNDEFINED) {
+        return false;
+      }
+    }
+    class_index_t rhs = c;
+    for (auto it = rel.second.cbegin(); it < rel.second.cend() - 1; it++) {
+      rhs = _table.get(rhs, *it);
+      if (rhs == UNDEFINED) {
+        return false;
+      }
+    }
+    // If both are UNDEFINED, then trace does nothing
+    return _table.get(lhs, rel.first.back())
+           != _table.get(rhs, rel.second.back());
+  }
+
+  // Start using the Felsch strategy. The entries of the table which were
+  // defined before now were never pushed onto _deductions, and so we apply
+  // every relation to every coset once, without defining any new cosets.
+  void Congruence::TC::start_felsch() {
+    _felsch = true;
+    if (_occurrences.empty()) {
+      _occurrences.resize(_cong._nrgens);
+      for (size_t i = 0; i < _relations.size(); i++) {
+        for (size_t k = 0; k < _relations[i].first.size(); k++) {
+          _occurrences[_relations[i].first[k]].emplace_back(2 * i, k);
+        }
+        for (size_t k = 0; k < _relations[i].second.size(); k++) {
+          _occurrences[_relations[i].second[k]].emplace_back(2 * i + 1, k);
+        }
+      }
+    }
+
+    _current_no_add = _id_coset;
+    while (_current_no_add != _next && !_killed) {
+      for (relation_t const& rel : _relations) {
+        trace(_current_no_add, rel, false);  // Don't allow new cosets
+      }
+      _current_no_add = _forwd[_current_no_add];
+    }
+    _current_no_add = UNDEFINED;
+    _current        = _id_coset;
+    process_deductions();
+  }
+
+  // Apply every relation, without defining any new cosets, to every coset
+  // whose trace passes through an entry of the table on the deduction stack.
+  void Congruence::TC::process_deductions() {
+    while (!_deductions.empty() && !_killed) {
+      class_index_t const c = _deductions.back().first;
+      letter_t const      a = _deductions.back().second;
+      _deductions.pop_back();
+      if (_bckwd[c] < 0) {
+        continue;  // <c> is no longer active
+      }
+      _nr_deductions++;
+
+      for (auto const& occ : _occurrences[a]) {
+        relation_t const& rel = _relations[occ.first / 2];
+        word_t const&     w = (occ.first % 2 == 0 ? rel.first : rel.second);
+
+        // Find every coset <x> such that <c> is the image of <x> under the
+        // first <occ.second> letters of <w>.
+        _felsch_cosets.clear();
+        _felsch_stack.emplace_back(c, occ.second);
+        while (!_felsch_stack.empty()) {
+          class_index_t const x = _felsch_stack.back().first;
+          size_t const        k = _felsch_stack.back().second;
+          _felsch_stack.pop_back();
+          if (k == 0) {
+            _felsch_cosets.push_back(x);
+          } else {
+            letter_t const b = w[k - 1];
+            for (class_index_t y = _table.preim_init(x, b); y != UNDEFINED;
+                 y               = _table.preim_next(y, b)) {
+              _felsch_stack.emplace_back(y, k - 1);
+            }
+          }
+        }
+
+        for (class_index_t const x : _felsch_cosets) {
+          if (_bckwd[x] >= 0) {
+            trace(x, rel, false);  // Don't allow new cosets
+          }
+        }
+      }
+    }
+  }
+
 }  // namespace libsemigroups
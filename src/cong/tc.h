@@ -23,15 +23,23 @@
 #ifndef LIBSEMIGROUPS_SRC_CONG_TC_H_
 #define LIBSEMIGROUPS_SRC_CONG_TC_H_
 
-#include <stack>
+#include <utility>
 #include <vector>
 
 #include "../cong.h"
+#include "cosettable.h"
 
 namespace libsemigroups {
 
   class Congruence::TC : public Congruence::DATA {
     typedef int64_t signed_class_index_t;
+    // The type of the entries of the deduction stack used by the Felsch
+    // strategy: the image of the first component under the second has been
+    // set or changed.
+    typedef std::pair<class_index_t, letter_t> deduction_t;
+    // The type of the entries of the stack of pairs of cosets which are to be
+    // identified.
+    typedef std::pair<class_index_t, class_index_t> coincidence_t;
 
    public:
     explicit TC(Congruence& cong);
@@ -62,40 +70,103 @@ namespace libsemigroups {
       _pack = val;
     }
 
+    void set_tc_strategy(tc_strategy_t val) override {
+      _strategy = val;
+    }
+
+    void set_tc_lookahead(tc_lookahead_t val, size_t growth) override {
+      _lookahead        = val;
+      _lookahead_growth = growth;
+    }
+
+    void set_tc_lookahead_threads(size_t nr_threads) override {
+      _lookahead_threads = (nr_threads == 0 ? 1 : nr_threads);
+    }
+
+    void set_tc_memory_limit(size_t bytes) override;
+
+    void metrics(metrics_t& out) const override {
+      out.nr_cosets_defined   = _defined;
+      out.nr_cosets_active    = _active;
+      out.nr_cosets_killed    = _defined - _active;
+      out.nr_cosets_max       = _forwd.size();
+      out.nr_lookaheads       = _nr_lookaheads;
+      out.nr_lookahead_killed = _nr_lookahead_killed;
+      out.nr_deductions       = _nr_deductions;
+      out.nr_table_rewrites   = _nr_table_rewrites;
+      out.tc_felsch           = _felsch;
+    }
+
    private:
     void init();
     void init_after_prefill();
     void init_tc_relations();
 
-    void        new_coset(class_index_t const&, letter_t const&);
-    void        identify_cosets(class_index_t, class_index_t);
+    void          new_coset(class_index_t const&, letter_t const&);
+    void          identify_cosets(class_index_t, class_index_t);
+    class_index_t find_coset(class_index_t);
+    void          rewrite_table();
     inline void trace(class_index_t const&, relation_t const&, bool add = true);
+    bool        trace_changes(class_index_t, relation_t const&) const;
+
+    void   lookahead(tc_lookahead_t, bool);
+    void   parallel_lookahead(bool);
+    void   start_felsch();
+    void   process_deductions();
+    bool   near_memory_limit() const;
+    size_t max_cosets() const;
+
+    // Record that the image of c under a has been set or changed, if we are
+    // using the Felsch strategy.
+    inline void push_deduction(class_index_t c, letter_t a) {
+      if (_felsch) {
+        _deductions.emplace_back(c, a);
+      }
+    }
 
     size_t                            _active;  // Number of active cosets
     bool                              _already_reported_killed;
     std::vector<signed_class_index_t> _bckwd;
+    std::vector<coincidence_t>        _coincidences;  // Pairs to identify
     size_t                            _cosets_killed;
     class_index_t                     _current;
     class_index_t                     _current_no_add;
     size_t                            _defined;
+    std::vector<deduction_t>          _deductions;
     std::vector<relation_t>           _extra;
+    bool                              _felsch;  // Using Felsch strategy?
+    size_t                            _forced_lookahead_active;
     std::vector<class_index_t>        _forwd;
     class_index_t                     _id_coset;   // TODO(JDM) Remove?
     bool                              _init_done;  // Has init() been run yet?
     class_index_t                     _last;
-    std::stack<class_index_t> _lhs_stack;  // Stack for identifying cosets
+    tc_lookahead_t            _lookahead;
+    size_t                    _lookahead_growth;  // Percentage
+    size_t                    _lookahead_threads;
+    size_t                    _max_new_cosets;
+    size_t                    _memory_limit;  // Bytes, or 0 for no limit
     class_index_t             _next;
+    size_t                    _nr_deductions;
+    size_t                    _nr_lookahead_killed;
+    size_t                    _nr_lookaheads;
+    size_t                    _nr_table_rewrites;
     size_t                    _pack;  // Nr of active cosets allowed before a
                                       // packing phase starts
     bool                      _prefilled;
-    RecVec<class_index_t>     _preim_init;
-    RecVec<class_index_t>     _preim_next;
     std::vector<relation_t>   _relations;
-    std::stack<class_index_t> _rhs_stack;  // Stack for identifying cosets
+    bool                      _relations_done;  // Has init_tc_relations run?
     size_t                    _steps;
     size_t                    _stop_packing;  // TODO(JDM): make this a bool?
-    RecVec<class_index_t>     _table;
+    tc_strategy_t             _strategy;
+    CosetTable                _table;
     bool                      _tc_done;  // Has Todd-Coxeter been completed?
+
+    // The following are only used by the Felsch strategy.
+    std::vector<class_index_t>                    _felsch_cosets;
+    std::vector<std::pair<class_index_t, size_t>> _felsch_stack;
+    // _occurrences[a] contains (2 * i + j, k) if letter k of side j of
+    // _relations[i] is a.
+    std::vector<std::vector<std::pair<size_t, size_t>>> _occurrences;
   };
 }  // namespace libsemigroups
 #endif  // LIBSEMIGROUPS_SRC_CONG_TC_H_
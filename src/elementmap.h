@@ -0,0 +1,334 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains a hash table for looking up the index of an Element,
+// which is used by the Semigroup class and by Congruence::P.
+
+#ifndef LIBSEMIGROUPS_SRC_ELEMENTMAP_H_
+#define LIBSEMIGROUPS_SRC_ELEMENTMAP_H_
+
+#include <inttypes.h>
+
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "elements.h"
+#include "libsemigroups-debug.h"
+
+namespace libsemigroups {
+
+  //
+  // Template class for hash tables whose keys are pointers to <Element>s,
+  // which are compared by value, and whose values are indices of the unsigned
+  // integer type **T**. The key associated to the value **i** must be the
+  // **i**th entry of a vector of keys specified when the table is
+  // constructed, and so only the values are stored in the table.
+  //
+  // The entries are stored in open addressing (linear probing) arrays of
+  // slots, each of which contains a value and the hash value of the
+  // corresponding key. Hence most unsuccessful comparisons of keys do not
+  // dereference anything, and the table can grow without calling
+  // Element::hash_value.
+  //
+  // The table is split into a number of shards, determined by the hash value
+  // of the key, each of which has its own array of slots and its own mutex.
+  // The methods <find> and <insert> do not lock anything; <find> can be
+  // called by several threads at the same time provided that no thread
+  // modifies the table. The methods whose names begin with concurrent_ lock
+  // the shard containing the key, and so they can be called by several
+  // threads at the same time.
+  //
+  // Entries cannot be removed, and the table does not own the vector of keys
+  // or the keys themselves.
+
+  template <typename T> class ElementMap {
+    struct Slot {
+      Slot() : _hash(0), _value(UNDEFINED) {}
+      size_t _hash;
+      T      _value;  // UNDEFINED if the slot is empty
+    };
+
+    struct Shard {
+      Shard() : _mtx(), _size(0), _slots() {}
+      std::mutex        _mtx;
+      size_t            _size;
+      std::vector<Slot> _slots;
+    };
+
+   public:
+    // This is the value returned by <find> when a key is not in the table.
+    static T const UNDEFINED;
+
+    // Default constructor
+    // @keys the vector of keys, which must not be deleted while the table is
+    // in use
+    // @nr_shards_log2 the base 2 logarithm of the number of shards (defaults
+    // to 4)
+    //
+    // Constructs an empty <ElementMap>; no memory is allocated for the slots
+    // of any shard until the first key is inserted into it.
+
+    explicit ElementMap(std::vector<Element*> const* keys,
+                        size_t                       nr_shards_log2 = 4)
+        : _keys(keys),
+          _shard_bits(nr_shards_log2),
+          _shard_mask((static_cast<size_t>(1) << nr_shards_log2) - 1),
+          _shards(static_cast<size_t>(1) << nr_shards_log2) {}
+
+    ElementMap(ElementMap const&) = delete;
+    ElementMap& operator=(ElementMap const&) = delete;
+
+    // Find (const)
+    // @x the key
+    //
+    // This method is const.
+    // @return the value associated to **x**, or <UNDEFINED> if there is no
+    // such value.
+
+    T find(Element const* x) const {
+      return find(x, Element::Equal());
+    }
+
+    // Find with a given equality (const)
+    // @x the key
+    // @equal a function object for comparing **x** with the keys
+    //
+    // This method is the same as <find> except that the keys are compared
+    // using **equal** rather than Element::operator==. This is used by
+    // FroidurePin to avoid calling a virtual method for every comparison.
+    // This method is const.
+    // @return the value associated to **x**, or <UNDEFINED> if there is no
+    // such value.
+
+    template <class TEqual>
+    T find(Element const* x, TEqual const& equal) const {
+      size_t const h = x->hash_value();
+      size_t const m = mix(h);
+      return find(_shards[m & _shard_mask], x, h, m >> _shard_bits, equal);
+    }
+
+    // Insert
+    // @x the key, which must not already belong to the table
+    // @val the value
+    //
+    // Associates **val** to **x**, which must be the entry in position
+    // **val** of the vector of keys.
+
+    void insert(Element const* x, T val) {
+      LIBSEMIGROUPS_ASSERT(find(x) == UNDEFINED);
+      LIBSEMIGROUPS_ASSERT(val < _keys->size() && (*_keys)[val] == x);
+      size_t const h = x->hash_value();
+      size_t const m = mix(h);
+      insert(_shards[m & _shard_mask], val, h, m >> _shard_bits);
+    }
+
+    // Find and lock the shard
+    // @x the key
+    //
+    // This method is the same as <find> except that the shard containing
+    // **x** is locked during the lookup.
+
+    T concurrent_find(Element const* x) {
+      size_t const                h = x->hash_value();
+      size_t const                m = mix(h);
+      Shard&                      shard(_shards[m & _shard_mask]);
+      std::lock_guard<std::mutex> lg(shard._mtx);
+      return find(shard, x, h, m >> _shard_bits, Element::Equal());
+    }
+
+    // Find or insert and lock the shard
+    // @x the key
+    // @val the value
+    //
+    // If **x** belongs to the table, then this method returns the value
+    // associated to **x** and does not modify the table. Otherwise, **val**
+    // is associated to **x**, as in <insert>, and **val** is returned. The
+    // shard containing **x** is locked throughout, but the vector of keys is
+    // not, and so it is the responsibility of the caller to ensure that the
+    // vector of keys is not reallocated while other threads are using the
+    // table.
+
+    T concurrent_find_or_insert(Element const* x, T val) {
+      size_t const                h = x->hash_value();
+      size_t const                m = mix(h);
+      Shard&                      shard(_shards[m & _shard_mask]);
+      std::lock_guard<std::mutex> lg(shard._mtx);
+      T const                     found
+          = find(shard, x, h, m >> _shard_bits, Element::Equal());
+      if (found != UNDEFINED) {
+        return found;
+      }
+      LIBSEMIGROUPS_ASSERT(val < _keys->size() && (*_keys)[val] == x);
+      insert(shard, val, h, m >> _shard_bits);
+      return val;
+    }
+
+    // Reserve
+    // @n the number of keys
+    //
+    // Allocates enough memory that **n** keys can (probably) be inserted into
+    // the table without any further allocation.
+
+    void reserve(size_t n) {
+      size_t const per_shard = n / _shards.size() + n / (8 * _shards.size());
+      for (Shard& shard : _shards) {
+        size_t capacity = (shard._slots.empty() ? 8 : shard._slots.size());
+        while (too_full(per_shard, capacity)) {
+          capacity *= 2;
+        }
+        if (capacity > shard._slots.size()) {
+          rehash(shard, capacity);
+        }
+      }
+    }
+
+    // Size (const)
+    //
+    // This method is const.
+    // @return the number of keys in the table.
+
+    size_t size() const {
+      size_t n = 0;
+      for (Shard const& shard : _shards) {
+        n += shard._size;
+      }
+      return n;
+    }
+
+    // Memory usage (const)
+    //
+    // This method is const.
+    // @return the number of bytes used by the table, not including the keys.
+
+    size_t bytes() const {
+      size_t n = sizeof(ElementMap) + _shards.size() * sizeof(Shard);
+      for (Shard const& shard : _shards) {
+        n += shard._slots.size() * sizeof(Slot);
+      }
+      return n;
+    }
+
+    // Probes (const)
+    // @nr_probes the total number of slots examined to find every key in the
+    // table is put here
+    // @nr_collisions the number of keys which are not in the first slot
+    // examined to find them is put here
+    //
+    // This method is const, and does not call Element::hash_value or compare
+    // any keys.
+
+    void probes(size_t& nr_probes, size_t& nr_collisions) const {
+      nr_probes     = 0;
+      nr_collisions = 0;
+      for (Shard const& shard : _shards) {
+        size_t const mask = shard._slots.size() - 1;
+        for (size_t i = 0; i < shard._slots.size(); i++) {
+          Slot const& slot = shard._slots[i];
+          if (slot._value != UNDEFINED) {
+            size_t const d = (i - (mix(slot._hash) >> _shard_bits)) & mask;
+            nr_probes += d + 1;
+            nr_collisions += (d > 0);
+          }
+        }
+      }
+    }
+
+   private:
+    // The maximum load factor is 3/4
+    static bool too_full(size_t nr, size_t capacity) {
+      return 4 * nr >= 3 * capacity;
+    }
+
+    // A bijection of the set of 64-bit integers, so that the shard and first
+    // slot of a key depend on every bit of its hash value (this is the
+    // finaliser of MurmurHash3).
+    static size_t mix(size_t h) {
+      uint64_t m = h;
+      m ^= m >> 33;
+      m *= UINT64_C(0xff51afd7ed558ccd);
+      m ^= m >> 33;
+      m *= UINT64_C(0xc4ceb9fe1a85ec53);
+      m ^= m >> 33;
+      return static_cast<size_t>(m);
+    }
+
+    template <class TEqual>
+    T find(Shard const&   shard,
+           Element const* x,
+           size_t         h,
+           size_t         m,
+           TEqual const&  equal) const {
+      if (shard._slots.empty()) {
+        return UNDEFINED;
+      }
+      size_t const mask = shard._slots.size() - 1;
+      for (size_t i = m & mask;; i = (i + 1) & mask) {
+        Slot const& slot = shard._slots[i];
+        if (slot._value == UNDEFINED) {
+          return UNDEFINED;
+        } else if (slot._hash == h && equal((*_keys)[slot._value], x)) {
+          return slot._value;
+        }
+      }
+    }
+
+    void insert(Shard& shard, T val, size_t h, size_t m) {
+      LIBSEMIGROUPS_ASSERT(val != UNDEFINED);
+      if (shard._slots.empty()
+          || too_full(shard._size + 1, shard._slots.size())) {
+        rehash(shard, shard._slots.empty() ? 8 : 2 * shard._slots.size());
+      }
+      size_t const mask = shard._slots.size() - 1;
+      size_t       i    = m & mask;
+      while (shard._slots[i]._value != UNDEFINED) {
+        i = (i + 1) & mask;
+      }
+      shard._slots[i]._hash  = h;
+      shard._slots[i]._value = val;
+      shard._size++;
+    }
+
+    // Resize the array of slots of <shard> to <capacity> (a power of 2),
+    // reinserting the keys using their stored hash values.
+    void rehash(Shard& shard, size_t capacity) {
+      std::vector<Slot> old(capacity);
+      std::swap(old, shard._slots);
+      size_t const mask = capacity - 1;
+      for (Slot const& slot : old) {
+        if (slot._value != UNDEFINED) {
+          size_t i = (mix(slot._hash) >> _shard_bits) & mask;
+          while (shard._slots[i]._value != UNDEFINED) {
+            i = (i + 1) & mask;
+          }
+          shard._slots[i] = slot;
+        }
+      }
+    }
+
+    std::vector<Element*> const* _keys;
+    size_t                       _shard_bits;
+    size_t                       _shard_mask;
+    std::vector<Shard>           _shards;
+  };
+
+  template <typename T>
+  T const ElementMap<T>::UNDEFINED = std::numeric_limits<T>::max();
+}  // namespace libsemigroups
+
+#endif  // LIBSEMIGROUPS_SRC_ELEMENTMAP_H_
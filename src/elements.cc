@@ -84,6 +84,29 @@ namespace libsemigroups {
     std::vector<bool>* xx(static_cast<BooleanMat const*>(x)->_vector);
     std::vector<bool>* yy(static_cast<BooleanMat const*>(y)->_vector);
 
+    if (dim <= 64) {
+      uint64_t rows[64];
+      for (k = 0; k < dim; k++) {
+        rows[k] = 0;
+        for (size_t j = 0; j < dim; j++) {
+          rows[k] |= static_cast<uint64_t>((*yy)[k * dim + j]) << j;
+        }
+      }
+      for (size_t i = 0; i < dim; i++) {
+        uint64_t row = 0;
+        for (k = 0; k < dim; k++) {
+          if ((*xx)[i * dim + k]) {
+            row |= rows[k];
+          }
+        }
+        for (size_t j = 0; j < dim; j++) {
+          (*_vector)[i * dim + j] = (row >> j) & 1;
+        }
+      }
+      this->reset_hash_value();
+      return;
+    }
+
     for (size_t i = 0; i < dim; i++) {
       for (size_t j = 0; j < dim; j++) {
         for (k = 0; k < dim; k++) {
@@ -97,14 +120,126 @@ namespace libsemigroups {
     this->reset_hash_value();
   }
 
+  // PackedBooleanMat
+
+  PackedBooleanMat::PackedBooleanMat(
+      std::vector<std::vector<bool>> const& matrix)
+      : ElementWithVectorData<uint64_t, PackedBooleanMat>(
+            matrix.size() * nr_words(matrix.size())),
+        _dim(matrix.size()) {
+    LIBSEMIGROUPS_ASSERT(matrix.size() != 0);
+    size_t const nr = nr_words(_dim);
+    for (size_t i = 0; i < _dim; i++) {
+      LIBSEMIGROUPS_ASSERT(matrix[i].size() == _dim);
+      for (size_t j = 0; j < _dim; j++) {
+        if (matrix[i][j]) {
+          (*_vector)[i * nr + j / 64] |= static_cast<uint64_t>(1) << (j % 64);
+        }
+      }
+    }
+  }
+
+  PackedBooleanMat::PackedBooleanMat(BooleanMat const& x)
+      : ElementWithVectorData<uint64_t, PackedBooleanMat>(
+            x.degree() * nr_words(x.degree())),
+        _dim(x.degree()) {
+    size_t const nr = nr_words(_dim);
+    for (size_t i = 0; i < _dim; i++) {
+      for (size_t j = 0; j < _dim; j++) {
+        if (x[i * _dim + j]) {
+          (*_vector)[i * nr + j / 64] |= static_cast<uint64_t>(1) << (j % 64);
+        }
+      }
+    }
+  }
+
+  void PackedBooleanMat::cache_hash_value() const {
+    size_t seed = 0;
+    for (uint64_t x : *_vector) {
+      seed ^= static_cast<size_t>(x * UINT64_C(0x9e3779b97f4a7c15))
+              + (seed << 6) + (seed >> 2);
+    }
+    this->_hash_value = seed;
+  }
+
+  Element* PackedBooleanMat::identity() const {
+    std::vector<uint64_t>* rows(new std::vector<uint64_t>(_vector->size(), 0));
+    size_t const           nr = nr_words(_dim);
+    for (size_t i = 0; i < _dim; i++) {
+      (*rows)[i * nr + i / 64] = static_cast<uint64_t>(1) << (i % 64);
+    }
+    return new PackedBooleanMat(rows, _dim);
+  }
+
+  Element* PackedBooleanMat::really_copy(size_t increase_deg_by) const {
+    LIBSEMIGROUPS_ASSERT(increase_deg_by == 0);
+    (void) increase_deg_by;
+    return new PackedBooleanMat(
+        new std::vector<uint64_t>(*_vector), _dim, this->_hash_value);
+  }
+
+  PackedBooleanMat* PackedBooleanMat::transpose() const {
+    std::vector<uint64_t>* rows(new std::vector<uint64_t>(_vector->size(), 0));
+    size_t const           nr = nr_words(_dim);
+    for (size_t i = 0; i < _dim; i++) {
+      for (size_t w = 0; w < nr; w++) {
+        uint64_t word = (*_vector)[i * nr + w];
+        while (word != 0) {
+          size_t const j = 64 * w + __builtin_ctzll(word);
+          (*rows)[j * nr + i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+          word &= word - 1;
+        }
+      }
+    }
+    return new PackedBooleanMat(rows, _dim);
+  }
+
+  // Every row of the product is the bitwise or of the rows of y corresponding
+  // to the bits which are set in the same row of x.
+  void PackedBooleanMat::redefine(Element const* x, Element const* y) {
+    LIBSEMIGROUPS_ASSERT(x->degree() == y->degree());
+    LIBSEMIGROUPS_ASSERT(x->degree() == this->degree());
+    LIBSEMIGROUPS_ASSERT(x != this && y != this);
+    uint64_t const* xx
+        = static_cast<PackedBooleanMat const*>(x)->_vector->data();
+    uint64_t const* yy
+        = static_cast<PackedBooleanMat const*>(y)->_vector->data();
+    uint64_t* out = _vector->data();
+
+    if (_dim <= 64) {
+      for (size_t i = 0; i < _dim; i++) {
+        uint64_t word = xx[i];
+        uint64_t row  = 0;
+        while (word != 0) {
+          row |= yy[__builtin_ctzll(word)];
+          word &= word - 1;
+        }
+        out[i] = row;
+      }
+    } else {
+      size_t const nr = nr_words(_dim);
+      std::fill(out, out + _vector->size(), 0);
+      for (size_t i = 0; i < _dim; i++) {
+        uint64_t* row = out + i * nr;
+        for (size_t w = 0; w < nr; w++) {
+          uint64_t word = xx[i * nr + w];
+          while (word != 0) {
+            uint64_t const* yrow = yy + (64 * w + __builtin_ctzll(word)) * nr;
+            for (size_t v = 0; v < nr; v++) {
+              row[v] |= yrow[v];
+            }
+            word &= word - 1;
+          }
+        }
+      }
+    }
+    this->reset_hash_value();
+  }
+
   // Bipartition
 
   u_int32_t const Bipartition::UNDEFINED
       = std::numeric_limits<u_int32_t>::max();
-  std::vector<std::vector<u_int32_t>>
-      Bipartition::_fuse(std::thread::hardware_concurrency());
-  std::vector<std::vector<u_int32_t>>
-      Bipartition::_lookup(std::thread::hardware_concurrency());
 
   u_int32_t Bipartition::block(size_t pos) const {
     LIBSEMIGROUPS_ASSERT(pos < 2 * degree());
@@ -120,13 +255,7 @@ namespace libsemigroups {
   }
 
   void Bipartition::cache_hash_value() const {
-    size_t seed = 0;
-    size_t deg  = this->_vector->size();
-    for (auto const& val : *(this->_vector)) {
-      seed *= deg;
-      seed += val;
-    }
-    this->_hash_value = seed;
+    this->_hash_value = hash_images(_vector->data(), _vector->size());
   }
 
   // the identity of this
@@ -141,77 +270,125 @@ namespace libsemigroups {
     return new Bipartition(blocks);
   }
 
-  // multiply x and y into this
-  void Bipartition::redefine(Element const* x,
-                             Element const* y,
-                             size_t const&  thread_id) {
-    LIBSEMIGROUPS_ASSERT(x->degree() == y->degree());
-    LIBSEMIGROUPS_ASSERT(x->degree() == this->degree());
-    LIBSEMIGROUPS_ASSERT(x != this && y != this);
-    u_int32_t n = this->degree();
-
-    Bipartition const* xx = static_cast<Bipartition const*>(x);
-    Bipartition const* yy = static_cast<Bipartition const*>(y);
-
-    std::vector<u_int32_t>* xblocks(xx->_vector);
-    std::vector<u_int32_t>* yblocks(yy->_vector);
-
-    u_int32_t nrx(xx->const_nr_blocks());
-    u_int32_t nry(yy->const_nr_blocks());
-
-    std::vector<u_int32_t>& fuse(_fuse[thread_id]);
-    std::vector<u_int32_t>& lookup(_lookup[thread_id]);
-
-    fuse.clear();
-    fuse.reserve(nrx + nry);
-    lookup.clear();
-    lookup.reserve(nrx + nry);
-
-    for (size_t i = 0; i < nrx + nry; i++) {
-      fuse.push_back(i);
-      lookup.push_back(-1);
+  // Multiplies the bipartitions of degree n with blocks x and y, which have
+  // nrx and nry blocks, and stores the blocks of the product in xy.
+  //
+  // The block i of x is identified with i, and the block i of y with nrx + i.
+  // The union-find table fuse fuses the blocks of x and y which meet in the
+  // middle, and satisfies fuse[i] <= i, so that fuse[i] is the root of the
+  // tree containing i once it has been flattened by a single pass in
+  // increasing order. The table lookup is used to renumber the roots of the
+  // blocks of the product in order of first occurrence.
+  //
+  // The arrays fuse and lookup must have length at least nrx + nry, which must
+  // be less than the maximum value of T (which is used as UNDEFINED). The
+  // smallest possible type is used by Bipartition::redefine, so that the
+  // tables take as little of the cache as possible.
+  //
+  // Returns the number of blocks of the product.
+  template <typename T>
+  static inline size_t bipartition_product(u_int32_t const* x,
+                                         u_int32_t const* y,
+                                         u_int32_t*       xy,
+                                         size_t           n,
+                                         size_t           nrx,
+                                         size_t           nry,
+                                         T*               fuse,
+                                         T*               lookup) {
+    T const      undef = std::numeric_limits<T>::max();
+    size_t const m     = nrx + nry;
+    LIBSEMIGROUPS_ASSERT(m < undef);
+
+    for (size_t i = 0; i < m; i++) {
+      fuse[i]   = i;
+      lookup[i] = undef;
     }
 
     for (size_t i = 0; i < n; i++) {
-      u_int32_t j = fuseit(fuse, (*xblocks)[i + n]);
-      u_int32_t k = fuseit(fuse, (*yblocks)[i] + nrx);
-      if (j != k) {
-        if (j < k) {
-          fuse[k] = j;
-        } else {
-          fuse[j] = k;
-        }
+      T j = x[i + n];
+      while (fuse[j] < j) {
+        j = fuse[j];
       }
+      T k = y[i] + nrx;
+      while (fuse[k] < k) {
+        k = fuse[k];
+      }
+      // If j == k, then this sets fuse[j] to j, which it already is.
+      fuse[std::max(j, k)] = std::min(j, k);
     }
 
-    u_int32_t next = 0;
+    for (size_t i = 0; i < m; i++) {
+      fuse[i] = fuse[fuse[i]];
+    }
 
+    T next = 0;
     for (size_t i = 0; i < n; i++) {
-      u_int32_t j = fuseit(fuse, (*xblocks)[i]);
-      if (lookup[j] == (u_int32_t) -1) {
-        lookup[j] = next;
-        next++;
-      }
-      (*this->_vector)[i] = lookup[j];
+      T const j   = fuse[x[i]];
+      T const old = lookup[j];
+      lookup[j]   = (old == undef ? next : old);
+      next += (old == undef);
+      xy[i] = lookup[j];
     }
-
     for (size_t i = n; i < 2 * n; i++) {
-      u_int32_t j = fuseit(fuse, (*yblocks)[i] + nrx);
-      if (lookup[j] == (u_int32_t) -1) {
-        lookup[j] = next;
-        next++;
-      }
-      (*this->_vector)[i] = lookup[j];
+      T const j   = fuse[y[i] + nrx];
+      T const old = lookup[j];
+      lookup[j]   = (old == undef ? next : old);
+      next += (old == undef);
+      xy[i] = lookup[j];
     }
-    this->reset_hash_value();
+    return next;
   }
 
-  inline u_int32_t Bipartition::fuseit(std::vector<u_int32_t>& fuse,
-                                       u_int32_t               pos) {
-    while (fuse[pos] < pos) {
-      pos = fuse[pos];
-    }
-    return pos;
+  // multiply x and y into this
+  void Bipartition::redefine(Element const* x,
+                             Element const* y,
+                             size_t const&  thread_id) {
+    (void) thread_id;
+    LIBSEMIGROUPS_ASSERT(x->degree() == y->degree());
+    LIBSEMIGROUPS_ASSERT(x->degree() == this->degree());
+    LIBSEMIGROUPS_ASSERT(x != this && y != this);
+    size_t const n = this->degree();
+
+    Bipartition const* xx = static_cast<Bipartition const*>(x);
+    Bipartition const* yy = static_cast<Bipartition const*>(y);
+
+    u_int32_t const* xblocks  = xx->_vector->data();
+    u_int32_t const* yblocks  = yy->_vector->data();
+    u_int32_t*       xyblocks = this->_vector->data();
+
+    size_t const nrx = xx->const_nr_blocks();
+    size_t const nry = yy->const_nr_blocks();
+    size_t const m   = nrx + nry;
+
+    // The scratch space is on the stack of the calling thread, unless the
+    // number of blocks is very large, in which case the cost of allocating it
+    // is small compared to the cost of the product. Since each of x and y
+    // has at most 2n blocks, m is at most 4n, and so u_int8_t is always used
+    // when n < 64 and u_int16_t is always used when 64 <= n < 256.
+    if (m < 0xFF) {
+      u_int8_t fuse[0xFF], lookup[0xFF];
+      _nr_blocks = bipartition_product(
+          xblocks, yblocks, xyblocks, n, nrx, nry, fuse, lookup);
+    } else if (m < 0x400) {
+      u_int16_t fuse[0x400], lookup[0x400];
+      _nr_blocks = bipartition_product(
+          xblocks, yblocks, xyblocks, n, nrx, nry, fuse, lookup);
+    } else {
+      std::vector<u_int32_t> scratch(2 * m);
+      _nr_blocks = bipartition_product(xblocks,
+                                       yblocks,
+                                       xyblocks,
+                                       n,
+                                       nrx,
+                                       nry,
+                                       scratch.data(),
+                                       scratch.data() + m);
+    }
+    // The other cached values of this are no longer valid.
+    _nr_left_blocks = Bipartition::UNDEFINED;
+    _trans_blocks_lookup.clear();
+    _rank = Bipartition::UNDEFINED;
+    this->reset_hash_value();
   }
 
   // nr blocks
@@ -305,11 +482,7 @@ namespace libsemigroups {
     std::vector<bool>*      blocks_lookup = new std::vector<bool>();
 
     // must reindex the blocks
-    std::vector<u_int32_t>& lookup
-        = _lookup[glob_reporter.thread_id(std::this_thread::get_id())];
-
-    lookup.clear();
-    lookup.resize(this->nr_blocks(), Bipartition::UNDEFINED);
+    std::vector<u_int32_t> lookup(this->nr_blocks(), Bipartition::UNDEFINED);
     u_int32_t nr_blocks = 0;
 
     for (auto it = _vector->begin() + (_vector->size() / 2);
@@ -403,18 +576,10 @@ namespace libsemigroups {
     // semigroup and another from an ideal of that semigroup).
     // LIBSEMIGROUPS_ASSERT(xx->semiring() == yy->semiring()
     //       && xx->semiring() == this->semiring());
-    size_t deg = this->degree();
-
-    for (size_t i = 0; i < deg; i++) {
-      for (size_t j = 0; j < deg; j++) {
-        int64_t v = _semiring->zero();
-        for (size_t k = 0; k < deg; k++) {
-          v = _semiring->plus(
-              v, _semiring->prod((*xx)[i * deg + k], (*yy)[k * deg + j]));
-        }
-        (*_vector)[i * deg + j] = v;
-      }
-    }
+    _semiring->matrix_product(xx->_vector->data(),
+                              yy->_vector->data(),
+                              _vector->data(),
+                              this->degree());
     after();  // post process this
     this->reset_hash_value();
   }
@@ -425,12 +590,15 @@ namespace libsemigroups {
   ////////////////////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////////////////////
 
+  // The entries equal to Semiring::MINUS_INFTY are selected rather than
+  // branched on, and the subtraction is unsigned so that it is defined (and
+  // discarded) for these entries.
   void ProjectiveMaxPlusMatrix::after() {
-    int64_t norm = *std::max_element(_vector->begin(), _vector->end());
+    int64_t const norm = *std::max_element(_vector->begin(), _vector->end());
     for (auto& x : *_vector) {
-      if (x != LONG_MIN) {
-        x -= norm;
-      }
+      int64_t const y = static_cast<int64_t>(static_cast<uint64_t>(x)
+                                             - static_cast<uint64_t>(norm));
+      x = (x == Semiring::MINUS_INFTY ? x : y);
     }
   }
 
@@ -440,12 +608,112 @@ namespace libsemigroups {
   ////////////////////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////////////////////
 
-  std::vector<std::vector<bool>>
-      PBR::_x_seen(std::thread::hardware_concurrency());
-  std::vector<std::vector<bool>>
-                            PBR::_y_seen(std::thread::hardware_concurrency());
-  std::vector<RecVec<bool>> PBR::_out(std::thread::hardware_concurrency());
-  std::vector<RecVec<bool>> PBR::_tmp(std::thread::hardware_concurrency());
+  // Multiplies the PBRs of degree n whose points are adjacent to the bits set
+  // in x and y, stored as in PackedPBR with nr words for every point, and
+  // stores the result in xy. The array scratch must have length at least
+  // (4n + 2) * nr.
+  //
+  // A path in the product of x and y consists of an edge of x or y from a
+  // point of the product, followed by a sequence of middle points, which are
+  // the points n, ..., 2n - 1 of x identified with the points 0, ..., n - 1
+  // of y, where the edges alternate between x and y, followed by an edge to a
+  // point of the product. The states of the search for these paths are
+  // numbered 0, ..., 2n - 1, so that the state k < n is the middle point k
+  // reached by an edge of y (and so followed by the row k + n of x), and the
+  // state k + n is the middle point k reached by an edge of x (and so
+  // followed by the row k of y). In this way, the bits set in a row of x or
+  // y which are states are exactly those in the other half of the row to the
+  // bits which are points of the product.
+  //
+  // First the transitive closure of the edges between states is found with
+  // Warshall's algorithm, then the points of the product reachable from every
+  // state, and finally the row of every point of the product is the bitwise
+  // or of its direct edges and the rows of the states it is adjacent to.
+  //
+  // If the template parameter NR is not 0, then it must equal nr, so that the
+  // loops over the words of a row can be unrolled.
+  template <size_t NR>
+  static void pbr_product(uint64_t const* x,
+                          uint64_t const* y,
+                          uint64_t*       xy,
+                          size_t          n,
+                          size_t          nr_words,
+                          uint64_t*       scratch) {
+    size_t const nr      = (NR == 0 ? nr_words : NR);
+    size_t const N       = 2 * n;
+    uint64_t*    low     = scratch;
+    uint64_t*    high    = low + nr;
+    uint64_t*    closure = high + nr;
+    uint64_t*    reach   = closure + N * nr;
+
+    std::fill(low, low + 2 * nr, 0);
+    for (size_t j = 0; j < N; j++) {
+      (j < n ? low : high)[j / 64] |= static_cast<uint64_t>(1) << (j % 64);
+    }
+
+    for (size_t k = 0; k < N; k++) {
+      uint64_t const* row  = (k < n ? x + (k + n) * nr : y + (k - n) * nr);
+      uint64_t const* next = (k < n ? high : low);
+      uint64_t const* out  = (k < n ? low : high);
+      for (size_t w = 0; w < nr; w++) {
+        closure[k * nr + w] = row[w] & next[w];
+        reach[k * nr + w]   = row[w] & out[w];
+      }
+    }
+
+    // If every row is a single word, then the rows are masked rather than
+    // branched on, since whether or not a state is reachable from another is
+    // unpredictable. Otherwise, the branch skips more work than it costs.
+    for (size_t k = 0; k < N; k++) {
+      uint64_t const* krow = closure + k * nr;
+      for (size_t i = 0; i < N; i++) {
+        uint64_t*      irow = closure + i * nr;
+        uint64_t const mask = -((irow[k / 64] >> (k % 64)) & 1);
+        if (NR == 1) {
+          irow[0] |= krow[0] & mask;
+        } else if (mask != 0) {
+          for (size_t w = 0; w < nr; w++) {
+            irow[w] |= krow[w];
+          }
+        }
+      }
+    }
+
+    // If the state j is reachable from i, then so is every state reachable
+    // from j, and so it does not matter if reach[j] has already been updated.
+    for (size_t i = 0; i < N; i++) {
+      uint64_t* irow = reach + i * nr;
+      for (size_t v = 0; v < nr; v++) {
+        uint64_t word = closure[i * nr + v];
+        while (word != 0) {
+          uint64_t const* jrow = reach + (64 * v + __builtin_ctzll(word)) * nr;
+          for (size_t w = 0; w < nr; w++) {
+            irow[w] |= jrow[w];
+          }
+          word &= word - 1;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < N; i++) {
+      uint64_t const* row    = (i < n ? x : y) + i * nr;
+      uint64_t const* direct = (i < n ? low : high);
+      uint64_t*       out    = xy + i * nr;
+      for (size_t w = 0; w < nr; w++) {
+        out[w] = row[w] & direct[w];
+      }
+      for (size_t v = 0; v < nr; v++) {
+        uint64_t word = row[v] & ~direct[v];
+        while (word != 0) {
+          uint64_t const* jrow = reach + (64 * v + __builtin_ctzll(word)) * nr;
+          for (size_t w = 0; w < nr; w++) {
+            out[w] |= jrow[w];
+          }
+          word &= word - 1;
+        }
+      }
+    }
+  }
 
   size_t PBR::complexity() const {
     return pow((2 * this->degree()), 3);
@@ -484,6 +752,7 @@ namespace libsemigroups {
 
   void
   PBR::redefine(Element const* xx, Element const* yy, size_t const& thread_id) {
+    (void) thread_id;
     LIBSEMIGROUPS_ASSERT(xx->degree() == yy->degree());
     LIBSEMIGROUPS_ASSERT(xx->degree() == this->degree());
     LIBSEMIGROUPS_ASSERT(xx != this && yy != this);
@@ -491,133 +760,119 @@ namespace libsemigroups {
     PBR const* x(static_cast<PBR const*>(xx));
     PBR const* y(static_cast<PBR const*>(yy));
 
-    u_int32_t const n = this->degree();
-
-    std::vector<bool>& x_seen = _x_seen[thread_id];
-    std::vector<bool>& y_seen = _y_seen[thread_id];
-    RecVec<bool>&      tmp    = _tmp[thread_id];
-    RecVec<bool>&      out    = _out[thread_id];
-
-    if (x_seen.size() != 2 * n) {
-      x_seen.clear();
-      x_seen.resize(2 * n, false);
-      y_seen.clear();
-      y_seen.resize(2 * n, false);
-      out.clear();
-      out.add_cols(2 * n);
-      out.add_rows(2 * n);
-      tmp.clear();
-      tmp.add_cols(2 * n + 1);
-    } else {
-      std::fill(x_seen.begin(), x_seen.end(), false);
-      std::fill(y_seen.begin(), y_seen.end(), false);
-      std::fill(out.begin(), out.end(), false);
-      std::fill(tmp.begin(), tmp.end(), false);
-    }
-
-    for (size_t i = 0; i < n; i++) {
-      for (auto const& j : (*x)[i]) {
-        if (j < n) {
-          out.set(i, j, true);
-        } else if (j < tmp.nr_rows() && tmp.get(j, 0)) {
-          unite_rows(out, tmp, i, j);
-        } else {
-          if (j >= tmp.nr_rows()) {
-            tmp.add_rows(j - tmp.nr_rows() + 1);
-          }
-          tmp.set(j, 0, true);
-          x_seen[i] = true;
-          y_dfs(x_seen, y_seen, tmp, n, j - n, x, y, j);
-          unite_rows(out, tmp, i, j);
-          std::fill(x_seen.begin(), x_seen.end(), false);
-          std::fill(y_seen.begin(), y_seen.end(), false);
-        }
-        if (out.all_of(i, [](bool val) { return val; })) {
-          break;
-        }
+    size_t const n  = this->degree();
+    size_t const nr = PackedPBR::nr_words(n);
+    // The packed x, y, and product, followed by the scratch space used by
+    // pbr_product.
+    size_t const size = (3 * 2 * n + 4 * n + 2) * nr;
+
+    uint64_t              buf[10 * 32 + 2];
+    std::vector<uint64_t> vec;
+    uint64_t*             packed = buf;
+    if (size > sizeof(buf) / sizeof(uint64_t)) {
+      vec.resize(size);
+      packed = vec.data();
+    }
+    uint64_t* px  = packed;
+    uint64_t* py  = px + 2 * n * nr;
+    uint64_t* pxy = py + 2 * n * nr;
+    std::fill(px, pxy, 0);
+    for (size_t i = 0; i < 2 * n; i++) {
+      for (u_int32_t j : (*x)[i]) {
+        px[i * nr + j / 64] |= static_cast<uint64_t>(1) << (j % 64);
+      }
+      for (u_int32_t j : (*y)[i]) {
+        py[i * nr + j / 64] |= static_cast<uint64_t>(1) << (j % 64);
       }
     }
 
-    for (size_t i = n; i < 2 * n; i++) {
-      for (auto const& j : (*y)[i]) {
-        if (j >= n) {
-          out.set(i, j, true);
-        } else if (j < tmp.nr_rows() && tmp.get(j, 0)) {
-          unite_rows(out, tmp, i, j);
-        } else {
-          if (j >= tmp.nr_rows()) {
-            tmp.add_rows(j - tmp.nr_rows() + 1);
-          }
-          tmp.set(j, 0, true);
-          y_seen[i] = true;
-          x_dfs(x_seen, y_seen, tmp, n, j + n, x, y, j);
-          unite_rows(out, tmp, i, j);
-          std::fill(x_seen.begin(), x_seen.end(), false);
-          std::fill(y_seen.begin(), y_seen.end(), false);
-        }
-        if (out.all_of(i, [](bool val) { return val; })) {
-          break;
-        }
-      }
+    if (nr == 1) {
+      pbr_product<1>(px, py, pxy, n, nr, pxy + 2 * n * nr);
+    } else {
+      pbr_product<0>(px, py, pxy, n, nr, pxy + 2 * n * nr);
     }
 
     for (size_t i = 0; i < 2 * n; i++) {
-      (*_vector)[i].clear();
-      for (size_t j = 0; j < 2 * n; j++) {
-        if (out.get(i, j)) {
-          (*_vector)[i].push_back(j);
+      std::vector<u_int32_t>& row = (*_vector)[i];
+      row.clear();
+      for (size_t v = 0; v < nr; v++) {
+        uint64_t word = pxy[i * nr + v];
+        while (word != 0) {
+          row.push_back(64 * v + __builtin_ctzll(word));
+          word &= word - 1;
         }
       }
     }
     this->reset_hash_value();
   }
 
-  inline void PBR::unite_rows(RecVec<bool>& out,
-                              RecVec<bool>& tmp,
-                              size_t const& i,
-                              size_t const& j) {
-    for (size_t k = 0; k < out.nr_cols(); k++) {
-      out.set(i, k, (out.get(i, k) || tmp.get(j, k + 1)));
-    }
-  }
-
-  void PBR::x_dfs(std::vector<bool>& x_seen,
-                  std::vector<bool>& y_seen,
-                  RecVec<bool>&      tmp,
-                  u_int32_t const&   n,
-                  u_int32_t const&   i,
-                  PBR const* const   x,
-                  PBR const* const   y,
-                  size_t const&      adj) {
-    if (!x_seen[i]) {
-      x_seen[i] = true;
-      for (auto const& j : (*x)[i]) {
-        if (j < n) {
-          tmp.set(adj, j + 1, true);
-        } else {
-          y_dfs(x_seen, y_seen, tmp, n, j - n, x, y, adj);
-        }
+  // PackedPBR
+
+  PackedPBR::PackedPBR(std::vector<std::vector<u_int32_t>> const& adj)
+      : ElementWithVectorData<uint64_t, PackedPBR>(adj.size()
+                                                   * nr_words(adj.size() / 2)),
+        _degree(adj.size() / 2) {
+    LIBSEMIGROUPS_ASSERT(adj.size() % 2 == 0);
+    size_t const nr = nr_words(_degree);
+    for (size_t i = 0; i < adj.size(); i++) {
+      for (u_int32_t j : adj[i]) {
+        LIBSEMIGROUPS_ASSERT(j < adj.size());
+        (*_vector)[i * nr + j / 64] |= static_cast<uint64_t>(1) << (j % 64);
       }
     }
   }
 
-  void PBR::y_dfs(std::vector<bool>& x_seen,
-                  std::vector<bool>& y_seen,
-                  RecVec<bool>&      tmp,
-                  u_int32_t const&   n,
-                  u_int32_t const&   i,
-                  PBR const* const   x,
-                  PBR const* const   y,
-                  size_t const&      adj) {
-    if (!y_seen[i]) {
-      y_seen[i] = true;
-      for (auto const& j : (*y)[i]) {
-        if (j >= n) {
-          tmp.set(adj, j + 1, true);
-        } else {
-          x_dfs(x_seen, y_seen, tmp, n, j + n, x, y, adj);
-        }
-      }
+  PackedPBR::PackedPBR(PBR const& x)
+      : PackedPBR(std::vector<std::vector<u_int32_t>>(x.begin(), x.end())) {}
+
+  void PackedPBR::cache_hash_value() const {
+    size_t seed = 0;
+    for (uint64_t x : *_vector) {
+      seed ^= static_cast<size_t>(x * UINT64_C(0x9e3779b97f4a7c15))
+              + (seed << 6) + (seed >> 2);
     }
+    this->_hash_value = seed;
+  }
+
+  Element* PackedPBR::identity() const {
+    std::vector<uint64_t>* rows(new std::vector<uint64_t>(_vector->size(), 0));
+    size_t const           nr = nr_words(_degree);
+    for (size_t i = 0; i < _degree; i++) {
+      size_t const j = i + _degree;
+      (*rows)[i * nr + j / 64] = static_cast<uint64_t>(1) << (j % 64);
+      (*rows)[j * nr + i / 64] = static_cast<uint64_t>(1) << (i % 64);
+    }
+    return new PackedPBR(rows, _degree);
+  }
+
+  Element* PackedPBR::really_copy(size_t increase_deg_by) const {
+    LIBSEMIGROUPS_ASSERT(increase_deg_by == 0);
+    (void) increase_deg_by;
+    return new PackedPBR(
+        new std::vector<uint64_t>(*_vector), _degree, this->_hash_value);
+  }
+
+  void PackedPBR::redefine(Element const* x, Element const* y) {
+    LIBSEMIGROUPS_ASSERT(x->degree() == y->degree());
+    LIBSEMIGROUPS_ASSERT(x->degree() == this->degree());
+    LIBSEMIGROUPS_ASSERT(x != this && y != this);
+    size_t const nr   = nr_words(_degree);
+    size_t const size = (4 * _degree + 2) * nr;
+
+    uint64_t              buf[4 * 32 + 2];
+    std::vector<uint64_t> vec;
+    uint64_t*             scratch = buf;
+    if (size > sizeof(buf) / sizeof(uint64_t)) {
+      vec.resize(size);
+      scratch = vec.data();
+    }
+    uint64_t const* xx = static_cast<PackedPBR const*>(x)->_vector->data();
+    uint64_t const* yy = static_cast<PackedPBR const*>(y)->_vector->data();
+    if (nr == 1) {
+      pbr_product<1>(xx, yy, _vector->data(), _degree, nr, scratch);
+    } else {
+      pbr_product<0>(xx, yy, _vector->data(), _degree, nr, scratch);
+    }
+    this->reset_hash_value();
   }
 }  // namespace libsemigroups
@@ -21,15 +21,21 @@
 #ifndef LIBSEMIGROUPS_SRC_ELEMENTS_H_
 #define LIBSEMIGROUPS_SRC_ELEMENTS_H_
 
+#include <inttypes.h>
 #include <math.h>
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 #include <vector>
 
 #include "blocks.h"
+#include "kernels.h"
 #include "libsemigroups-debug.h"
 #include "recvec.h"
 #include "semiring.h"
@@ -544,13 +550,8 @@ namespace libsemigroups {
     //!
     //! \sa Element::hash_value for more details.
     void cache_hash_value() const override {
-      size_t seed = 0;
-      size_t deg  = this->degree();
-      for (auto const& val : *(this->_vector)) {
-        seed *= deg;
-        seed += val;
-      }
-      this->_hash_value = seed;
+      this->_hash_value
+          = hash_images(this->_vector->data(), this->_vector->size());
     }
 
     //! Returns the identity transformation with degrees of \c this.
@@ -653,10 +654,10 @@ namespace libsemigroups {
       LIBSEMIGROUPS_ASSERT(x != this && y != this);
       Transformation<T> const* xx(static_cast<Transformation<T> const*>(x));
       Transformation<T> const* yy(static_cast<Transformation<T> const*>(y));
-      size_t const             n = this->_vector->size();
-      for (T i = 0; i < n; i++) {
-        (*this->_vector)[i] = (*yy)[(*xx)[i]];
-      }
+      compose(xx->_vector->data(),
+              yy->_vector->data(),
+              this->_vector->data(),
+              this->_vector->size());
       this->reset_hash_value();
     }
   };
@@ -796,11 +797,10 @@ namespace libsemigroups {
       LIBSEMIGROUPS_ASSERT(x != this && y != this);
       PartialPerm<T> const* xx(static_cast<PartialPerm<T> const*>(x));
       PartialPerm<T> const* yy(static_cast<PartialPerm<T> const*>(y));
-      size_t const          n = this->degree();
-      for (T i = 0; i < n; i++) {
-        (*this->_vector)[i]
-            = ((*xx)[i] == PP_UNDEFINED ? PP_UNDEFINED : (*yy)[(*xx)[i]]);
-      }
+      compose_partial(xx->_vector->data(),
+                      yy->_vector->data(),
+                      this->_vector->data(),
+                      this->degree());
       this->reset_hash_value();
     }
 
@@ -823,6 +823,282 @@ namespace libsemigroups {
     }
   };
 
+  //! Pool of memory for objects of size \p N.
+  //!
+  //! This class is used to allocate the objects of the subclasses of
+  //! FixedPartialTransformation. The memory is obtained from the system in
+  //! large blocks which contain many objects, so that allocating an object
+  //! does not incur the overhead of a call to the global operator new. The
+  //! memory of a deallocated object is reused by a subsequent allocation, but
+  //! it is never returned to the system. The methods of this class are
+  //! thread-safe.
+  template <size_t N> class FixedSizePool {
+    union Slot {
+      Slot* _next;
+      char  _data[N];
+    };
+
+   public:
+    //! Returns a pointer to memory for an object of size \p N.
+    static void* allocate() {
+      std::lock_guard<std::mutex> lg(_mtx);
+      if (_free == nullptr) {
+        _blocks.push_back(std::unique_ptr<Slot[]>(new Slot[NR_SLOTS]));
+        Slot* block = _blocks.back().get();
+        for (size_t i = 0; i < NR_SLOTS - 1; i++) {
+          block[i]._next = &block[i + 1];
+        }
+        block[NR_SLOTS - 1]._next = nullptr;
+        _free                     = block;
+      }
+      Slot* slot = _free;
+      _free      = slot->_next;
+      return slot;
+    }
+
+    //! Returns the memory pointed to by \p ptr to the pool.
+    //!
+    //! The parameter \p ptr must have been returned by
+    //! FixedSizePool::allocate.
+    static void deallocate(void* ptr) {
+      std::lock_guard<std::mutex> lg(_mtx);
+      Slot* slot  = static_cast<Slot*>(ptr);
+      slot->_next = _free;
+      _free       = slot;
+    }
+
+   private:
+    // The number of objects in every block obtained from the system
+    static size_t const NR_SLOTS = 4096;
+
+    static std::vector<std::unique_ptr<Slot[]>> _blocks;
+    static Slot*                                _free;
+    static std::mutex                           _mtx;
+  };
+
+  template <size_t N>
+  std::vector<std::unique_ptr<typename FixedSizePool<N>::Slot[]>>
+      FixedSizePool<N>::_blocks;
+
+  template <size_t N>
+  typename FixedSizePool<N>::Slot* FixedSizePool<N>::_free = nullptr;
+
+  template <size_t N> std::mutex FixedSizePool<N>::_mtx;
+
+  //! Abstract class for partial transformations of a fixed degree.
+  //!
+  //! This is a template class for partial transformations whose degree \p N
+  //! is known at compile time. The images of the points are stored in an
+  //! array inside the object, rather than in a separately allocated
+  //! std::vector as in PartialTransformation, and the objects are allocated
+  //! using a FixedSizePool. Hence creating a copy of such an element requires
+  //! no call to the global operator new, and a FixedTransformation<8,
+  //! u_int8_t>, for example, uses 32 bytes rather than more than 100 bytes
+  //! for the corresponding Transformation<u_int8_t>.
+  //!
+  //! The template parameter \p S is the type of image values, which must be
+  //! able to represent every value less than or equal to \p N.
+  //!
+  //! The template parameter \p T is the subclass of FixedPartialTransformation
+  //! used by certain methods to construct new instances.
+  //!
+  //! The hash value of a FixedPartialTransformation is the same as that of the
+  //! PartialTransformation with the same images.
+  template <size_t N, typename S, class T>
+  class FixedPartialTransformation : public Element {
+    static_assert(N > 0, "the degree must be positive");
+    static_assert(N - 1 < std::numeric_limits<S>::max(),
+                  "the image type is too small for the degree");
+
+   public:
+    //! A constructor.
+    //!
+    //! Constructs a partial transformation with list of images equal to
+    //! \p vector, which must have size \p N.
+    explicit FixedPartialTransformation(std::vector<S> const& vector)
+        : Element(), _images() {
+      LIBSEMIGROUPS_ASSERT(vector.size() == N);
+      std::copy(vector.begin(), vector.end(), _images.begin());
+    }
+
+    //! A constructor.
+    //!
+    //! Constructs a partial transformation with list of images equal to
+    //! \p images. The parameter \p hv must be the hash value of the element
+    //! being created, or Element::UNDEFINED.
+    FixedPartialTransformation(std::array<S, N> const& images, size_t hv)
+        : Element(hv), _images(images) {}
+
+    //! Allocates memory for an object using a FixedSizePool.
+    static void* operator new(size_t size) {
+      LIBSEMIGROUPS_ASSERT(size == sizeof(T));
+      (void) size;
+      return FixedSizePool<sizeof(T)>::allocate();
+    }
+
+    //! Returns the memory of an object to a FixedSizePool.
+    static void operator delete(void* ptr) {
+      FixedSizePool<sizeof(T)>::deallocate(ptr);
+    }
+
+    //! Returns the image of \p pos.
+    //!
+    //! No checks are performed that \p pos is less than \p N.
+    inline S operator[](size_t pos) const {
+      return _images[pos];
+    }
+
+    //! Returns \c true if \c this equals \p that.
+    bool operator==(Element const& that) const override {
+      return static_cast<T const&>(that)._images == _images;
+    }
+
+    //! Returns \c true if \c this is less than \p that.
+    //!
+    //! This is the lexicographic order on the lists of images, which is the
+    //! same as the order used by ElementWithVectorData for elements of equal
+    //! degree.
+    bool operator<(Element const& that) const override {
+      return _images < static_cast<T const&>(that)._images;
+    }
+
+    //! Returns the approximate time complexity of multiplying two elements,
+    //! which is \p N.
+    size_t complexity() const override {
+      return N;
+    }
+
+    //! Returns the degree \p N.
+    size_t degree() const override {
+      return N;
+    }
+
+    //! Returns a pointer to a copy of \c this.
+    //!
+    //! The degree of a FixedPartialTransformation cannot be changed, and so
+    //! this method asserts that \p increase_deg_by is 0.
+    Element* really_copy(size_t increase_deg_by = 0) const override {
+      LIBSEMIGROUPS_ASSERT(increase_deg_by == 0);
+      (void) increase_deg_by;
+      return new T(_images, this->_hash_value);
+    }
+
+    //! Copy another Element into \c this.
+    void copy(Element const* x) override {
+      LIBSEMIGROUPS_ASSERT(x->degree() == N);
+      _images = static_cast<T const*>(x)->_images;
+      this->reset_hash_value();
+    }
+
+    //! Does nothing, since the defining data of \c this is not allocated
+    //! separately.
+    void really_delete() override {}
+
+    //! Returns the identity transformation of degree \p N.
+    Element* identity() const override {
+      std::array<S, N> images;
+      for (size_t i = 0; i < N; i++) {
+        images[i] = i;
+      }
+      return new T(images, Element::UNDEFINED);
+    }
+
+    //! Find the hash value of a partial transformation.
+    //!
+    //! \sa Element::hash_value for more details.
+    void cache_hash_value() const override {
+      this->_hash_value = hash_images(_images.data(), N);
+    }
+
+    //! Undefined image value.
+    //!
+    //! This value is used to indicate that a partial transformation is not
+    //! defined on a value.
+    static S const UNDEFINED;
+
+   protected:
+    //! The images of the points 0 to \p N - 1.
+    std::array<S, N> _images;
+  };
+
+  template <size_t N, typename S, class T>
+  S const FixedPartialTransformation<N, S, T>::UNDEFINED
+      = std::numeric_limits<S>::max();
+
+  //! Template class for transformations of a fixed degree.
+  //!
+  //! A FixedTransformation&lt;N, S&gt; represents the same mathematical object
+  //! as a Transformation&lt;S&gt; of degree \p N, but uses less memory; see
+  //! FixedPartialTransformation for more details.
+  template <size_t N, typename S = u_int8_t>
+  class FixedTransformation
+      : public FixedPartialTransformation<N, S, FixedTransformation<N, S>> {
+    typedef FixedPartialTransformation<N, S, FixedTransformation<N, S>> base_t;
+
+   public:
+    //! A constructor.
+    //!
+    //! See FixedPartialTransformation::FixedPartialTransformation.
+    explicit FixedTransformation(std::vector<S> const& vector)
+        : base_t(vector) {}
+
+    //! A constructor.
+    //!
+    //! See FixedPartialTransformation::FixedPartialTransformation.
+    FixedTransformation(std::array<S, N> const& images, size_t hv)
+        : base_t(images, hv) {}
+
+    //! Multiply \p x and \p y and stores the result in \c this.
+    //!
+    //! See Element::redefine for more details about this method.
+    void redefine(Element const* x, Element const* y) override {
+      LIBSEMIGROUPS_ASSERT(x->degree() == N && y->degree() == N);
+      LIBSEMIGROUPS_ASSERT(x != this && y != this);
+      auto xx = static_cast<FixedTransformation const*>(x);
+      auto yy = static_cast<FixedTransformation const*>(y);
+      compose(xx->_images.data(), yy->_images.data(), this->_images.data(), N);
+      this->reset_hash_value();
+    }
+  };
+
+  //! Template class for partial permutations of a fixed degree.
+  //!
+  //! A FixedPartialPerm&lt;N, S&gt; represents the same mathematical object
+  //! as a PartialPerm&lt;S&gt; of degree \p N, but uses less memory; see
+  //! FixedPartialTransformation for more details. Note that the order on
+  //! FixedPartialPerm objects is the lexicographic order on their lists of
+  //! images, and not the order used by PartialPerm.
+  template <size_t N, typename S = u_int8_t>
+  class FixedPartialPerm
+      : public FixedPartialTransformation<N, S, FixedPartialPerm<N, S>> {
+    typedef FixedPartialTransformation<N, S, FixedPartialPerm<N, S>> base_t;
+
+   public:
+    //! A constructor.
+    //!
+    //! See FixedPartialTransformation::FixedPartialTransformation.
+    explicit FixedPartialPerm(std::vector<S> const& vector) : base_t(vector) {}
+
+    //! A constructor.
+    //!
+    //! See FixedPartialTransformation::FixedPartialTransformation.
+    FixedPartialPerm(std::array<S, N> const& images, size_t hv)
+        : base_t(images, hv) {}
+
+    //! Multiply \p x and \p y and stores the result in \c this.
+    //!
+    //! See Element::redefine for more details about this method.
+    void redefine(Element const* x, Element const* y) override {
+      LIBSEMIGROUPS_ASSERT(x->degree() == N && y->degree() == N);
+      LIBSEMIGROUPS_ASSERT(x != this && y != this);
+      auto xx = static_cast<FixedPartialPerm const*>(x);
+      auto yy = static_cast<FixedPartialPerm const*>(y);
+      compose_partial(
+          xx->_images.data(), yy->_images.data(), this->_images.data(), N);
+      this->reset_hash_value();
+    }
+  };
+
   //! Class for square boolean matrices.
   //!
   //! A *boolean matrix* is a square matrix over the Boolean semiring, under
@@ -889,9 +1165,122 @@ namespace libsemigroups {
     //!
     //! This method asserts that the dimensions of \p x, \p y, and \c this, are
     //! all equal, and that neither \p x nor \p y equals \c this.
+    //!
+    //! If the dimension is at most 64, then the rows of \p y are packed into
+    //! 64-bit words, and every row of the product is the bitwise or of the
+    //! rows of \p y corresponding to the entries of \p x which are \c true.
     void redefine(Element const* x, Element const* y) override;
   };
 
+  //! Class for square boolean matrices stored as bit strings.
+  //!
+  //! A PackedBooleanMat represents the same boolean matrix as a BooleanMat,
+  //! but every row is stored as a sequence of 64-bit words, in which bit
+  //! \f$j \bmod 64\f$ of word \f$\lfloor j / 64\rfloor\f$ is the entry in
+  //! column \f$j\f$. If the dimension is at most 64, then every row is a single
+  //! word. The product of two matrices is computed by taking the bitwise or
+  //! of whole rows, and hashing and comparison also use whole words, and so
+  //! these operations are much faster than for a BooleanMat.
+  //!
+  //! The order on PackedBooleanMat's defined by PackedBooleanMat::operator<
+  //! is not the same as that on BooleanMat's.
+  class PackedBooleanMat
+      : public ElementWithVectorData<uint64_t, PackedBooleanMat> {
+   public:
+    //! A constructor.
+    //!
+    //! Constructs a boolean matrix of dimension \p dim whose rows are given
+    //! by \p rows, which is not copied, and should be deleted using
+    //! ElementWithVectorData::really_delete. The length of \p rows must be
+    //! \p dim times PackedBooleanMat::nr_words(\p dim), and the bits of
+    //! \p rows which do not correspond to entries of the matrix must be 0.
+    //!
+    //! The parameter \p hv must be the hash value of the element
+    //! being created (this defaults to Element::UNDEFINED). This should only
+    //! be set if it is guaranteed that \p hv is the correct value. See
+    //! Element::Element for more details.
+    PackedBooleanMat(std::vector<uint64_t>* rows,
+                     size_t                 dim,
+                     size_t                 hv = Element::UNDEFINED)
+        : ElementWithVectorData<uint64_t, PackedBooleanMat>(rows, hv),
+          _dim(dim) {
+      LIBSEMIGROUPS_ASSERT(rows->size() == dim * nr_words(dim));
+    }
+
+    //! A constructor.
+    //!
+    //! Constructs a boolean matrix where the entry in row \c i and column
+    //! \c j is \c matrix[i][j].
+    explicit PackedBooleanMat(std::vector<std::vector<bool>> const& matrix);
+
+    //! A constructor.
+    //!
+    //! Constructs a boolean matrix equal to \p x.
+    explicit PackedBooleanMat(BooleanMat const& x);
+
+    //! Returns the number of 64-bit words used for each row of a matrix of
+    //! dimension \p dim.
+    static inline size_t nr_words(size_t dim) {
+      return (dim + 63) / 64;
+    }
+
+    //! Returns the entry in row \p i and column \p j.
+    inline bool get(size_t i, size_t j) const {
+      LIBSEMIGROUPS_ASSERT(i < _dim && j < _dim);
+      return ((*_vector)[i * nr_words(_dim) + j / 64] >> (j % 64)) & 1;
+    }
+
+    //! Returns the approximate time complexity of multiplying two
+    //! boolean matrices.
+    //!
+    //! See Element::complexity for more details.
+    //!
+    //! The approximate time complexity of multiplying packed boolean matrices
+    //! is \f$n ^ 2\lceil n / 64\rceil\f$ where \f$n\f$ is the dimension of
+    //! the matrix.
+    size_t complexity() const override {
+      return _dim * _vector->size();
+    }
+
+    //! Returns the dimension of the boolean matrix.
+    //!
+    //! See Element::degree for more details.
+    size_t degree() const override {
+      return _dim;
+    }
+
+    //! Find the hash value of a boolean matrix.
+    //!
+    //! See Element::hash_value or Element::cache_hash_value for more details.
+    void cache_hash_value() const override;
+
+    //! Returns the identity boolean matrix with dimension of \c this.
+    Element* identity() const override;
+
+    //! Returns a pointer to a copy of \c this.
+    //!
+    //! See Element::really_copy for more details about this method. This
+    //! method asserts that \p increase_deg_by is 0.
+    Element* really_copy(size_t increase_deg_by = 0) const override;
+
+    //! Returns a new matrix which is the transpose of \c this.
+    //!
+    //! The rows of the transpose are the columns of \c this, and so the
+    //! product of \c this and a matrix \c y can also be computed from the
+    //! bitwise and of the rows of \c this and the rows of the transpose of
+    //! \c y.
+    PackedBooleanMat* transpose() const;
+
+    //! Multiplies \p x and \p y and stores the result in \c this.
+    //!
+    //! This method asserts that the dimensions of \p x, \p y, and \c this, are
+    //! all equal, and that neither \p x nor \p y equals \c this.
+    void redefine(Element const* x, Element const* y) override;
+
+   private:
+    size_t _dim;
+  };
+
   //! Class for bipartitions.
   //!
   //! A *bipartition* is a partition of the set
@@ -979,10 +1368,10 @@ namespace libsemigroups {
     //! that the degrees of \p x, \p y, and \c this, are all equal, and that
     //! neither \p x nor  \p y equals \c this.
     //!
-    //! The parameter \p thread_id is required since some temporary storage is
-    //! required to find the product of \p x and \p y.
-    //! Note that if different threads call this method with the same value of
-    //! \p thread_id then bad things will happen.
+    //! The temporary storage required to find the product of \p x and \p y
+    //! belongs to the calling thread, and so the parameter \p thread_id is
+    //! not used, and this method can be called by any number of threads at
+    //! once.
     void redefine(Element const* x,
                   Element const* y,
                   size_t const&  thread_id) override;
@@ -1085,12 +1474,8 @@ namespace libsemigroups {
     }
 
    private:
-    u_int32_t fuseit(std::vector<u_int32_t>& fuse, u_int32_t pos);
     void init_trans_blocks_lookup();
 
-    static std::vector<std::vector<u_int32_t>> _fuse;
-    static std::vector<std::vector<u_int32_t>> _lookup;
-
     size_t            _nr_blocks;
     size_t            _nr_left_blocks;
     std::vector<bool> _trans_blocks_lookup;
@@ -1336,42 +1721,111 @@ namespace libsemigroups {
     //! that the degrees of \p x, \p y, and \c this, are all equal, and that
     //! neither \p x nor  \p y equals \c this.
     //!
-    //! The parameter \p thread_id is required since some temporary storage is
-    //! required to find the product of \p x and \p y.  Note that if different
-    //! threads call this method with the same value of \p thread_id then bad
-    //! things will happen.
+    //! The product is found by packing \p x and \p y into bit strings, as in
+    //! PackedPBR, and the temporary storage required belongs to the calling
+    //! thread, and so the parameter \p thread_id is not used.
     void redefine(Element const* x,
                   Element const* y,
                   size_t const&  thread_id) override;
+  };
+
+  //! Class for partitioned binary relations (PBR) stored as bit strings.
+  //!
+  //! A PackedPBR represents the same PBR as a PBR, but the points adjacent to
+  //! every point are stored as a sequence of 64-bit words, in which bit
+  //! \f$j \bmod 64\f$ of word \f$\lfloor j / 64\rfloor\f$ is set if \f$j\f$
+  //! is adjacent to the point. If the degree is at most 32, then every point
+  //! uses a single word. The storage of a PackedPBR is a single vector of
+  //! fixed size, and the product of two PackedPBR's is computed using the
+  //! bitwise operations on whole words, and so products, hashing, and
+  //! comparison are much faster than for a PBR.
+  //!
+  //! The order on PackedPBR's defined by PackedPBR::operator< is not the same
+  //! as that on PBR's.
+  class PackedPBR : public ElementWithVectorData<uint64_t, PackedPBR> {
+   public:
+    //! A constructor.
+    //!
+    //! Constructs a PBR of degree \p degree whose adjacencies are given by
+    //! \p rows, which is not copied, and should be deleted using
+    //! ElementWithVectorData::really_delete. The length of \p rows must be
+    //! \f$2\f$ times \p degree times PackedPBR::nr_words(\p degree), and the
+    //! bits of \p rows which do not correspond to points must be 0.
+    //!
+    //! The parameter \p hv must be the hash value of the element
+    //! being created (this defaults to Element::UNDEFINED). This should only
+    //! be set if it is guaranteed that \p hv is the correct value. See
+    //! Element::Element for more details.
+    PackedPBR(std::vector<uint64_t>* rows,
+              size_t                 degree,
+              size_t                 hv = Element::UNDEFINED)
+        : ElementWithVectorData<uint64_t, PackedPBR>(rows, hv),
+          _degree(degree) {
+      LIBSEMIGROUPS_ASSERT(rows->size() == 2 * degree * nr_words(degree));
+    }
+
+    //! A constructor.
+    //!
+    //! The parameter \p adj is the same as the parameter of
+    //! PBR::PBR(std::vector<std::vector<u_int32_t>> const&).
+    explicit PackedPBR(std::vector<std::vector<u_int32_t>> const& adj);
+
+    //! A constructor.
+    //!
+    //! Constructs a PackedPBR equal to \p x.
+    explicit PackedPBR(PBR const& x);
+
+    //! Returns the number of 64-bit words used for each point of a PBR of
+    //! degree \p degree.
+    static inline size_t nr_words(size_t degree) {
+      return (2 * degree + 63) / 64;
+    }
+
+    //! Returns \c true if the point \p j is adjacent to the point \p i.
+    inline bool get(size_t i, size_t j) const {
+      LIBSEMIGROUPS_ASSERT(i < 2 * _degree && j < 2 * _degree);
+      return ((*_vector)[i * nr_words(_degree) + j / 64] >> (j % 64)) & 1;
+    }
+
+    //! Returns the approximate time complexity of multiplying PackedPBR's.
+    //!
+    //! The approximate time complexity of multiplying PackedPBR's is
+    //! \f$(2n) ^ 2\lceil 2n / 64\rceil\f$ where \f$n\f$ is the degree.
+    size_t complexity() const override {
+      return 2 * _degree * _vector->size();
+    }
+
+    //! Returns the degree of a PBR.
+    //!
+    //! The *degree* of a PBR is half the number of points in the PBR.
+    size_t degree() const override {
+      return _degree;
+    }
+
+    //! Find the hash value of a PBR.
+    //!
+    //! \sa Element::hash_value.
+    void cache_hash_value() const override;
+
+    //! Returns the identity PBR with degree equal to that of \c this.
+    //!
+    //! \sa PBR::identity.
+    Element* identity() const override;
+
+    //! Returns a pointer to a copy of \c this.
+    //!
+    //! See Element::really_copy for more details about this method. This
+    //! method asserts that \p increase_deg_by is 0.
+    Element* really_copy(size_t increase_deg_by = 0) const override;
+
+    //! Multiply \p x and \p y and stores the result in \c this.
+    //!
+    //! This method asserts that the degrees of \p x, \p y, and \c this, are
+    //! all equal, and that neither \p x nor \p y equals \c this.
+    void redefine(Element const* x, Element const* y) override;
 
    private:
-    void unite_rows(RecVec<bool>& out,
-                    RecVec<bool>& tmp,
-                    size_t const& vertex1,
-                    size_t const& vertex2);
-
-    void x_dfs(std::vector<bool>& x_seen,
-               std::vector<bool>& y_seen,
-               RecVec<bool>&      tmp,
-               u_int32_t const&   n,
-               u_int32_t const&   i,
-               PBR const* const   x,
-               PBR const* const   y,
-               size_t const&      adj);
-
-    void y_dfs(std::vector<bool>& x_seen,
-               std::vector<bool>& y_seen,
-               RecVec<bool>&      tmp,
-               u_int32_t const&   n,
-               u_int32_t const&   i,
-               PBR const* const   x,
-               PBR const* const   y,
-               size_t const&      adj);
-
-    static std::vector<std::vector<bool>> _x_seen;
-    static std::vector<std::vector<bool>> _y_seen;
-    static std::vector<RecVec<bool>>      _out;
-    static std::vector<RecVec<bool>>      _tmp;
+    size_t _degree;
   };
 }  // namespace libsemigroups
 #endif  // LIBSEMIGROUPS_SRC_ELEMENTS_H_
@@ -0,0 +1,161 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains the versions of the functions in kernels.h for u_int8_t,
+// which use SSSE3 if it is available.
+
+#include "kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIBSEMIGROUPS_HAVE_SSSE3_KERNELS
+#include <tmmintrin.h>
+#endif
+
+namespace libsemigroups {
+
+#ifdef LIBSEMIGROUPS_HAVE_SSSE3_KERNELS
+
+  static bool have_ssse3() {
+    // This is called during static initialisation, possibly before the
+    // processor information used by __builtin_cpu_supports is initialised.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+  }
+
+  static bool const HAVE_SSSE3 = have_ssse3();
+
+  // The instruction pshufb(a, b) returns the vector whose ith entry is
+  // a[b[i] & 15] if the most significant bit of b[i] is 0, and 0 otherwise.
+  // Hence if the images of y are stored in K chunks y_0, ..., y_{K - 1} of 16
+  // bytes, then the ith entry of x * y is obtained by looking up x[i] - 16 * k
+  // in y_k for every k, where we ensure that the result is 0 unless
+  // 0 <= x[i] - 16 * k < 16, and taking the bitwise or of the results.
+  //
+  // The degree n must satisfy 16 * (K - 1) < n <= 16 * K. Nothing is read or
+  // written beyond the ends of x, y, and xy: if n is not a multiple of 16,
+  // then the last chunk of x (and of xy) is the last 16 bytes, which overlaps
+  // the previous chunk, and the last chunk of y is loaded in the same way
+  // and then shifted into place with another pshufb. The entries of this
+  // chunk which do not correspond to images of y are never looked up.
+  //
+  // If partial is true, then xy[i] is set to 255 whenever x[i] is 255.
+  template <size_t K>
+  __attribute__((target("ssse3"))) static inline void
+  compose_ssse3(u_int8_t const* x,
+                u_int8_t const* y,
+                u_int8_t*       xy,
+                size_t          n,
+                bool            partial) {
+    __m128i ychunk[K];
+    for (size_t k = 0; k < K - 1; k++) {
+      ychunk[k] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(y + 16 * k));
+    }
+    // The number of images in the last chunk
+    size_t const r    = n - 16 * (K - 1);
+    __m128i      last = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(y + n - 16));
+    if (r != 16) {
+      // Entry i of the shifted chunk is entry i + 16 - r of last.
+      __m128i const shift = _mm_add_epi8(
+          _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+          _mm_set1_epi8(static_cast<char>(16 - r)));
+      last = _mm_shuffle_epi8(last, _mm_and_si128(shift, _mm_set1_epi8(15)));
+    }
+    ychunk[K - 1] = last;
+
+    __m128i const fifteen = _mm_set1_epi8(15);
+    __m128i const sixteen = _mm_set1_epi8(16);
+    __m128i const undef   = _mm_set1_epi8(static_cast<char>(0xFF));
+
+    for (size_t c = 0; c < K; c++) {
+      size_t const  offset = (c == K - 1 ? n - 16 : 16 * c);
+      __m128i const xc
+          = _mm_loadu_si128(reinterpret_cast<__m128i const*>(x + offset));
+      __m128i res;
+      if (K == 1) {
+        res = _mm_shuffle_epi8(ychunk[0], xc);
+      } else {
+        __m128i idx = xc;
+        res         = _mm_setzero_si128();
+        for (size_t k = 0; k < K; k++) {
+          // The entries of idx are x[i] - 16 * k, which are less than 64 and
+          // so positive entries at least 16 are detected by a signed
+          // comparison; negative entries already have their top bit set.
+          __m128i const too_big = _mm_cmpgt_epi8(idx, fifteen);
+          res = _mm_or_si128(
+              res, _mm_shuffle_epi8(ychunk[k], _mm_or_si128(idx, too_big)));
+          idx = _mm_sub_epi8(idx, sixteen);
+        }
+      }
+      if (partial) {
+        res = _mm_or_si128(res, _mm_cmpeq_epi8(xc, undef));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(xy + offset), res);
+    }
+  }
+
+  // Returns true if compose_ssse3 was used.
+  static inline bool compose_ssse3(u_int8_t const* x,
+                                   u_int8_t const* y,
+                                   u_int8_t*       xy,
+                                   size_t          n,
+                                   bool            partial) {
+    if (!HAVE_SSSE3 || n < 16 || n > 64) {
+      return false;
+    } else if (n <= 16) {
+      compose_ssse3<1>(x, y, xy, n, partial);
+    } else if (n <= 32) {
+      compose_ssse3<2>(x, y, xy, n, partial);
+    } else if (n <= 48) {
+      compose_ssse3<3>(x, y, xy, n, partial);
+    } else {
+      compose_ssse3<4>(x, y, xy, n, partial);
+    }
+    return true;
+  }
+
+  void compose(u_int8_t const* x, u_int8_t const* y, u_int8_t* xy, size_t n) {
+    if (!compose_ssse3(x, y, xy, n, false)) {
+      compose<u_int8_t>(x, y, xy, n);
+    }
+  }
+
+  void compose_partial(u_int8_t const* x,
+                       u_int8_t const* y,
+                       u_int8_t*       xy,
+                       size_t          n) {
+    if (!compose_ssse3(x, y, xy, n, true)) {
+      compose_partial<u_int8_t>(x, y, xy, n);
+    }
+  }
+
+#else
+
+  void compose(u_int8_t const* x, u_int8_t const* y, u_int8_t* xy, size_t n) {
+    compose<u_int8_t>(x, y, xy, n);
+  }
+
+  void compose_partial(u_int8_t const* x,
+                       u_int8_t const* y,
+                       u_int8_t*       xy,
+                       size_t          n) {
+    compose_partial<u_int8_t>(x, y, xy, n);
+  }
+
+#endif
+}  // namespace libsemigroups
@@ -0,0 +1,108 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains the functions used to multiply and hash transformations
+// and partial permutations, which are stored as arrays of images.
+//
+// The function templates are the portable versions, which work for every
+// unsigned integer type. The overloads for u_int8_t, which are defined in
+// kernels.cc, use the SSSE3 instruction pshufb when the degree is between 16
+// and 64 and the processor supports it (this is checked at run time), and
+// otherwise call the function templates.
+
+#ifndef LIBSEMIGROUPS_SRC_KERNELS_H_
+#define LIBSEMIGROUPS_SRC_KERNELS_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <limits>
+
+namespace libsemigroups {
+
+  // Compose
+  // @x the images of the first transformation
+  // @y the images of the second transformation
+  // @xy where the images of the product are stored
+  // @n the degree
+  //
+  // Sets **xy[i]** to **y[x[i]]** for every **i** less than **n**. The array
+  // **xy** must not overlap with **x** or **y**.
+
+  template <typename T>
+  inline void compose(T const* x, T const* y, T* xy, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      xy[i] = y[x[i]];
+    }
+  }
+
+  void compose(u_int8_t const* x, u_int8_t const* y, u_int8_t* xy, size_t n);
+
+  // Compose partial
+  // @x the images of the first partial transformation
+  // @y the images of the second partial transformation
+  // @xy where the images of the product are stored
+  // @n the degree
+  //
+  // This is the same as <compose> except that **xy[i]** is
+  // std::numeric_limits<T>::max(), which indicates that the image of **i** is
+  // undefined, if **x[i]** is.
+
+  template <typename T>
+  inline void compose_partial(T const* x, T const* y, T* xy, size_t n) {
+    T const undef = std::numeric_limits<T>::max();
+    for (size_t i = 0; i < n; i++) {
+      xy[i] = (x[i] == undef ? undef : y[x[i]]);
+    }
+  }
+
+  void compose_partial(u_int8_t const* x,
+                       u_int8_t const* y,
+                       u_int8_t*       xy,
+                       size_t          n);
+
+  // Hash images
+  // @x the images
+  // @n the degree
+  //
+  // @return the value of **x[0] * n ^ (n - 1) + x[1] * n ^ (n - 2) + ... +
+  // x[n - 1]** modulo 2 ^ 64 (or the size of size_t). This is computed 4
+  // images at a time, so that the successive multiplications do not all
+  // depend on each other.
+
+  template <typename T> inline size_t hash_images(T const* x, size_t n) {
+    size_t const n2   = n * n;
+    size_t const n3   = n2 * n;
+    size_t const n4   = n2 * n2;
+    size_t       seed = 0;
+    size_t       i    = 0;
+    for (; i + 4 <= n; i += 4) {
+      seed = seed * n4
+             + (static_cast<size_t>(x[i]) * n3
+                + static_cast<size_t>(x[i + 1]) * n2
+                + static_cast<size_t>(x[i + 2]) * n
+                + static_cast<size_t>(x[i + 3]));
+    }
+    for (; i < n; i++) {
+      seed = seed * n + static_cast<size_t>(x[i]);
+    }
+    return seed;
+  }
+}  // namespace libsemigroups
+
+#endif  // LIBSEMIGROUPS_SRC_KERNELS_H_
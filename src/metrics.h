@@ -0,0 +1,124 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2016 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+// This file contains a class for counters which can be incremented by several
+// threads at the same time, which are used to collect metrics about the
+// enumeration of a Semigroup.
+
+#ifndef LIBSEMIGROUPS_SRC_METRICS_H_
+#define LIBSEMIGROUPS_SRC_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "libsemigroups-debug.h"
+
+namespace libsemigroups {
+
+  //
+  // Template class for **N** counters, which can be incremented by several
+  // threads at the same time without contention. Every thread has its own
+  // copy of the counters, chosen by its thread id, which is padded so that
+  // the copies of different threads are (probably) in different cache lines.
+  // Since only one thread writes to each copy, the counters are incremented
+  // by relaxed atomic loads and stores, rather than read-modify-write
+  // operations, and so nothing is locked. The copies of all of the threads
+  // are added together when a counter is read, which can happen at any time.
+  //
+  // If two threads whose thread ids are equal modulo <NR_COPIES> increment
+  // the same counter at the same time, then one of the increments may be
+  // lost.
+
+  template <size_t N> class Counters {
+   public:
+    // Default constructor
+    //
+    // Constructs counters which are all 0.
+    Counters() : _copies() {
+      reset();
+    }
+
+    // Copy constructor
+    //
+    // Constructs counters which are all 0, rather than copying anything, so
+    // that counters count only what happens to the object containing them.
+    Counters(Counters const&) : Counters() {}
+
+    Counters& operator=(Counters const&) = delete;
+
+    // Add
+    // @tid the thread id of the calling thread
+    // @i the index of the counter
+    // @n the value to add (defaults to 1)
+    //
+    // Adds **n** to the counter with index **i** in the copy for the thread
+    // with id **tid**.
+    // @return the value of the counter in this copy before **n** was added.
+    uint64_t add(size_t tid, size_t i, uint64_t n = 1) {
+      LIBSEMIGROUPS_ASSERT(i < N);
+      std::atomic<uint64_t>& value = _copies[tid % NR_COPIES]._values[i];
+      uint64_t const         old   = value.load(std::memory_order_relaxed);
+      value.store(old + n, std::memory_order_relaxed);
+      return old;
+    }
+
+    // Get (const)
+    // @i the index of the counter
+    //
+    // This method is const.
+    // @return the sum of the values of the counter with index **i** over all
+    // threads.
+    uint64_t get(size_t i) const {
+      LIBSEMIGROUPS_ASSERT(i < N);
+      uint64_t n = 0;
+      for (Copy const& copy : _copies) {
+        n += copy._values[i].load(std::memory_order_relaxed);
+      }
+      return n;
+    }
+
+    // Reset
+    //
+    // Sets every counter to 0.
+    void reset() {
+      for (Copy& copy : _copies) {
+        for (std::atomic<uint64_t>& value : copy._values) {
+          value.store(0, std::memory_order_relaxed);
+        }
+      }
+    }
+
+   private:
+    static size_t const NR_COPIES       = 64;
+    static size_t const CACHE_LINE_SIZE = 64;
+    static size_t const PADDING
+        = CACHE_LINE_SIZE - (N * sizeof(uint64_t)) % CACHE_LINE_SIZE;
+
+    struct Copy {
+      std::atomic<uint64_t> _values[N];
+      char                  _padding[PADDING];
+    };
+
+    Copy _copies[NR_COPIES];
+  };
+}  // namespace libsemigroups
+
+#endif  // LIBSEMIGROUPS_SRC_METRICS_H_
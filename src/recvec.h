@@ -23,18 +23,21 @@
 #include <vector>
 
 #include "libsemigroups-debug.h"
+#include "storage.h"
 
 namespace libsemigroups {
 
   //
   // Template class for *rectangular vectors* i.e. two dimensional vectors.
-  // The unique template parameter **T** is the type of the objects stored in
-  // the <RecVec>.
+  // The template parameter **T** is the type of the objects stored in the
+  // <RecVec>, and **TStorage** is the type of the one dimensional container
+  // in which they are stored, row by row, which can be std::vector<T> (the
+  // default) or one of the storage policies in storage.h.
 
-  template <typename T> class RecVec {
+  template <typename T, class TStorage = std::vector<T>> class RecVec {
     // So that RecVec<T> can access private data members of RecVec<S> and vice
     // versa.
-    template <typename S> friend class RecVec;
+    template <typename S, class U> friend class RecVec;
 
    public:
     // Default constructor
@@ -62,17 +65,17 @@ namespace libsemigroups {
     // Constructs a copy of the given <RecVec> with the same number of rows as
     // the original and with some additional columns.
 
-    template <typename S>
-    RecVec(RecVec<S> const& copy, size_t nr_cols_to_add)
+    template <typename S, class U>
+    RecVec(RecVec<S, U> const& copy, size_t nr_cols_to_add)
         : _vec(),
           _nr_used_cols(copy._nr_used_cols),
           _nr_unused_cols(copy._nr_unused_cols),
           _nr_rows(copy.nr_rows()),
           _default_val(copy._default_val) {
       if (nr_cols_to_add <= _nr_unused_cols) {
-        _vec.reserve(copy._vec.size());
-        for (auto const& x : copy._vec) {
-          _vec.push_back(static_cast<T>(x));
+        _vec.resize(copy._vec.size());
+        for (size_t k = 0; k < copy._vec.size(); k++) {
+          _vec[k] = static_cast<T>(copy._vec[k]);
         }
         _nr_used_cols += nr_cols_to_add;
         _nr_unused_cols -= nr_cols_to_add;
@@ -84,15 +87,11 @@ namespace libsemigroups {
       _nr_used_cols += nr_cols_to_add;
       _nr_unused_cols = new_nr_cols - _nr_used_cols;
 
-      _vec.reserve(new_nr_cols * _nr_rows);
+      _vec.resize(new_nr_cols * _nr_rows, _default_val);
 
       for (size_t i = 0; i < _nr_rows; i++) {
-        size_t j;
-        for (j = 0; j < copy._nr_used_cols; j++) {
-          _vec.push_back(copy.get(i, j));
-        }
-        for (; j < new_nr_cols; j++) {
-          _vec.push_back(_default_val);
+        for (size_t j = 0; j < copy._nr_used_cols; j++) {
+          _vec[i * new_nr_cols + j] = static_cast<T>(copy.get(i, j));
         }
       }
     }
@@ -116,6 +115,17 @@ namespace libsemigroups {
       }
     }
 
+    // Reserve rows
+    // @nr the total number of rows
+    //
+    // Allocates enough memory for the <RecVec> to have the specified number
+    // of rows, so that adding rows up to this number does not reallocate the
+    // underlying storage.
+
+    void reserve(size_t nr) {
+      _vec.reserve((_nr_used_cols + _nr_unused_cols) * nr);
+    }
+
     // Add columns
     // @nr the number of columns to add (no default value)
     //
@@ -139,15 +149,17 @@ namespace libsemigroups {
       if (_nr_rows != 0) {
         _vec.resize(new_nr_cols * _nr_rows, _default_val);
 
-        typename std::vector<T>::iterator old_it(
-            _vec.begin() + (old_nr_cols * _nr_rows) - old_nr_cols);
-        typename std::vector<T>::iterator new_it(
-            _vec.begin() + (new_nr_cols * _nr_rows) - new_nr_cols);
-
-        while (old_it != _vec.begin()) {
-          std::move(old_it, old_it + _nr_used_cols, new_it);
-          old_it -= old_nr_cols;
-          new_it -= new_nr_cols;
+        // Move the rows, starting from the last, so that no row is
+        // overwritten before it is moved, and fill the new columns with the
+        // default value.
+        for (size_t i = _nr_rows; i-- > 0;) {
+          for (size_t j = _nr_used_cols; j-- > 0;) {
+            _vec[i * new_nr_cols + j]
+                = static_cast<T>(_vec[i * old_nr_cols + j]);
+          }
+          for (size_t j = _nr_used_cols; j < new_nr_cols; j++) {
+            _vec[i * new_nr_cols + j] = _default_val;
+          }
         }
       }
       _nr_used_cols += nr;
@@ -197,6 +209,15 @@ namespace libsemigroups {
       return _nr_rows == 0;
     }
 
+    // Memory usage (const)
+    //
+    // This method is const.
+    // @return the number of bytes allocated by the underlying storage, which
+    // may be more than is required for <size> values.
+    size_t bytes() const {
+      return storage_bytes(_vec);
+    }
+
     // Number of rows (const)
     //
     // This method is const.
@@ -222,17 +243,17 @@ namespace libsemigroups {
     // <nr_cols> of **this** and **copy** are equal.
     //
     // Asserts that the numbers of columns are equal.
-    template <typename S> void append(const RecVec<S>& copy) {
+    template <typename S, class U> void append(const RecVec<S, U>& copy) {
       LIBSEMIGROUPS_ASSERT(copy._nr_used_cols == _nr_used_cols);
 
       size_t old_nr_rows = _nr_rows;
       add_rows(copy._nr_rows);
 
       if (copy._nr_unused_cols == _nr_unused_cols) {
-        std::copy(copy._vec.begin(),
-                  copy._vec.end(),
-                  _vec.begin()
-                      + (_nr_used_cols + _nr_unused_cols) * old_nr_rows);
+        size_t const offset = (_nr_used_cols + _nr_unused_cols) * old_nr_rows;
+        for (size_t k = 0; k < copy._vec.size(); k++) {
+          _vec[offset + k] = static_cast<T>(copy._vec[k]);
+        }
       } else {  // TODO(JDM) improve this
         for (size_t i = old_nr_rows; i < _nr_rows; i++) {
           for (size_t j = 0; j < _nr_used_cols; j++) {
@@ -261,33 +282,33 @@ namespace libsemigroups {
       return std::all_of(row_cbegin(i), row_cend(i), pred);
     }
 
-    inline typename std::vector<T>::iterator row_begin(size_t i) {
+    inline typename TStorage::iterator row_begin(size_t i) {
       return _vec.begin() + (_nr_used_cols + _nr_unused_cols) * i;
     }
 
-    inline typename std::vector<T>::iterator row_end(size_t i) {
+    inline typename TStorage::iterator row_end(size_t i) {
       return row_begin(i) + _nr_used_cols;
     }
 
-    inline typename std::vector<T>::const_iterator row_cbegin(size_t i) const {
+    inline typename TStorage::const_iterator row_cbegin(size_t i) const {
       return _vec.cbegin() + (_nr_used_cols + _nr_unused_cols) * i;
     }
 
-    inline typename std::vector<T>::const_iterator row_cend(size_t i) const {
+    inline typename TStorage::const_iterator row_cend(size_t i) const {
       return row_cbegin(i) + _nr_used_cols;
     }
 
     // Iterator
     //
     // @return an iterator pointing at the beginning of the <RecVec>.
-    inline typename std::vector<T>::iterator begin() {
+    inline typename TStorage::iterator begin() {
       return _vec.begin();
     }
 
     // Iterator
     //
     // @return an iterator pointing at the end of the <RecVec>.
-    inline typename std::vector<T>::iterator end() {
+    inline typename TStorage::iterator end() {
       return _vec.end();
     }
 
@@ -302,7 +323,7 @@ namespace libsemigroups {
     }
 
    private:
-    std::vector<T> _vec;
+    TStorage       _vec;
     size_t         _nr_used_cols;
     size_t         _nr_unused_cols;
     size_t         _nr_rows;
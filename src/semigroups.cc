@@ -17,6 +17,20 @@
 //
 
 #include "semigroups.h"
+
+#include <stdint.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+
 #include "rwse.h"
 
 namespace libsemigroups {
@@ -29,8 +43,148 @@ namespace libsemigroups {
   Semigroup::index_t const Semigroup::LIMIT_MAX
       = std::numeric_limits<index_t>::max();
 
+  // One in every METRICS_SAMPLE_PERIOD products computed by every thread in
+  // Semigroup::enumerate is timed, to estimate the time spent in
+  // Element::redefine and looking up elements for Semigroup::metrics. This
+  // must be a power of 2.
+  static uint64_t const METRICS_SAMPLE_PERIOD = 256;
+
+  // The indices of the counters in Semigroup::_counters. Every product is
+  // looked up, and COUNTER_LOOKUPS counts only the other lookups.
+  enum {
+    COUNTER_PRODUCTS = 0,
+    COUNTER_LOOKUPS,
+    COUNTER_SAMPLES,
+    COUNTER_SAMPLED_REDEFINE_TIME,
+    COUNTER_SAMPLED_LOOKUP_TIME
+  };
+
+  // The time, in nanoseconds, which a call to Semigroup::enumerate should not
+  // exceed when the batch size is adaptive.
+  static int64_t const ADAPTIVE_BATCH_TIME = 100000000;
+
+  // The number of elements of the same length whose products with the
+  // generators are computed at once, when Semigroup::enumerate uses more than
+  // 1 thread. Fewer elements than this are always enumerated in 1 thread.
+  static size_t const PARALLEL_CHUNK_SIZE = 4096;
+
+  // The number of elements checked at once by every thread in
+  // Semigroup::find_idempotents, which must be a multiple of 64. Fewer
+  // elements than this are always checked in 1 thread.
+  static size_t const IDEMPOTENTS_CHUNK_SIZE = 4096;
+
+  // The number of elements in every run sorted by Semigroup::sort_elements
+  // before the runs are merged. Fewer elements than four times this are
+  // always sorted in 1 thread.
+  static size_t const SORT_CHUNK_SIZE = 4096;
+
+  // The number of words, or pairs of positions, processed at once by every
+  // thread in the batch versions of Semigroup::word_to_pos and
+  // Semigroup::fast_product. Fewer than this are always processed in 1 thread.
+  static size_t const BATCH_CHUNK_SIZE = 4096;
+
+  // The number of independent paths in a Cayley graph followed at the same
+  // time in the batch versions of Semigroup::word_to_pos and
+  // Semigroup::fast_product, so that the loads for one path do not have to
+  // wait for those of another.
+  static size_t const BATCH_NR_PATHS = 8;
+
+  // The number of elements in every shard of Semigroup::relations, whose
+  // relations are found by a single thread. Fewer elements than this always
+  // have their relations found in 1 thread.
+  static size_t const RELATIONS_SHARD_SIZE = 4096;
+
+  // The number of elements whose minimal factorisations are found at once by
+  // every thread in Semigroup::minimal_factorisations. If there are fewer
+  // elements than this of some length, then their factorisations are found
+  // in 1 thread.
+  static size_t const FACTORISATIONS_CHUNK_SIZE = 4096;
+
+  // The least number of possible new generators, and the least size of the
+  // semigroup, for which Semigroup::closure adds them all at once, rather
+  // than one at a time. This uses a temporary copy of the semigroup, which is
+  // not worthwhile for a few generators or a small semigroup.
+  static size_t const CLOSURE_BATCH_SIZE   = 8;
+  static size_t const CLOSURE_BATCH_MIN_NR = 4096;
+
+  // Calls the function f in each of nr_threads threads, or in this thread if
+  // nr_threads is 1, and waits for them all to return.
+  template <typename TFunction>
+  static void run_in_threads(size_t nr_threads, TFunction f) {
+    if (nr_threads == 1) {
+      f();
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nr_threads; i++) {
+      threads.push_back(std::thread(f));
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // The operations on elements used in the main loop of Semigroup::enumerate.
+  // For a subclass TElement of Element, the methods of TElement are called
+  // using qualified names, so that they are not virtual calls and can be
+  // inlined, as required by FroidurePin<TElement>. The specialisation for
+  // Element itself, which is used by Semigroup, calls the virtual methods.
+  template <class TElement> struct ElementOps {
+    // The product of x and y is stored in xy.
+    static inline void redefine(Element*       xy,
+                                Element const* x,
+                                Element const* y,
+                                size_t const&  thread_id) {
+      redefine(static_cast<TElement*>(xy), x, y, thread_id, 0);
+    }
+
+    // Compares elements of type TElement, for use with ElementMap::find.
+    struct Equal {
+      bool operator()(Element const* x, Element const* y) const {
+        return static_cast<TElement const*>(x)->TElement::operator==(*y);
+      }
+    };
+
+   private:
+    // Some subclasses of Element define the version of redefine with a
+    // thread_id parameter, and some do not. The first overload is preferred
+    // when it exists, since the int argument 0 is an exact match.
+    template <class T>
+    static inline auto redefine(T*             xy,
+                                Element const* x,
+                                Element const* y,
+                                size_t const&  thread_id,
+                                int) -> decltype(xy->T::redefine(x, y, 0)) {
+      xy->T::redefine(x, y, thread_id);
+    }
+
+    template <class T>
+    static inline void redefine(T*             xy,
+                                Element const* x,
+                                Element const* y,
+                                size_t const&,
+                                long) {  // NOLINT(runtime/int)
+      xy->T::redefine(x, y);
+    }
+  };
+
+  template <> struct ElementOps<Element> {
+    static inline void redefine(Element*       xy,
+                                Element const* x,
+                                Element const* y,
+                                size_t const&  thread_id) {
+      xy->redefine(x, y, thread_id);
+    }
+
+    typedef Element::Equal Equal;
+  };
+
   Semigroup::Semigroup(std::vector<Element*> const* gens)
-      : _batch_size(8192),
+      : _adaptive_batch_size(false),
+        _batch_hook(),
+        _batch_size(8192),
+        _batch_size_threshold(LIMIT_MAX),
+        _counters(),
         _degree(UNDEFINED),
         _duplicate_gens(),
         _elements(new std::vector<Element*>()),
@@ -40,18 +194,22 @@ namespace libsemigroups {
         _gens(new std::vector<Element*>()),
         _id(),
         _idempotents(),
-        _idempotents_found(false),
         _idempotents_start_pos(0),
         _is_idempotent(),
         _enumerate_order(),
+        _enumerating(false),
+        _epoch(0),
         _left(new cayley_graph_t(gens->size())),
         _length(),
         _lenindex(),
         _letter_to_pos(),
-        _map(),
+        _map(_elements),
         _max_threads(std::thread::hardware_concurrency()),
+        _min_batch_size(8192),
         _multiplied(),
         _nr(0),
+        _nr_readers(0),
+        _nr_waiting(0),
         _nrgens(gens->size()),
         _nridempotents(0),
         _nrrules(0),
@@ -64,8 +222,12 @@ namespace libsemigroups {
         _relation_pos(UNDEFINED),
         _right(new cayley_graph_t(gens->size())),
         _sorted(nullptr),
+        _sorted_elements(nullptr),
         _suffix(),
-        _wordlen(0) {  // (length of the current word) - 1
+        _time_by_length(),
+        _time_enumerate(0),
+        _wordlen(0),  // (length of the current word) - 1
+        _writing(false) {
     LIBSEMIGROUPS_ASSERT(_nrgens != 0);
 
     reserve(_nrgens);
@@ -83,12 +245,12 @@ namespace libsemigroups {
 
     // add the generators
     for (letter_t i = 0; i < _nrgens; i++) {
-      auto it = _map.find((*_gens)[i]);
-      if (it != _map.end()) {  // duplicate generator
-        _letter_to_pos.push_back(it->second);
+      element_index_t pos = _map.find((*_gens)[i]);
+      if (pos != UNDEFINED) {  // duplicate generator
+        _letter_to_pos.push_back(pos);
         _nrrules++;
-        _duplicate_gens.push_back(std::make_pair(i, _first[it->second]));
-        // i.e. _gens[i] = _gens[_first[it->second]]
+        _duplicate_gens.push_back(std::make_pair(i, _first[pos]));
+        // i.e. _gens[i] = _gens[_first[pos]]
         // _first maps from element_index_t -> letter_t :)
       } else {
         is_one((*_gens)[i], _nr);
@@ -101,7 +263,7 @@ namespace libsemigroups {
         _enumerate_order.push_back(_nr);
         _letter_to_pos.push_back(_nr);
         _length.push_back(1);
-        _map.insert(std::make_pair(_elements->back(), _nr));
+        _map.insert(_elements->back(), _nr);
         _prefix.push_back(UNDEFINED);
         _suffix.push_back(UNDEFINED);
         _nr++;
@@ -116,7 +278,11 @@ namespace libsemigroups {
   // Copy constructor
 
   Semigroup::Semigroup(const Semigroup& copy)
-      : _batch_size(copy._batch_size),
+      : _adaptive_batch_size(copy._adaptive_batch_size),
+        _batch_hook(copy._batch_hook),
+        _batch_size(copy._batch_size),
+        _batch_size_threshold(copy._batch_size_threshold),
+        _counters(),
         _degree(copy._degree),
         _duplicate_gens(copy._duplicate_gens),
         _elements(new std::vector<Element*>()),
@@ -126,17 +292,22 @@ namespace libsemigroups {
         _gens(new std::vector<Element*>()),
         _id(copy._id->really_copy()),
         _idempotents(copy._idempotents),
-        _idempotents_found(copy._idempotents_found),
         _idempotents_start_pos(copy._idempotents_start_pos),
         _is_idempotent(copy._is_idempotent),
         _enumerate_order(copy._enumerate_order),
+        _enumerating(false),
+        _epoch(0),
         _left(new cayley_graph_t(*copy._left)),
         _length(copy._length),
         _lenindex(copy._lenindex),
         _letter_to_pos(copy._letter_to_pos),
+        _map(_elements),
         _max_threads(copy._max_threads),
+        _min_batch_size(copy._min_batch_size),
         _multiplied(copy._multiplied),
         _nr(copy._nr),
+        _nr_readers(0),
+        _nr_waiting(0),
         _nrgens(copy._nrgens),
         _nridempotents(copy._nridempotents),
         _nrrules(copy._nrrules),
@@ -149,8 +320,12 @@ namespace libsemigroups {
         _relation_pos(copy._relation_pos),
         _right(new cayley_graph_t(*copy._right)),
         _sorted(nullptr),  // TODO(JDM) copy this if set
+        _sorted_elements(nullptr),
         _suffix(copy._suffix),
-        _wordlen(copy._wordlen) {
+        _time_by_length(),
+        _time_enumerate(0),
+        _wordlen(copy._wordlen),
+        _writing(false) {
     _elements->reserve(_nr);
     _map.reserve(_nr);
     _tmp_product = copy._id->really_copy();
@@ -159,7 +334,7 @@ namespace libsemigroups {
     for (Element const* x : *(copy._elements)) {
       Element* y = x->really_copy();
       _elements->push_back(y);
-      _map.insert(std::make_pair(y, i++));
+      _map.insert(y, i++);
     }
     copy_gens();
   }
@@ -169,7 +344,13 @@ namespace libsemigroups {
   // <add_generators> or <closure> should usually be called after this.
   Semigroup::Semigroup(Semigroup const& copy, std::vector<Element*> const* coll)
       // TODO(JDM) Element const*
-      : _batch_size(copy._batch_size),
+      : _adaptive_batch_size(copy._adaptive_batch_size),
+        // The hook is not copied, since it may refer to <copy>, and this may
+        // be a temporary used by <closure>
+        _batch_hook(),
+        _batch_size(copy._batch_size),
+        _batch_size_threshold(copy._batch_size_threshold),
+        _counters(),
         _degree(copy._degree),  // copy for comparison in add_generators
         _duplicate_gens(copy._duplicate_gens),
         _elements(new std::vector<Element*>()),
@@ -177,14 +358,19 @@ namespace libsemigroups {
                                       // add_generators
         _gens(new std::vector<Element*>()),
         _idempotents(copy._idempotents),
-        _idempotents_found(copy._idempotents_found),
         _idempotents_start_pos(copy._idempotents_start_pos),
         _is_idempotent(copy._is_idempotent),
+        _enumerating(false),
+        _epoch(0),
         _left(new cayley_graph_t(*copy._left)),
         _letter_to_pos(copy._letter_to_pos),
+        _map(_elements),
         _max_threads(copy._max_threads),
+        _min_batch_size(copy._min_batch_size),
         _multiplied(copy._multiplied),
         _nr(copy._nr),
+        _nr_readers(0),
+        _nr_waiting(0),
         _nrgens(copy._nrgens),
         _nridempotents(copy._nridempotents),
         _nrrules(0),
@@ -197,7 +383,11 @@ namespace libsemigroups {
         _relation_pos(UNDEFINED),
         _right(new cayley_graph_t(*copy._right)),
         _sorted(nullptr),
-        _wordlen(0) {
+        _sorted_elements(nullptr),
+        _time_by_length(),
+        _time_enumerate(0),
+        _wordlen(0),
+        _writing(false) {
     LIBSEMIGROUPS_ASSERT(!coll->empty());
     LIBSEMIGROUPS_ASSERT(coll->at(0)->degree() >= copy.degree());
 
@@ -247,7 +437,7 @@ namespace libsemigroups {
     for (Element const* x : *(copy._elements)) {
       Element* y = x->really_copy(deg_plus);
       _elements->push_back(y);
-      _map.insert(std::make_pair(y, i));
+      _map.insert(y, i);
       is_one(y, i++);
     }
     copy_gens();  // copy the old generators
@@ -266,6 +456,7 @@ namespace libsemigroups {
     delete _left;
     delete _right;
     delete _sorted;
+    delete _sorted_elements;
     delete _pos_sorted;
 
     // delete those generators not in _elements, i.e. the duplicate ones
@@ -320,6 +511,22 @@ namespace libsemigroups {
     return out;
   }
 
+  void Semigroup::word_to_pos(std::vector<word_t> const&    words,
+                              std::vector<element_index_t>& result) const {
+    result.resize(words.size());
+    size_t const nr_chunks
+        = (words.size() + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE;
+    size_t const nr_threads
+        = std::max(size_t(1), std::min(_max_threads, nr_chunks));
+    std::atomic<size_t> next_chunk(0);
+    if (nr_threads > 1) {
+      glob_reporter.reset_thread_ids();
+    }
+    run_in_threads(nr_threads, [this, &words, &result, &next_chunk]() {
+      word_to_pos_thread(words, result, next_chunk);
+    });
+  }
+
   Element* Semigroup::word_to_element(word_t const& w) const {
     LIBSEMIGROUPS_ASSERT(w.size() > 0);
     if (is_done() || w.size() == 1) {
@@ -365,41 +572,59 @@ namespace libsemigroups {
       return product_by_reduction(i, j);
     } else {
       _tmp_product->redefine((*_elements)[i], (*_elements)[j]);
-      return _map.find(_tmp_product)->second;
+      return _map.find(_tmp_product);
     }
   }
 
+  void Semigroup::fast_product(
+      std::vector<std::pair<element_index_t, element_index_t>> const& pairs,
+      std::vector<element_index_t>& result) const {
+    result.resize(pairs.size());
+    size_t const nr_chunks
+        = (pairs.size() + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE;
+    size_t const nr_threads
+        = std::max(size_t(1), std::min(_max_threads, nr_chunks));
+    std::atomic<size_t> next_chunk(0);
+    if (nr_threads > 1) {
+      glob_reporter.reset_thread_ids();
+    }
+    run_in_threads(nr_threads, [this, &pairs, &result, &next_chunk]() {
+      fast_product_thread(pairs, result, next_chunk);
+    });
+  }
+
   // Get the number of idempotents
   size_t Semigroup::nridempotents() {
-    if (!_idempotents_found) {
-      find_idempotents();
-    }
+    enumerate();
+    find_idempotents();
+    return _nridempotents;
+  }
+
+  size_t Semigroup::current_nridempotents() {
+    find_idempotents();
     return _nridempotents;
   }
 
   bool Semigroup::is_idempotent(element_index_t pos) {
-    if (!_idempotents_found) {
-      find_idempotents();
-    }
-    LIBSEMIGROUPS_ASSERT(pos < size());
-    return _is_idempotent[pos];
+    enumerate(pos + 1);
+    LIBSEMIGROUPS_ASSERT(pos < _nr);
+    find_idempotents();
+    return (_is_idempotent[pos / 64] >> (pos % 64)) & 1;
   }
 
   // Const iterator to the first position of an idempotent
 
   typename std::vector<Semigroup::element_index_t>::const_iterator
   Semigroup::idempotents_cbegin() {
-    if (!_idempotents_found) {
-      find_idempotents();
-    }
+    enumerate();
+    find_idempotents();
     return _idempotents.cbegin();
   }
 
   typename std::vector<Semigroup::element_index_t>::const_iterator
   Semigroup::idempotents_cend() {
-    if (!_idempotents_found) {
-      find_idempotents();
-    }
+    enumerate();
+    find_idempotents();
     return _idempotents.cend();
   }
 
@@ -411,30 +636,99 @@ namespace libsemigroups {
     }
 
     while (true) {
-      auto it = _map.find(x);
-      if (it != _map.end()) {
-        return it->second;
+      begin_read();
+      element_index_t const pos   = _map.find(x);
+      bool const            done  = is_done();
+      index_t const         nr    = _nr;
+      size_t const          epoch = _epoch;
+      end_read();
+      if (pos != UNDEFINED) {
+        return pos;
       }
-      if (is_done()) {
+      if (done) {
         return UNDEFINED;
       }
-      enumerate(_nr + 1);
-      // _nr + 1 means we enumerate _batch_size more elements
+      enumerate_or_wait(nr + 1, epoch);
+      // nr + 1 means we enumerate _batch_size more elements
+    }
+  }
+
+  Semigroup::element_index_t Semigroup::current_position(Element* x) const {
+    if (x->degree() != _degree) {
+      return UNDEFINED;
+    }
+    begin_read();
+    element_index_t const pos = _map.find(x);
+    end_read();
+    return pos;
+  }
+
+  Semigroup::metrics_t Semigroup::metrics() const {
+    metrics_t out;
+    begin_read();
+    out.nr_products = _counters.get(COUNTER_PRODUCTS);
+    out.nr_lookups  = out.nr_products + _counters.get(COUNTER_LOOKUPS);
+    _map.probes(out.nr_probes, out.nr_collisions);
+    out.nr_rules = _nrrules;
+
+    for (size_t k = 1; k < _lenindex.size() && _lenindex[k - 1] < _nr; k++) {
+      out.nr_elements_by_length.push_back(_lenindex[k] - _lenindex[k - 1]);
     }
+    if (_lenindex.back() < _nr) {  // some longer elements have been found
+      out.nr_elements_by_length.push_back(_nr - _lenindex.back());
+    }
+    out.time_by_length = _time_by_length;
+    out.time_by_length.resize(out.nr_elements_by_length.size(), 0);
+    out.time_enumerate = _time_enumerate;
+
+    out.memory_cayley_graphs = _right->bytes() + _left->bytes();
+    out.memory_hash_table    = _map.bytes();
+    out.memory_words         = (_enumerate_order.capacity() + _prefix.capacity()
+                                + _suffix.capacity())
+                               * sizeof(element_index_t);
+    out.memory_words
+        += (_first.capacity() + _final.capacity()) * sizeof(letter_t);
+    out.memory_words += _length.capacity() * sizeof(index_t);
+    out.memory_words += _lenindex.capacity() * sizeof(enumerate_index_t);
+    out.memory_other = _elements->capacity() * sizeof(Element*)
+                       + _reduced.size() / 8 + _multiplied.capacity() / 8
+                       + _idempotents.capacity() * sizeof(element_index_t)
+                       + _is_idempotent.capacity() * sizeof(uint64_t);
+    if (_sorted != nullptr) {
+      out.memory_other += 2 * _sorted->capacity() * sizeof(element_index_t);
+    }
+    end_read();
+
+    // The times of the sampled products are scaled up to estimate the times
+    // for all of the products.
+    uint64_t const nr_samples = _counters.get(COUNTER_SAMPLES);
+    if (nr_samples == 0) {
+      out.time_redefine = 0;
+      out.time_lookup   = 0;
+    } else {
+      out.time_redefine = static_cast<int64_t>(
+          static_cast<double>(_counters.get(COUNTER_SAMPLED_REDEFINE_TIME))
+          * out.nr_products / nr_samples);
+      out.time_lookup = static_cast<int64_t>(
+          static_cast<double>(_counters.get(COUNTER_SAMPLED_LOOKUP_TIME))
+          * out.nr_lookups / nr_samples);
+    }
+    out.time_bookkeeping = std::max(
+        int64_t(0), out.time_enumerate - out.time_redefine - out.time_lookup);
+    return out;
+  }
+
+  void Semigroup::reset_metrics() {
+    _counters.reset();
+    _time_by_length.clear();
+    _time_enumerate = 0;
   }
 
   Semigroup::element_index_t
   Semigroup::position_to_sorted_position(element_index_t pos) {
-    enumerate(LIMIT_MAX);
+    sort_elements();
     if (pos >= _nr) {
       return UNDEFINED;
-    } else if (_pos_sorted == nullptr) {
-      sort_elements();
-      _pos_sorted = new std::vector<element_index_t>();
-      _pos_sorted->resize(_sorted->size());
-      for (element_index_t i = 0; i < _sorted->size(); i++) {
-        (*_pos_sorted)[(*_sorted)[i].second] = i;
-      }
     }
     return (*_pos_sorted)[pos];
   }
@@ -444,24 +738,42 @@ namespace libsemigroups {
   }
 
   Element* Semigroup::at(element_index_t pos) {
-    enumerate(pos + 1);
-
-    if (pos < _elements->size()) {
-      return (*_elements)[pos];
-    } else {
-      return nullptr;
+    while (true) {
+      begin_read();
+      Element* const x     = (pos < _nr ? (*_elements)[pos] : nullptr);
+      bool const     done  = is_done();
+      size_t const   epoch = _epoch;
+      end_read();
+      if (x != nullptr || done) {
+        return x;
+      }
+      enumerate_or_wait(pos + 1, epoch);
     }
   }
 
   Element* Semigroup::sorted_at(element_index_t pos) {
     sort_elements();
     if (pos < _sorted->size()) {
-      return (*_sorted)[pos].first;
+      return (*_elements)[(*_sorted)[pos]];
     } else {
       return nullptr;
     }
   }
 
+  std::vector<std::pair<Element*, Semigroup::element_index_t>>*
+  Semigroup::sorted_elements() {
+    if (_sorted_elements == nullptr) {
+      sort_elements();
+      _sorted_elements
+          = new std::vector<std::pair<Element*, element_index_t>>();
+      _sorted_elements->reserve(_sorted->size());
+      for (element_index_t i : *_sorted) {
+        _sorted_elements->push_back(std::make_pair((*_elements)[i], i));
+      }
+    }
+    return _sorted_elements;
+  }
+
   word_t* Semigroup::minimal_factorisation(Element* x) {
     element_index_t pos = this->position(x);
     if (pos == Semigroup::UNDEFINED) {
@@ -470,6 +782,108 @@ namespace libsemigroups {
     return factorisation(pos);
   }
 
+  void Semigroup::minimal_factorisations(std::vector<letter_t>& letters,
+                                         std::vector<size_t>&   offsets) {
+    enumerate();
+    offsets.resize(_nr + 1);
+    letters.resize(
+        std::accumulate(_length.cbegin(), _length.cend(), size_t(0)));
+    minimal_factorisations_impl(letters.data(), offsets.data());
+  }
+
+  bool Semigroup::minimal_factorisations(std::string const& filename) {
+    enumerate();
+    Timer timer;
+    timer.start();
+    size_t const total
+        = std::accumulate(_length.cbegin(), _length.cend(), size_t(0));
+    size_t const size  = (2 + (_nr + 1) + total) * sizeof(uint64_t);
+#ifdef HAVE_SYS_MMAN_H
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+      return false;
+    }
+    if (ftruncate(fd, size) != 0) {
+      close(fd);
+      return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    uint64_t* out = static_cast<uint64_t*>(data);
+    out[0]        = _nr;
+    out[1]        = total;
+    minimal_factorisations_impl(out + _nr + 3, out + 2);
+    bool success = (msync(data, size, MS_SYNC) == 0);
+    success      = (munmap(data, size) == 0) && success;
+    success      = (close(fd) == 0) && success;
+#else
+    std::vector<uint64_t> out(size / sizeof(uint64_t));
+    out[0] = _nr;
+    out[1] = total;
+    minimal_factorisations_impl(out.data() + _nr + 3, out.data() + 2);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<char const*>(out.data()), size);
+    file.close();
+    bool success = !file.fail();
+#endif
+    REPORT("wrote the factorisations of " << _nr << " elements to "
+                                          << filename << ", "
+                                          << timer.string("elapsed time = "));
+    return success;
+  }
+
+  template <typename T>
+  void Semigroup::minimal_factorisations_impl(T* letters, T* offsets) const {
+    LIBSEMIGROUPS_ASSERT(is_done());
+    offsets[0] = 0;
+    for (element_index_t i = 0; i < _nr; i++) {
+      offsets[i + 1] = offsets[i] + _length[i];
+    }
+    // The minimal factorisation of the element in position i is _first[i]
+    // followed by the factorisation of _suffix[i], which is one letter
+    // shorter, and so has been found already if the elements are considered
+    // in order of length.
+    auto factorise = [this, letters, offsets](enumerate_index_t first,
+                                              enumerate_index_t last) {
+      for (enumerate_index_t j = first; j < last; j++) {
+        element_index_t const i = _enumerate_order[j];
+        letters[offsets[i]]     = _first[i];
+        if (_suffix[i] != UNDEFINED) {
+          std::copy(letters + offsets[_suffix[i]],
+                    letters + offsets[_suffix[i] + 1],
+                    letters + offsets[i] + 1);
+        }
+      }
+    };
+
+    for (size_t k = 1; k < _lenindex.size(); k++) {
+      enumerate_index_t const first = _lenindex[k - 1];
+      enumerate_index_t const last  = std::min(_lenindex[k], _nr);
+      size_t const            nr_chunks
+          = (last - first + FACTORISATIONS_CHUNK_SIZE - 1)
+            / FACTORISATIONS_CHUNK_SIZE;
+      size_t const nr_threads = std::min(_max_threads, nr_chunks);
+      if (nr_threads <= 1) {
+        factorise(first, last);
+        continue;
+      }
+      std::atomic<size_t> next_chunk(0);
+      glob_reporter.reset_thread_ids();
+      run_in_threads(nr_threads, [&]() {
+        size_t chunk;
+        while ((chunk = next_chunk++) < nr_chunks) {
+          enumerate_index_t const begin
+              = first + chunk * FACTORISATIONS_CHUNK_SIZE;
+          factorise(begin,
+                    std::min(begin + FACTORISATIONS_CHUNK_SIZE, last));
+        }
+      });
+    }
+  }
+
   word_t* Semigroup::factorisation(Element* x) {
     if (x->get_type() == Element::elm_t::RWSE) {
       return const_cast<word_t*>(
@@ -557,14 +971,279 @@ namespace libsemigroups {
     }
   }
 
-  void Semigroup::enumerate(std::atomic<bool>& killed, size_t limit_size_t) {
+  size_t Semigroup::next_relations(std::vector<relation_t>& relations,
+                                   size_t                   max) {
+    word_t relation;
+    size_t nr = 0;
+    for (; nr < max; nr++) {
+      next_relation(relation);
+      if (relation.empty()) {
+        break;
+      }
+      relations.push_back(relation_t());
+      relation_t& rel = relations.back();
+      if (relation.size() == 2) {  // duplicate generators
+        rel.first.push_back(relation[0]);
+        rel.second.push_back(relation[1]);
+      } else {
+        factorisation(rel.first, relation[0]);
+        rel.first.push_back(relation[1]);
+        factorisation(rel.second, relation[2]);
+      }
+    }
+    return nr;
+  }
+
+  void Semigroup::relations(std::vector<relation_t>& relations,
+                            std::atomic<bool>&       killed) {
+    if (!is_done()) {
+      enumerate(killed);
+      if (killed) {
+        return;
+      }
+    }
+    // The relations for the elements in positions [i * RELATIONS_SHARD_SIZE,
+    // (i + 1) * RELATIONS_SHARD_SIZE) of _enumerate_order are put in
+    // shards[i], so that they are in the same order as for next_relation when
+    // the shards are concatenated.
+    std::vector<std::vector<relation_t>> shards(
+        (_nr + RELATIONS_SHARD_SIZE - 1) / RELATIONS_SHARD_SIZE);
+    size_t const nr_threads
+        = std::max(size_t(1), std::min(_max_threads, shards.size()));
+    std::atomic<size_t> next_shard(0);
+    if (nr_threads > 1) {
+      glob_reporter.reset_thread_ids();
+    }
+    run_in_threads(nr_threads, [this, &shards, &next_shard, &killed]() {
+      relations_thread(shards, next_shard, killed);
+    });
+    if (killed) {
+      return;
+    }
+
+    size_t nr = _duplicate_gens.size();
+    for (std::vector<relation_t> const& shard : shards) {
+      nr += shard.size();
+    }
+    relations.reserve(relations.size() + nr);
+    for (auto const& pair : _duplicate_gens) {
+      relations.push_back(
+          std::make_pair(word_t({pair.first}), word_t({pair.second})));
+    }
+    for (std::vector<relation_t>& shard : shards) {
+      std::move(shard.begin(), shard.end(), std::back_inserter(relations));
+    }
+    REPORT("found " << nr << " relations using " << nr_threads << " / "
+                    << std::thread::hardware_concurrency()
+                    << " threads");
+  }
+
+  void Semigroup::relations_thread(std::vector<std::vector<relation_t>>& shards,
+                                   std::atomic<size_t>& next_shard,
+                                   std::atomic<bool>&   killed) const {
+    size_t shard;
+    while (!killed && (shard = next_shard++) < shards.size()) {
+      std::vector<relation_t>& out   = shards[shard];
+      enumerate_index_t const  first = shard * RELATIONS_SHARD_SIZE;
+      enumerate_index_t const  last
+          = std::min(first + RELATIONS_SHARD_SIZE, _nr);
+      for (enumerate_index_t i = first; i < last; i++) {
+        element_index_t const x = _enumerate_order[i];
+        for (letter_t a = 0; a < _nrgens; a++) {
+          if (!_reduced.get(x, a)
+              && (i < _lenindex[1] || _reduced.get(_suffix[x], a))) {
+            out.push_back(relation_t());
+            relation_t& rel = out.back();
+            for (element_index_t p = x; p != UNDEFINED; p = _suffix[p]) {
+              rel.first.push_back(_first[p]);
+            }
+            rel.first.push_back(a);
+            element_index_t p = _right->get(x, a);
+            while (p != UNDEFINED) {
+              rel.second.push_back(_first[p]);
+              p = _suffix[p];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  template <class TElement>
+  inline Semigroup::element_index_t
+  Semigroup::product_and_find(Element*       xy,
+                              Element const* x,
+                              Element const* y,
+                              size_t         thread_id) {
+    typedef ElementOps<TElement> ops;
+    if ((_counters.add(thread_id, COUNTER_PRODUCTS)
+         & (METRICS_SAMPLE_PERIOD - 1))
+        != 0) {
+      ops::redefine(xy, x, y, thread_id);
+      return _map.find(xy, typename ops::Equal());
+    }
+    auto const start = std::chrono::steady_clock::now();
+    ops::redefine(xy, x, y, thread_id);
+    auto const            middle = std::chrono::steady_clock::now();
+    element_index_t const pos    = _map.find(xy, typename ops::Equal());
+    auto const            end    = std::chrono::steady_clock::now();
+    _counters.add(thread_id, COUNTER_SAMPLES);
+    _counters.add(thread_id,
+                  COUNTER_SAMPLED_REDEFINE_TIME,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      middle - start)
+                      .count());
+    _counters.add(
+        thread_id,
+        COUNTER_SAMPLED_LOOKUP_TIME,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle)
+            .count());
+    return pos;
+  }
+
+  template <class TElement>
+  void inline Semigroup::enumerate_next(Element* const*        products,
+                                        element_index_t const* positions,
+                                        index_t                limit,
+                                        std::atomic<bool>& killed,
+                                        bool&              stop,
+                                        size_t const&      tid) {
+    typedef ElementOps<TElement> ops;
+    element_index_t i = _enumerate_order[_pos];
+    letter_t        b = _first[i];
+    element_index_t s = _suffix[i];
+    _multiplied[i]    = true;
+    for (letter_t j = 0; j != _nrgens; ++j) {
+      if (!_reduced.get(s, j)) {
+        element_index_t r = _right->get(s, j);
+        if (_found_one && r == _pos_one) {
+          _right->set(i, j, _letter_to_pos[b]);
+        } else if (_prefix[r] != UNDEFINED) {  // r is not a generator
+          _right->set(i, j, _right->get(_left->get(_prefix[r], b), _final[r]));
+        } else {
+          _right->set(i, j, _right->get(_letter_to_pos[b], _final[r]));
+        }
+      } else {
+        Element*        x;
+        element_index_t pos;
+        if (products == nullptr) {
+          x   = _tmp_product;
+          pos = product_and_find<TElement>(
+              x, (*_elements)[i], (*_gens)[j], tid);
+        } else {
+          x   = products[j];
+          pos = positions[j];
+          if (pos == UNDEFINED) {
+            // x may be equal to an element found since positions was computed
+            _counters.add(tid, COUNTER_LOOKUPS);
+            pos = _map.find(x, typename ops::Equal());
+          }
+        }
+
+        if (pos != UNDEFINED) {
+          _right->set(i, j, pos);
+          _nrrules++;
+        } else {
+          is_one(x, _nr);
+          _elements->push_back(x->really_copy());
+          _first.push_back(b);
+          _final.push_back(j);
+          _length.push_back(_wordlen + 2);
+          _map.insert(_elements->back(), _nr);
+          _prefix.push_back(i);
+          _reduced.set(i, j, true);
+          _right->set(i, j, _nr);
+          _suffix.push_back(_right->get(s, j));
+          _enumerate_order.push_back(_nr);
+          _nr++;
+          stop = (_nr >= limit || killed);
+        }
+      }
+    }  // finished applying gens to <_elements->at(_pos)>
+    _pos++;
+  }
+
+  template <class TElement>
+  void Semigroup::compute_products(enumerate_index_t             first,
+                                   enumerate_index_t             last,
+                                   std::vector<Element*>&        products,
+                                   std::vector<element_index_t>& positions) {
+    LIBSEMIGROUPS_ASSERT(first < last);
+    size_t nr = (last - first) * _nrgens;
+    while (products.size() < nr) {
+      products.push_back(_tmp_product->really_copy());
+    }
+    positions.resize(products.size());
+    size_t nr_threads
+        = std::min(static_cast<size_t>(_max_threads),
+                   static_cast<size_t>(last - first));
+    size_t av_load = (last - first) / nr_threads;
+
+    // The thread with index k uses the value k for the thread_id parameter
+    // of Element::redefine, and so this must not be called at the same time
+    // as any other method that uses Element::redefine with the same
+    // thread_id.
+    std::vector<std::thread> threads;
+    enumerate_index_t        begin = first;
+    for (size_t k = 0; k < nr_threads; k++) {
+      enumerate_index_t end = (k == nr_threads - 1 ? last : begin + av_load);
+      threads.push_back(
+          std::thread(&Semigroup::compute_products_thread<TElement>,
+                      this,
+                      first,
+                      begin,
+                      end,
+                      std::ref(products),
+                      std::ref(positions),
+                      k));
+      begin = end;
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  template <class TElement>
+  void
+  Semigroup::compute_products_thread(enumerate_index_t             offset,
+                                     enumerate_index_t             first,
+                                     enumerate_index_t             last,
+                                     std::vector<Element*>&        products,
+                                     std::vector<element_index_t>& positions,
+                                     size_t                        thread_id) {
+    for (enumerate_index_t k = first; k < last; k++) {
+      element_index_t i = _enumerate_order[k];
+      element_index_t s = _suffix[i];
+      for (letter_t j = 0; j != _nrgens; ++j) {
+        if (_reduced.get(s, j)) {
+          size_t   l = (k - offset) * _nrgens + j;
+          // _map is not modified until every thread has finished, and so it
+          // is safe to look the product up here.
+          positions[l] = product_and_find<TElement>(
+              products[l], (*_elements)[i], (*_gens)[j], thread_id);
+        }
+      }
+    }
+  }
+
+  void Semigroup::enumerate(std::atomic<bool>& killed, size_t limit) {
+    enumerate_impl<Element>(killed, limit);
+  }
+
+  template <class TElement>
+  void Semigroup::enumerate_impl(std::atomic<bool>& killed,
+                                 size_t             limit_size_t) {
     _mtx.lock();
     if (_pos >= _nr || limit_size_t <= _nr || killed) {
       _mtx.unlock();
       return;
     }
+    begin_write();
     // Ensure that limit isn't too big
     index_t limit = static_cast<index_t>(limit_size_t);
+    // The batch size only changes if it determines the limit
+    bool const    limited_by_batch = (limit_size_t - _nr < _batch_size);
+    index_t const nr_old           = _nr;
 
     if (Semigroup::LIMIT_MAX - _batch_size > _nr) {
       limit = std::max(limit, _nr + _batch_size);
@@ -577,6 +1256,18 @@ namespace libsemigroups {
     timer.start();
     size_t tid = glob_reporter.thread_id(std::this_thread::get_id());
 
+    // The time since the start at which the time for the current word length
+    // was last recorded in _time_by_length
+    int64_t    mark        = 0;
+    auto const record_time = [this, &timer, &mark]() {
+      int64_t const now = timer.elapsed();
+      if (_time_by_length.size() < _wordlen + 2) {
+        _time_by_length.resize(_wordlen + 2, 0);
+      }
+      _time_by_length[_wordlen + 1] += now - mark;
+      mark = now;
+    };
+
     // multiply the generators by every generator
     if (_pos < _lenindex[1]) {
       index_t nr_shorter_elements = _nr;
@@ -584,11 +1275,11 @@ namespace libsemigroups {
         element_index_t i = _enumerate_order[_pos];
         _multiplied[i]    = true;
         for (letter_t j = 0; j != _nrgens; ++j) {
-          _tmp_product->redefine((*_elements)[i], (*_gens)[j], tid);
-          auto it = _map.find(_tmp_product);
+          element_index_t pos = product_and_find<TElement>(
+              _tmp_product, (*_elements)[i], (*_gens)[j], tid);
 
-          if (it != _map.end()) {
-            _right->set(i, j, it->second);
+          if (pos != UNDEFINED) {
+            _right->set(i, j, pos);
             _nrrules++;
           } else {
             is_one(_tmp_product, _nr);
@@ -597,7 +1288,7 @@ namespace libsemigroups {
             _final.push_back(j);
             _enumerate_order.push_back(_nr);
             _length.push_back(2);
-            _map.insert(std::make_pair(_elements->back(), _nr));
+            _map.insert(_elements->back(), _nr);
             _prefix.push_back(i);
             _reduced.set(i, j, true);
             _right->set(i, j, _nr);
@@ -613,58 +1304,48 @@ namespace libsemigroups {
           _left->set(_enumerate_order[i], j, _right->get(_letter_to_pos[j], b));
         }
       }
+      record_time();
       _wordlen++;
       expand(_nr - nr_shorter_elements);
       _lenindex.push_back(_enumerate_order.size());
     }
 
     // multiply the words of length > 1 by every generator
-    bool stop = (_nr >= limit || killed);
+    bool                         stop = (_nr >= limit || killed);
+    std::vector<Element*>        products;
+    std::vector<element_index_t> positions;
+    index_t next_pause = _nr + std::min(_batch_size, LIMIT_MAX - _nr);
 
     while (_pos != _nr && !stop) {
       index_t nr_shorter_elements = _nr;
-      while (_pos != _lenindex[_wordlen + 1] && !stop) {
-        element_index_t i = _enumerate_order[_pos];
-        letter_t        b = _first[i];
-        element_index_t s = _suffix[i];
-        _multiplied[i]    = true;
-        for (letter_t j = 0; j != _nrgens; ++j) {
-          if (!_reduced.get(s, j)) {
-            element_index_t r = _right->get(s, j);
-            if (_found_one && r == _pos_one) {
-              _right->set(i, j, _letter_to_pos[b]);
-            } else if (_prefix[r] != UNDEFINED) {  // r is not a generator
-              _right->set(
-                  i, j, _right->get(_left->get(_prefix[r], b), _final[r]));
-            } else {
-              _right->set(i, j, _right->get(_letter_to_pos[b], _final[r]));
-            }
-          } else {
-            _tmp_product->redefine((*_elements)[i], (*_gens)[j], tid);
-            auto it = _map.find(_tmp_product);
-
-            if (it != _map.end()) {
-              _right->set(i, j, it->second);
-              _nrrules++;
-            } else {
-              is_one(_tmp_product, _nr);
-              _elements->push_back(_tmp_product->really_copy());
-              _first.push_back(b);
-              _final.push_back(j);
-              _length.push_back(_wordlen + 2);
-              _map.insert(std::make_pair(_elements->back(), _nr));
-              _prefix.push_back(i);
-              _reduced.set(i, j, true);
-              _right->set(i, j, _nr);
-              _suffix.push_back(_right->get(s, j));
-              _enumerate_order.push_back(_nr);
-              _nr++;
-              stop = (_nr >= limit || killed);
-            }
+      if (_max_threads > 1
+          && _lenindex[_wordlen + 1] - _pos >= PARALLEL_CHUNK_SIZE) {
+        // The products of the elements of length _wordlen + 1 and the
+        // generators are independent of each other, and so they are computed
+        // in parallel, a chunk at a time. The results are then processed in
+        // order in this thread, so that the elements are numbered exactly as
+        // they would be if only 1 thread was used.
+        while (_pos != _lenindex[_wordlen + 1] && !stop) {
+          enumerate_index_t last = std::min(
+              _pos + PARALLEL_CHUNK_SIZE, _lenindex[_wordlen + 1]);
+          compute_products<TElement>(_pos, last, products, positions);
+          for (size_t k = 0; _pos != last && !stop; ++k) {
+            enumerate_next<TElement>(&products[k * _nrgens],
+                           &positions[k * _nrgens],
+                           limit,
+                           killed,
+                           stop,
+                           tid);
+            pause_for_readers(next_pause);
           }
-        }  // finished applying gens to <_elements->at(_pos)>
-        _pos++;
-      }  // finished words of length <wordlen> + 1
+        }
+      } else {
+        while (_pos != _lenindex[_wordlen + 1] && !stop) {
+          enumerate_next<TElement>(
+              nullptr, nullptr, limit, killed, stop, tid);
+          pause_for_readers(next_pause);
+        }  // finished words of length <wordlen> + 1
+      }
       expand(_nr - nr_shorter_elements);
 
       if (_pos > _nr || _pos == _lenindex[_wordlen + 1]) {
@@ -676,6 +1357,7 @@ namespace libsemigroups {
                 _enumerate_order[i], j, _right->get(_left->get(p, j), b));
           }
         }
+        record_time();
         _wordlen++;
         _lenindex.push_back(_enumerate_order.size());
       }
@@ -692,13 +1374,139 @@ namespace libsemigroups {
                         << ", finished")
       }
     }
+    for (Element* x : products) {
+      x->really_delete();
+      delete x;
+    }
     REPORT(timer.string("elapsed time = "));
     if (killed) {
       REPORT("killed");
     }
+    record_time();
+    timer.stop();
+    int64_t const elapsed = timer.elapsed();
+    _time_enumerate += elapsed;
+    if (_adaptive_batch_size && limited_by_batch) {
+      update_batch_size(elapsed);
+    }
+    size_t const nr_new     = _nr - nr_old;
+    size_t const batch_size = _batch_size;
+    if (nr_new > 0) {
+      REPORT(nr_new * 1000000000 / std::max(elapsed, int64_t(1))
+             << " elements per second, next batch size " << batch_size);
+    }
+    end_write();
+    {
+      std::lock_guard<std::mutex> lg(_read_mtx);
+      _enumerating = false;
+    }
+    _read_cv.notify_all();
     _mtx.unlock();
+    if (nr_new > 0 && _batch_hook) {
+      _batch_hook(nr_new, elapsed, batch_size);
+    }
+  }
+
+  // This is like the congestion window in TCP: the batch size is doubled
+  // until the first batch which takes too long, and then it is halved after
+  // every batch which takes too long, and increased additively otherwise.
+  void Semigroup::update_batch_size(int64_t elapsed) {
+    if (elapsed > ADAPTIVE_BATCH_TIME) {
+      _batch_size_threshold = std::max(_batch_size / 2, _min_batch_size);
+      _batch_size           = _batch_size_threshold;
+    } else if (_batch_size < _batch_size_threshold) {
+      _batch_size = std::min(_batch_size, LIMIT_MAX / 2) * 2;
+    } else {
+      _batch_size += std::min(_min_batch_size, LIMIT_MAX - _batch_size);
+    }
+  }
+
+  void Semigroup::begin_read() const {
+    _nr_readers++;
+    if (!_writing) {
+      return;
+    }
+    _nr_readers--;
+    {
+      std::unique_lock<std::mutex> lock(_read_mtx);
+      _nr_waiting++;
+      _read_cv.wait(lock, [this]() { return !_writing; });
+      _nr_waiting--;
+      _nr_readers++;
+    }
+    // The writer may be waiting for _nr_waiting to be 0
+    _read_cv.notify_all();
+  }
+
+  void Semigroup::end_read() const {
+    _nr_readers--;
+  }
+
+  // Readers waiting in begin_read are let in before the writer, so that they
+  // are not starved when the enumeration pauses for them.
+  void Semigroup::begin_write() {
+    {
+      std::unique_lock<std::mutex> lock(_read_mtx);
+      _read_cv.wait(lock, [this]() { return _nr_waiting == 0; });
+      _writing     = true;
+      _enumerating = true;
+    }
+    while (_nr_readers != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  void Semigroup::end_write() {
+    {
+      std::lock_guard<std::mutex> lg(_read_mtx);
+      _writing = false;
+      _epoch++;
+    }
+    _read_cv.notify_all();
   }
 
+  void Semigroup::enumerate_or_wait(size_t limit, size_t epoch) {
+    std::unique_lock<std::mutex> lock(_read_mtx);
+    if (!_enumerating) {
+      lock.unlock();
+      enumerate(limit);
+      return;
+    }
+    _read_cv.wait(lock, [this, epoch]() {
+      return _epoch != epoch || !_enumerating;
+    });
+  }
+
+  // The instances of FroidurePin which are provided by the library. These
+  // must be kept in sync with is_froidure_pin_element in semigroups.h.
+  template void
+  Semigroup::enumerate_impl<Transformation<u_int8_t>>(std::atomic<bool>&,
+                                                      size_t);
+  template void
+  Semigroup::enumerate_impl<Transformation<u_int16_t>>(std::atomic<bool>&,
+                                                       size_t);
+  template void
+  Semigroup::enumerate_impl<Transformation<u_int32_t>>(std::atomic<bool>&,
+                                                       size_t);
+  template void
+  Semigroup::enumerate_impl<PartialPerm<u_int8_t>>(std::atomic<bool>&,
+                                                   size_t);
+  template void
+  Semigroup::enumerate_impl<PartialPerm<u_int16_t>>(std::atomic<bool>&,
+                                                    size_t);
+  template void
+  Semigroup::enumerate_impl<PartialPerm<u_int32_t>>(std::atomic<bool>&,
+                                                    size_t);
+  template void Semigroup::enumerate_impl<BooleanMat>(std::atomic<bool>&,
+                                                      size_t);
+  template void
+  Semigroup::enumerate_impl<PackedBooleanMat>(std::atomic<bool>&, size_t);
+  template void Semigroup::enumerate_impl<Bipartition>(std::atomic<bool>&,
+                                                       size_t);
+  template void Semigroup::enumerate_impl<PBR>(std::atomic<bool>&, size_t);
+  template void Semigroup::enumerate_impl<PackedPBR>(std::atomic<bool>&,
+                                                     size_t);
+
   Semigroup* Semigroup::copy_closure(std::vector<Element*> const* coll) {
     if (coll->empty()) {
       return new Semigroup(*this);
@@ -715,23 +1523,589 @@ namespace libsemigroups {
     }
   }
 
+  // The files written by Semigroup::save consist of a header of
+  // CKPT_HEADER_SIZE values followed by the sections listed in
+  // checkpoint_section_t, in that order. Every value in the file is a
+  // uint64_t in the byte order of the machine which wrote it. The last
+  // CKPT_NR_SECTIONS values of the header are the offsets, in bytes, of the
+  // sections. Every section starts at a multiple of 64 bytes, except for the
+  // Cayley graphs, which start at a multiple of 4096 bytes (the usual page
+  // size) so that other programs can memory-map them; Semigroup::load reads
+  // them with an ifstream instead. The sections CKPT_MULTIPLIED and
+  // CKPT_REDUCED are bit arrays, the latter stored row by row.
+
+  static uint64_t const CKPT_MAGIC      = 0x4C53474B50543031;  // "LSGKPT01"
+  static uint64_t const CKPT_VERSION    = 1;
+  static uint64_t const CKPT_BYTE_ORDER = 0x0102030405060708;
+
+  enum checkpoint_field_t {
+    CKPT_FIELD_MAGIC = 0,
+    CKPT_FIELD_VERSION,
+    CKPT_FIELD_BYTE_ORDER,
+    CKPT_FIELD_NRGENS,
+    CKPT_FIELD_DEGREE,
+    CKPT_FIELD_NR,
+    CKPT_FIELD_POS,
+    CKPT_FIELD_WORDLEN,
+    CKPT_FIELD_NRRULES,
+    CKPT_FIELD_FOUND_ONE,
+    CKPT_FIELD_POS_ONE,
+    CKPT_FIELD_LENINDEX_SIZE,
+    CKPT_FIELD_NR_DUPLICATE_GENS,
+    CKPT_FIELD_CHECKSUM,
+    CKPT_NR_FIELDS
+  };
+
+  enum checkpoint_section_t {
+    CKPT_LETTER_TO_POS = 0,
+    CKPT_DUPLICATE_GENS,
+    CKPT_LENINDEX,
+    CKPT_ENUMERATE_ORDER,
+    CKPT_FIRST,
+    CKPT_FINAL,
+    CKPT_LENGTH,
+    CKPT_PREFIX,
+    CKPT_SUFFIX,
+    CKPT_MULTIPLIED,
+    CKPT_REDUCED,
+    CKPT_RIGHT,
+    CKPT_LEFT,
+    CKPT_NR_SECTIONS
+  };
+
+  static size_t const CKPT_HEADER_SIZE = CKPT_NR_FIELDS + CKPT_NR_SECTIONS;
+
+  // Returns the number of values in the section s of a file with the given
+  // header.
+  static uint64_t checkpoint_section_size(uint64_t const* header, size_t s) {
+    uint64_t const nr     = header[CKPT_FIELD_NR];
+    uint64_t const nrgens = header[CKPT_FIELD_NRGENS];
+    switch (s) {
+      case CKPT_LETTER_TO_POS:
+        return nrgens;
+      case CKPT_DUPLICATE_GENS:
+        return 2 * header[CKPT_FIELD_NR_DUPLICATE_GENS];
+      case CKPT_LENINDEX:
+        return header[CKPT_FIELD_LENINDEX_SIZE];
+      case CKPT_MULTIPLIED:
+        return (nr + 63) / 64;
+      case CKPT_REDUCED:
+        return (nr * nrgens + 63) / 64;
+      case CKPT_RIGHT:
+      case CKPT_LEFT:
+        return nr * nrgens;
+      default:
+        return nr;
+    }
+  }
+
+  // Sets the offsets of the sections in header, and returns the size of the
+  // file in bytes.
+  static uint64_t checkpoint_set_offsets(uint64_t* header) {
+    uint64_t offset = CKPT_HEADER_SIZE * sizeof(uint64_t);
+    for (size_t s = 0; s < CKPT_NR_SECTIONS; s++) {
+      uint64_t const align = (s == CKPT_RIGHT || s == CKPT_LEFT ? 4096 : 64);
+      offset = (offset + align - 1) / align * align;
+      header[CKPT_NR_FIELDS + s] = offset;
+      offset += checkpoint_section_size(header, s) * sizeof(uint64_t);
+    }
+    return offset;
+  }
+
+  // Combines the hash values of the elements, in order, so that
+  // Semigroup::load can check that it has recomputed the same elements.
+  static uint64_t checkpoint_checksum(std::vector<Element*> const& elts) {
+    uint64_t seed = 0;
+    for (Element const* x : elts) {
+      seed ^= x->hash_value() + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+  }
+
+  template <typename T>
+  static std::vector<uint64_t> checkpoint_words(std::vector<T> const& vec) {
+    return std::vector<uint64_t>(vec.begin(), vec.end());
+  }
+
+  template <typename T>
+  static std::vector<T> checkpoint_from_words(std::vector<uint64_t> const& v) {
+    std::vector<T> out;
+    out.reserve(v.size());
+    for (uint64_t x : v) {
+      out.push_back(static_cast<T>(x));
+    }
+    return out;
+  }
+
+  static std::vector<uint64_t> checkpoint_pack(std::vector<bool> const& bits) {
+    std::vector<uint64_t> out((bits.size() + 63) / 64, 0);
+    for (size_t i = 0; i < bits.size(); i++) {
+      out[i / 64] |= static_cast<uint64_t>(bits[i]) << (i % 64);
+    }
+    return out;
+  }
+
+  // Pads the file with zeros up to the offset of the section s in header.
+  static void checkpoint_pad(std::ofstream&  file,
+                             uint64_t const* header,
+                             size_t          s) {
+    uint64_t const pos = static_cast<uint64_t>(file.tellp());
+    LIBSEMIGROUPS_ASSERT(pos <= header[CKPT_NR_FIELDS + s]);
+    for (uint64_t i = pos; i < header[CKPT_NR_FIELDS + s]; i++) {
+      file.put(0);
+    }
+  }
+
+  static void checkpoint_write(std::ofstream&               file,
+                               uint64_t const*              header,
+                               size_t                       s,
+                               std::vector<uint64_t> const& data) {
+    LIBSEMIGROUPS_ASSERT(data.size() == checkpoint_section_size(header, s));
+    checkpoint_pad(file, header, s);
+    file.write(reinterpret_cast<char const*>(data.data()),
+               data.size() * sizeof(uint64_t));
+  }
+
+  // Writes the first nr_rows rows of a Cayley graph a chunk of rows at a
+  // time, so that the whole graph is never copied.
+  static void checkpoint_write(std::ofstream&                   file,
+                               uint64_t const*                  header,
+                               size_t                           s,
+                               Semigroup::cayley_graph_t const* graph,
+                               size_t                           nr_rows) {
+    size_t const nr_cols = graph->nr_cols();
+    size_t const chunk   = std::max(size_t(1), size_t(4096) / nr_cols);
+    LIBSEMIGROUPS_ASSERT(nr_rows * nr_cols
+                         == checkpoint_section_size(header, s));
+    checkpoint_pad(file, header, s);
+    std::vector<uint64_t> buf;
+    buf.reserve(chunk * nr_cols);
+    for (size_t i = 0; i < nr_rows; i += chunk) {
+      buf.clear();
+      for (size_t k = i; k < std::min(i + chunk, nr_rows); k++) {
+        for (size_t j = 0; j < nr_cols; j++) {
+          buf.push_back(graph->get(k, j));
+        }
+      }
+      file.write(reinterpret_cast<char const*>(buf.data()),
+                 buf.size() * sizeof(uint64_t));
+    }
+  }
+
+  // Returns true if every value in vec is less than bound, or equals
+  // Semigroup::UNDEFINED if undefined_ok is true.
+  template <typename T>
+  static bool checkpoint_in_range(std::vector<T> const& vec,
+                                  size_t                bound,
+                                  bool                  undefined_ok) {
+    for (T const& x : vec) {
+      if (x >= bound && !(undefined_ok && x == Semigroup::UNDEFINED)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Reads the section s into out, and returns true if this was successful.
+  static bool checkpoint_read(std::ifstream&         file,
+                              uint64_t const*        header,
+                              size_t                 s,
+                              std::vector<uint64_t>& out) {
+    out.resize(checkpoint_section_size(header, s));
+    file.seekg(header[CKPT_NR_FIELDS + s]);
+    file.read(reinterpret_cast<char*>(out.data()),
+              out.size() * sizeof(uint64_t));
+    return static_cast<bool>(file);
+  }
+
+  // Reads the section s into graph, which must have the appropriate numbers
+  // of rows and columns, a chunk of rows at a time, and returns true if this
+  // was successful and every value is less than the number of rows or is
+  // Semigroup::UNDEFINED.
+  static bool checkpoint_read(std::ifstream&             file,
+                              uint64_t const*            header,
+                              size_t                     s,
+                              Semigroup::cayley_graph_t* graph) {
+    size_t const nr_rows = graph->nr_rows();
+    size_t const nr_cols = graph->nr_cols();
+    size_t const chunk   = std::max(size_t(1), size_t(4096) / nr_cols);
+    LIBSEMIGROUPS_ASSERT(nr_rows * nr_cols
+                         == checkpoint_section_size(header, s));
+    file.seekg(header[CKPT_NR_FIELDS + s]);
+    std::vector<uint64_t> buf(chunk * nr_cols);
+    for (size_t i = 0; i < nr_rows; i += chunk) {
+      size_t const k_end = std::min(i + chunk, nr_rows);
+      file.read(reinterpret_cast<char*>(buf.data()),
+                (k_end - i) * nr_cols * sizeof(uint64_t));
+      if (!file) {
+        return false;
+      }
+      for (size_t k = i; k < k_end; k++) {
+        for (size_t j = 0; j < nr_cols; j++) {
+          size_t const val = static_cast<size_t>(buf[(k - i) * nr_cols + j]);
+          if (val >= nr_rows && val != Semigroup::UNDEFINED) {
+            return false;
+          }
+          graph->set(k, j, val);
+        }
+      }
+    }
+    return true;
+  }
+
+  bool Semigroup::save(std::string const& filename) {
+    std::lock_guard<std::mutex> lg(_mtx);
+    Timer                       timer;
+    timer.start();
+
+    uint64_t header[CKPT_HEADER_SIZE];
+    header[CKPT_FIELD_MAGIC]             = CKPT_MAGIC;
+    header[CKPT_FIELD_VERSION]           = CKPT_VERSION;
+    header[CKPT_FIELD_BYTE_ORDER]        = CKPT_BYTE_ORDER;
+    header[CKPT_FIELD_NRGENS]            = _nrgens;
+    header[CKPT_FIELD_DEGREE]            = _degree;
+    header[CKPT_FIELD_NR]                = _nr;
+    header[CKPT_FIELD_POS]               = _pos;
+    header[CKPT_FIELD_WORDLEN]           = _wordlen;
+    header[CKPT_FIELD_NRRULES]           = _nrrules;
+    header[CKPT_FIELD_FOUND_ONE]         = _found_one;
+    header[CKPT_FIELD_POS_ONE]           = _pos_one;
+    header[CKPT_FIELD_LENINDEX_SIZE]     = _lenindex.size();
+    header[CKPT_FIELD_NR_DUPLICATE_GENS] = _duplicate_gens.size();
+    header[CKPT_FIELD_CHECKSUM]          = checkpoint_checksum(*_elements);
+    checkpoint_set_offsets(header);
+
+    std::vector<uint64_t> duplicate_gens;
+    for (auto const& x : _duplicate_gens) {
+      duplicate_gens.push_back(x.first);
+      duplicate_gens.push_back(x.second);
+    }
+    std::vector<bool> reduced;
+    reduced.reserve(_nr * _nrgens);
+    for (element_index_t i = 0; i < _nr; i++) {
+      for (letter_t j = 0; j < _nrgens; j++) {
+        reduced.push_back(_reduced.get(i, j));
+      }
+    }
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<char const*>(header), sizeof(header));
+    checkpoint_write(file, header, CKPT_LETTER_TO_POS,
+                     checkpoint_words(_letter_to_pos));
+    checkpoint_write(file, header, CKPT_DUPLICATE_GENS, duplicate_gens);
+    checkpoint_write(file, header, CKPT_LENINDEX, checkpoint_words(_lenindex));
+    checkpoint_write(file, header, CKPT_ENUMERATE_ORDER,
+                     checkpoint_words(_enumerate_order));
+    checkpoint_write(file, header, CKPT_FIRST, checkpoint_words(_first));
+    checkpoint_write(file, header, CKPT_FINAL, checkpoint_words(_final));
+    checkpoint_write(file, header, CKPT_LENGTH, checkpoint_words(_length));
+    checkpoint_write(file, header, CKPT_PREFIX, checkpoint_words(_prefix));
+    checkpoint_write(file, header, CKPT_SUFFIX, checkpoint_words(_suffix));
+    checkpoint_write(file, header, CKPT_MULTIPLIED,
+                     checkpoint_pack(_multiplied));
+    checkpoint_write(file, header, CKPT_REDUCED, checkpoint_pack(reduced));
+    checkpoint_write(file, header, CKPT_RIGHT, _right, _nr);
+    checkpoint_write(file, header, CKPT_LEFT, _left, _nr);
+    file.close();
+
+    REPORT("saved " << _nr << " elements to " << filename << ", "
+                    << timer.string("elapsed time = "));
+    return !file.fail();
+  }
+
+  bool Semigroup::load(std::string const& filename) {
+    std::lock_guard<std::mutex> lg(_mtx);
+    if (is_begun() || _nr != _lenindex[1]) {
+      return false;
+    }
+    Timer timer;
+    timer.start();
+
+    std::ifstream file(filename, std::ios::binary);
+    uint64_t      header[CKPT_HEADER_SIZE];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || header[CKPT_FIELD_MAGIC] != CKPT_MAGIC
+        || header[CKPT_FIELD_VERSION] != CKPT_VERSION
+        || header[CKPT_FIELD_BYTE_ORDER] != CKPT_BYTE_ORDER
+        || header[CKPT_FIELD_NRGENS] != _nrgens
+        || header[CKPT_FIELD_DEGREE] != _degree
+        || header[CKPT_FIELD_NR] < _nr
+        || header[CKPT_FIELD_POS] > header[CKPT_FIELD_NR]
+        || header[CKPT_FIELD_NR_DUPLICATE_GENS] != _duplicate_gens.size()
+        || header[CKPT_FIELD_LENINDEX_SIZE] < 2) {
+      return false;
+    }
+    // Check that the offsets are those that save would have written, and
+    // that the file is long enough to contain every section.
+    uint64_t expected[CKPT_HEADER_SIZE];
+    std::copy(header, header + CKPT_NR_FIELDS, expected);
+    uint64_t const file_size = checkpoint_set_offsets(expected);
+    if (!std::equal(header, header + CKPT_HEADER_SIZE, expected)) {
+      return false;
+    }
+    file.seekg(0, std::ios::end);
+    if (!file || static_cast<uint64_t>(file.tellg()) < file_size) {
+      return false;
+    }
+
+    index_t const nr = header[CKPT_FIELD_NR];
+
+    std::vector<uint64_t> words;
+    if (!checkpoint_read(file, header, CKPT_LETTER_TO_POS, words)
+        || checkpoint_from_words<element_index_t>(words) != _letter_to_pos
+        || !checkpoint_read(file, header, CKPT_DUPLICATE_GENS, words)) {
+      return false;
+    }
+    for (size_t i = 0; i < _duplicate_gens.size(); i++) {
+      if (words[2 * i] != _duplicate_gens[i].first
+          || words[2 * i + 1] != _duplicate_gens[i].second) {
+        return false;
+      }
+    }
+
+    if (!checkpoint_read(file, header, CKPT_LENINDEX, words)) {
+      return false;
+    }
+    std::vector<enumerate_index_t> lenindex
+        = checkpoint_from_words<enumerate_index_t>(words);
+    if (lenindex[0] != 0 || lenindex[1] != _lenindex[1]) {
+      return false;
+    }
+
+    if (!checkpoint_read(file, header, CKPT_ENUMERATE_ORDER, words)) {
+      return false;
+    }
+    std::vector<element_index_t> enumerate_order
+        = checkpoint_from_words<element_index_t>(words);
+    std::vector<letter_t> first, final;
+    std::vector<index_t>  length;
+    std::vector<element_index_t> prefix, suffix;
+    if (!checkpoint_read(file, header, CKPT_FIRST, words)) {
+      return false;
+    }
+    first = checkpoint_from_words<letter_t>(words);
+    if (!checkpoint_read(file, header, CKPT_FINAL, words)) {
+      return false;
+    }
+    final = checkpoint_from_words<letter_t>(words);
+    if (!checkpoint_read(file, header, CKPT_LENGTH, words)) {
+      return false;
+    }
+    length = checkpoint_from_words<index_t>(words);
+    if (!checkpoint_read(file, header, CKPT_PREFIX, words)) {
+      return false;
+    }
+    prefix = checkpoint_from_words<element_index_t>(words);
+    if (!checkpoint_read(file, header, CKPT_SUFFIX, words)) {
+      return false;
+    }
+    suffix = checkpoint_from_words<element_index_t>(words);
+
+    // Check that every index is in range, so that a corrupt file cannot
+    // cause out of range accesses later.
+    if (header[CKPT_FIELD_WORDLEN] + 1 >= lenindex.size()
+        || (header[CKPT_FIELD_FOUND_ONE] != 0
+            && (header[CKPT_FIELD_FOUND_ONE] != 1
+                || header[CKPT_FIELD_POS_ONE] >= nr))
+        || !checkpoint_in_range(enumerate_order, nr, false)
+        || !checkpoint_in_range(first, _nrgens, false)
+        || !checkpoint_in_range(final, _nrgens, false)
+        || !checkpoint_in_range(prefix, nr, true)
+        || !checkpoint_in_range(suffix, nr, true)) {
+      return false;
+    }
+    for (size_t k = 1; k < lenindex.size(); k++) {
+      if (lenindex[k] < lenindex[k - 1] || lenindex[k] > nr) {
+        return false;
+      }
+    }
+    for (index_t len : length) {
+      if (len == 0 || len > lenindex.size()) {
+        return false;
+      }
+    }
+
+    std::vector<bool> multiplied(nr, false);
+    if (!checkpoint_read(file, header, CKPT_MULTIPLIED, words)) {
+      return false;
+    }
+    for (size_t i = 0; i < nr; i++) {
+      multiplied[i] = (words[i / 64] >> (i % 64)) & 1;
+    }
+    flags_t reduced(_nrgens, nr);
+    if (!checkpoint_read(file, header, CKPT_REDUCED, words)) {
+      return false;
+    }
+    for (size_t i = 0; i < nr; i++) {
+      for (size_t j = 0; j < _nrgens; j++) {
+        size_t const b = i * _nrgens + j;
+        reduced.set(i, j, (words[b / 64] >> (b % 64)) & 1);
+      }
+    }
+
+    cayley_graph_t* right = new cayley_graph_t(_nrgens, nr);
+    cayley_graph_t* left  = new cayley_graph_t(_nrgens, nr);
+    if (!checkpoint_read(file, header, CKPT_RIGHT, right)
+        || !checkpoint_read(file, header, CKPT_LEFT, left)) {
+      delete right;
+      delete left;
+      return false;
+    }
+
+    // Recompute the elements in the order in which they were enumerated, so
+    // that the prefix of every element is known before the element itself.
+    std::vector<Element*> elements(nr, nullptr);
+    std::copy(_elements->begin(), _elements->end(), elements.begin());
+    bool valid = true;
+    for (enumerate_index_t k = 0; k < nr && valid; k++) {
+      element_index_t const i = enumerate_order[k];
+      if (k < _lenindex[1]) {
+        valid = (i == _enumerate_order[k]);
+      } else if (i >= nr || elements[i] != nullptr || final[i] >= _nrgens
+                 || prefix[i] >= nr || elements[prefix[i]] == nullptr) {
+        valid = false;
+      } else {
+        elements[i] = _tmp_product->really_copy();
+        elements[i]->redefine(elements[prefix[i]], (*_gens)[final[i]]);
+      }
+    }
+    if (!valid
+        || checkpoint_checksum(elements) != header[CKPT_FIELD_CHECKSUM]) {
+      for (size_t i = _nr; i < nr; i++) {
+        if (elements[i] != nullptr) {
+          elements[i]->really_delete();
+          delete elements[i];
+        }
+      }
+      delete right;
+      delete left;
+      return false;
+    }
+
+    _map.reserve(nr);
+    _elements->reserve(nr);
+    for (element_index_t i = _nr; i < nr; i++) {
+      _elements->push_back(elements[i]);
+      _map.insert(elements[i], i);
+    }
+
+    delete _right;
+    delete _left;
+    _right           = right;
+    _left            = left;
+    _reduced         = reduced;
+    _multiplied      = multiplied;
+    _enumerate_order = enumerate_order;
+    _lenindex        = lenindex;
+    _first           = first;
+    _final           = final;
+    _length          = length;
+    _prefix          = prefix;
+    _suffix          = suffix;
+    _nr              = nr;
+    _pos             = header[CKPT_FIELD_POS];
+    _wordlen         = header[CKPT_FIELD_WORDLEN];
+    _nrrules         = header[CKPT_FIELD_NRRULES];
+    _found_one       = header[CKPT_FIELD_FOUND_ONE];
+    _pos_one         = header[CKPT_FIELD_POS_ONE];
+
+    REPORT("loaded " << _nr << " elements from " << filename << ", "
+                     << timer.string("elapsed time = "));
+    return true;
+  }
+
   void Semigroup::closure(std::vector<Element*> const& coll) {
     closure(&coll);
   }
 
+  // The elements of coll are added one at a time until there are at least
+  // CLOSURE_BATCH_SIZE of them left to consider, and this has at least
+  // CLOSURE_BATCH_MIN_NR elements. The remaining elements of coll which do
+  // not belong to this are then the candidates to be new generators. The
+  // semigroup U generated by this and all of the candidates is found in a
+  // single pass by a partial copy of this, rather than calling add_generators
+  // once per candidate and passing over all of the elements every time. The
+  // i-th candidate is redundant if it belongs to the subsemigroup of U
+  // generated by this and the non-redundant candidates before it, which is
+  // found by following the right Cayley graph of U without multiplying any
+  // elements. Finally, the non-redundant candidates are added to this in a
+  // single pass.
   void Semigroup::closure(std::vector<Element*> const* coll) {
-    if (coll->empty()) {
+    std::vector<Element*> singleton(1, nullptr);
+    auto                  it = coll->cbegin();
+    for (; it < coll->cend(); ++it) {
+      if (static_cast<size_t>(coll->cend() - it) >= CLOSURE_BATCH_SIZE
+          && _nr >= CLOSURE_BATCH_MIN_NR) {
+        break;
+      } else if (!test_membership(*it)) {
+        singleton[0] = *it;
+        add_generators(singleton);
+      }
+    }
+
+    std::vector<Element*> candidates;
+    for (; it < coll->cend(); ++it) {
+      if (!test_membership(*it)) {
+        candidates.push_back(*it);
+      }
+    }
+    if (candidates.empty()) {
       return;
-    } else {
-      std::vector<Element*> singleton(1, nullptr);
+    }
+    // this is fully enumerated, since some element was not found in it
+    LIBSEMIGROUPS_ASSERT(is_done());
+
+    Semigroup*            U     = copy_add_generators(&candidates);
+    cayley_graph_t const* right = U->right_cayley_graph();
+
+    // The elements of this are in the same positions in U, and the
+    // subsemigroup generated by this and the chosen candidates is the set
+    // of positions in U with in_sub set to true.
+    std::vector<bool>            in_sub(U->size(), false);
+    std::vector<element_index_t> members;
+    std::vector<letter_t>        letters;
+    for (element_index_t i = 0; i < _nr; i++) {
+      in_sub[i] = true;
+      members.push_back(i);
+    }
+    for (letter_t j = 0; j < _nrgens; j++) {
+      letters.push_back(j);
+    }
 
-      for (auto const& x : *coll) {
-        if (!test_membership(x)) {
-          singleton[0] = x;
-          add_generators(singleton);
+    std::vector<Element*> nonredundant;
+    for (size_t c = 0; c < candidates.size(); c++) {
+      letter_t const        a = _nrgens + c;
+      element_index_t const p = U->letter_to_pos(a);
+      if (in_sub[p]) {
+        continue;
+      }
+      nonredundant.push_back(candidates[c]);
+      letters.push_back(a);
+      size_t next = members.size();
+      in_sub[p]   = true;
+      members.push_back(p);
+      // Multiply the old members by the new generator
+      size_t const nr_members = members.size();
+      for (size_t k = 0; k < nr_members; k++) {
+        element_index_t const q = right->get(members[k], a);
+        if (!in_sub[q]) {
+          in_sub[q] = true;
+          members.push_back(q);
+        }
+      }
+      // Multiply the new members by all the generators
+      for (; next < members.size(); next++) {
+        for (letter_t b : letters) {
+          element_index_t const q = right->get(members[next], b);
+          if (!in_sub[q]) {
+            in_sub[q] = true;
+            members.push_back(q);
+          }
         }
       }
     }
+    delete U;
+    add_generators(&nonredundant);
   }
 
   Semigroup*
@@ -767,6 +2141,22 @@ namespace libsemigroups {
 
     std::vector<bool> old_new;  // have we seen _elements->at(i) yet in new?
 
+    // The rows of _left for the elements of length at most _wordlen are
+    // known, and the products of these elements and the old generators do not
+    // change, so they are not computed again below.
+    std::vector<bool> old_left(old_nr, false);
+    for (enumerate_index_t i = 0; i < _lenindex[_wordlen]; i++) {
+      old_left[_enumerate_order[i]] = true;
+    }
+
+    // the elements must be sorted again
+    delete _sorted;
+    delete _sorted_elements;
+    delete _pos_sorted;
+    _sorted          = nullptr;
+    _sorted_elements = nullptr;
+    _pos_sorted      = nullptr;
+
     // erase the old index
     _enumerate_order.erase(_enumerate_order.begin() + _lenindex[1],
                            _enumerate_order.end());
@@ -780,11 +2170,11 @@ namespace libsemigroups {
     // add the new generators to new _gens, _elements, and _enumerate_order
     for (Element const* x : *coll) {
       LIBSEMIGROUPS_ASSERT(x->degree() == degree());
-      auto it = _map.find(x);
-      if (it == _map.end()) {  // new generator
+      element_index_t pos = _map.find(x);
+      if (pos == UNDEFINED) {  // new generator
         _gens->push_back(x->really_copy());
         _elements->push_back(_gens->back());
-        _map.insert(std::make_pair(_gens->back(), _nr));
+        _map.insert(_gens->back(), _nr);
 
         _first.push_back(_gens->size() - 1);
         _final.push_back(_gens->size() - 1);
@@ -798,32 +2188,31 @@ namespace libsemigroups {
         _suffix.push_back(UNDEFINED);
         _length.push_back(1);
         _nr++;
-      } else if (_letter_to_pos[_first[it->second]] == it->second) {
+      } else if (_letter_to_pos[_first[pos]] == pos) {
         _gens->push_back(x->really_copy());
         // x is one of the existing generators
         _duplicate_gens.push_back(
-            std::make_pair(_gens->size() - 1, _first[it->second]));
-        // _gens[_gens.size() - 1] = _gens[_first[it->second])]
+            std::make_pair(_gens->size() - 1, _first[pos]));
+        // _gens[_gens.size() - 1] = _gens[_first[pos])]
         // since _first maps element_index_t -> letter_t
-        _letter_to_pos.push_back(it->second);
+        _letter_to_pos.push_back(pos);
       } else {
         // x is an old element that will now be a generator
-        _gens->push_back((*_elements)[it->second]);
-        _letter_to_pos.push_back(it->second);
-        _enumerate_order.push_back(it->second);
+        _gens->push_back((*_elements)[pos]);
+        _letter_to_pos.push_back(pos);
+        _enumerate_order.push_back(pos);
 
-        _first[it->second]  = _gens->size() - 1;
-        _final[it->second]  = _gens->size() - 1;
-        _prefix[it->second] = UNDEFINED;
-        _suffix[it->second] = UNDEFINED;
-        _length[it->second] = UNDEFINED;
+        _first[pos]  = _gens->size() - 1;
+        _final[pos]  = _gens->size() - 1;
+        _prefix[pos] = UNDEFINED;
+        _suffix[pos] = UNDEFINED;
+        _length[pos] = UNDEFINED;
 
-        old_new[it->second] = true;
+        old_new[pos] = true;
       }
     }
 
     // reset the data structure
-    _idempotents_found = false;
     _nrrules           = _duplicate_gens.size();
     _pos               = 0;
     _wordlen           = 0;
@@ -897,21 +2286,23 @@ namespace libsemigroups {
       if (_pos > _nr || _pos == _lenindex[_wordlen + 1]) {
         if (_wordlen == 0) {
           for (enumerate_index_t i = 0; i < _pos; i++) {
-            size_t b = _final[_enumerate_order[i]];
-            for (letter_t j = 0; j < _nrgens; j++) {
-              // TODO(JDM) reuse old info here!
-              _left->set(
-                  _enumerate_order[i], j, _right->get(_letter_to_pos[j], b));
+            element_index_t k = _enumerate_order[i];
+            size_t          b = _final[k];
+            for (letter_t j = (k < old_nr && old_left[k] ? old_nrgens : 0);
+                 j < _nrgens;
+                 j++) {
+              _left->set(k, j, _right->get(_letter_to_pos[j], b));
             }
           }
         } else {
           for (enumerate_index_t i = _lenindex[_wordlen]; i < _pos; i++) {
-            element_index_t p = _prefix[_enumerate_order[i]];
-            letter_t        b = _final[_enumerate_order[i]];
-            for (letter_t j = 0; j < _nrgens; j++) {
-              // TODO(JDM) reuse old info here!
-              _left->set(
-                  _enumerate_order[i], j, _right->get(_left->get(p, j), b));
+            element_index_t k = _enumerate_order[i];
+            element_index_t p = _prefix[k];
+            letter_t        b = _final[k];
+            for (letter_t j = (k < old_nr && old_left[k] ? old_nrgens : 0);
+                 j < _nrgens;
+                 j++) {
+              _left->set(k, j, _right->get(_left->get(p, j), b));
             }
           }
         }
@@ -936,51 +2327,226 @@ namespace libsemigroups {
 
   // Private methods
 
+  // Sorts the elements in runs of SORT_CHUNK_SIZE consecutive positions,
+  // which are then merged pairwise, as in a bottom up merge sort. Every run is
+  // sorted as a vector of pairs, since comparing the elements through their
+  // positions is slower, and so only SORT_CHUNK_SIZE pairs per thread are
+  // ever stored at once. The runs, and the pairs of runs merged in each
+  // round, are shared out among the threads using an atomic counter.
   void Semigroup::sort_elements() {
     if (_sorted != nullptr) {
       return;
     }
     enumerate();
-    _sorted = new std::vector<std::pair<Element*, element_index_t>>();
-    _sorted->reserve(_elements->size());
-    for (element_index_t i = 0; i < _elements->size(); i++) {
-      _sorted->push_back(std::make_pair((*_elements)[i], i));
-    }
-    std::sort(_sorted->begin(), _sorted->end(), myless(*this));
-  }
-
-  // FIXME(JDM) improve this to either multiply or product_by_reduction
-  // depending on which will be quickest. It is actually slow because of not
-  // doing this
-
-  void Semigroup::idempotents_thread(size_t&                       nr,
-                                     std::vector<element_index_t>& idempotents,
-                                     std::vector<bool>& is_idempotent,
-                                     element_index_t    begin,
-                                     element_index_t    end) {
     Timer timer;
     timer.start();
 
-    for (element_index_t k = begin; k < end; k++) {
-      // this is product_by_reduction, don't have to consider lengths because
-      // they are equal!!
-      element_index_t i = k, j = k;
-      while (j != UNDEFINED) {
-        i = _right->get(i, _first[j]);
-        j = _suffix[j];
+    size_t const n       = _nr;
+    size_t const nr_runs = (n + SORT_CHUNK_SIZE - 1) / SORT_CHUNK_SIZE;
+    size_t const nr_threads
+        = std::max(size_t(1), std::min(_max_threads, nr_runs / 2));
+    if (nr_threads > 1) {
+      REPORT("using " << nr_threads << " threads");
+    }
+    _sorted = new std::vector<element_index_t>(n);
+
+    std::atomic<size_t> next(0);
+    run_in_threads(std::min(nr_threads, nr_runs), [this, n, &next]() {
+      std::vector<std::pair<Element*, element_index_t>> run;
+      run.reserve(SORT_CHUNK_SIZE);
+      for (size_t first = SORT_CHUNK_SIZE * next++; first < n;
+           first        = SORT_CHUNK_SIZE * next++) {
+        size_t const last = std::min(n, first + SORT_CHUNK_SIZE);
+        run.clear();
+        for (element_index_t i = first; i < last; i++) {
+          run.push_back(std::make_pair((*_elements)[i], i));
+        }
+        std::sort(run.begin(), run.end(), myless(*this));
+        for (size_t i = 0; i < run.size(); i++) {
+          (*_sorted)[first + i] = run[i].second;
+        }
       }
-      if (i == k) {
-        idempotents.push_back(k);
-        is_idempotent.push_back(true);
-        nr++;
-      } else {
-        is_idempotent.push_back(false);
+    });
+
+    if (nr_runs > 1) {
+      std::vector<element_index_t> buf(n);
+      element_index_t*             in  = _sorted->data();
+      element_index_t*             out = buf.data();
+      for (size_t width = SORT_CHUNK_SIZE; width < n; width *= 2) {
+        size_t const nr_pairs = (n + 2 * width - 1) / (2 * width);
+        next                  = 0;
+        run_in_threads(
+            std::min(nr_threads, nr_pairs),
+            [this, n, in, out, width, nr_pairs, &next]() {
+              for (size_t p = next++; p < nr_pairs; p = next++) {
+                size_t const first = 2 * width * p;
+                size_t const mid   = std::min(n, first + width);
+                size_t const last  = std::min(n, first + 2 * width);
+                std::merge(in + first,
+                           in + mid,
+                           in + mid,
+                           in + last,
+                           out + first,
+                           myless(*this));
+              }
+            });
+        std::swap(in, out);
+      }
+      if (in != _sorted->data()) {
+        _sorted->swap(buf);
       }
     }
 
+    _pos_sorted = new std::vector<element_index_t>(n);
+    for (element_index_t i = 0; i < n; i++) {
+      (*_pos_sorted)[(*_sorted)[i]] = i;
+    }
     REPORT(timer.string("elapsed time = "));
   }
 
+  // Every word in a group of at most BATCH_NR_PATHS words is evaluated one
+  // letter at a time, in turn, by following its path in the right Cayley
+  // graph. This is the same as word_to_pos, where fast_product always uses
+  // product_by_reduction because the second argument is a generator.
+  void Semigroup::word_to_pos_thread(std::vector<word_t> const&    words,
+                                     std::vector<element_index_t>& result,
+                                     std::atomic<size_t>& next_chunk) const {
+    size_t const n = words.size();
+    for (size_t first = BATCH_CHUNK_SIZE * next_chunk++; first < n;
+         first        = BATCH_CHUNK_SIZE * next_chunk++) {
+      size_t const last = std::min(n, first + BATCH_CHUNK_SIZE);
+      for (size_t b = first; b < last; b += BATCH_NR_PATHS) {
+        size_t const    e = std::min(last, b + BATCH_NR_PATHS);
+        element_index_t pos[BATCH_NR_PATHS];
+        size_t          max_len = 0;
+        for (size_t k = b; k < e; k++) {
+          LIBSEMIGROUPS_ASSERT(!words[k].empty());
+          LIBSEMIGROUPS_ASSERT(words[k][0] < nrgens());
+          pos[k - b] = letter_to_pos(words[k][0]);
+          max_len    = std::max(max_len, words[k].size());
+        }
+        for (size_t t = 1; t < max_len; t++) {
+          for (size_t k = b; k < e; k++) {
+            if (t < words[k].size()) {
+              LIBSEMIGROUPS_ASSERT(words[k][t] < nrgens());
+              pos[k - b] = _right->get(pos[k - b], words[k][t]);
+            }
+          }
+        }
+        std::copy(pos, pos + (e - b), result.begin() + b);
+      }
+    }
+  }
+
+  // The products in a group of at most BATCH_NR_PATHS pairs which are found
+  // by product_by_reduction are found one step at a time, in turn, and the
+  // others are found by multiplying, as in fast_product.
+  void Semigroup::fast_product_thread(
+      std::vector<std::pair<element_index_t, element_index_t>> const& pairs,
+      std::vector<element_index_t>& result,
+      std::atomic<size_t>&          next_chunk) const {
+    size_t const tid = glob_reporter.thread_id(std::this_thread::get_id());
+    Element*     tmp = _tmp_product->really_copy();
+    size_t const complexity = 2 * tmp->complexity();
+    size_t const n          = pairs.size();
+
+    for (size_t first = BATCH_CHUNK_SIZE * next_chunk++; first < n;
+         first        = BATCH_CHUNK_SIZE * next_chunk++) {
+      size_t const last = std::min(n, first + BATCH_CHUNK_SIZE);
+      for (size_t b = first; b < last; b += BATCH_NR_PATHS) {
+        size_t const    e = std::min(last, b + BATCH_NR_PATHS);
+        element_index_t i[BATCH_NR_PATHS];
+        element_index_t j[BATCH_NR_PATHS];
+        bool            reduce[BATCH_NR_PATHS];
+        bool            left[BATCH_NR_PATHS];
+        bool            busy = false;
+        for (size_t k = 0; k < e - b; k++) {
+          i[k] = pairs[b + k].first;
+          j[k] = pairs[b + k].second;
+          LIBSEMIGROUPS_ASSERT(i[k] < _nr && j[k] < _nr);
+          reduce[k] = (length_const(i[k]) < complexity
+                       || length_const(j[k]) < complexity);
+          left[k] = (length_const(i[k]) <= length_const(j[k]));
+          if (reduce[k]) {
+            busy = true;
+          } else {
+            tmp->redefine((*_elements)[i[k]], (*_elements)[j[k]], tid);
+            result[b + k] = _map.find(tmp);
+          }
+        }
+        while (busy) {
+          busy = false;
+          for (size_t k = 0; k < e - b; k++) {
+            if (!reduce[k]) {
+              continue;
+            } else if (left[k] && i[k] != UNDEFINED) {
+              j[k] = _left->get(j[k], _final[i[k]]);
+              i[k] = _prefix[i[k]];
+              busy = true;
+            } else if (!left[k] && j[k] != UNDEFINED) {
+              i[k] = _right->get(i[k], _first[j[k]]);
+              j[k] = _suffix[j[k]];
+              busy = true;
+            }
+          }
+        }
+        for (size_t k = 0; k < e - b; k++) {
+          if (reduce[k]) {
+            result[b + k] = (left[k] ? j[k] : i[k]);
+          }
+        }
+      }
+    }
+    tmp->really_delete();
+    delete tmp;
+  }
+
+  void Semigroup::idempotents_thread(std::atomic<size_t>& next_chunk,
+                                     element_index_t      first,
+                                     element_index_t      last,
+                                     bool                 use_graph) {
+    Timer timer;
+    timer.start();
+    size_t   tid        = glob_reporter.thread_id(std::this_thread::get_id());
+    Element* tmp        = _tmp_product->really_copy();
+    size_t   complexity = tmp->complexity();
+    size_t   nr         = 0;
+
+    element_index_t const base = first - (first % IDEMPOTENTS_CHUNK_SIZE);
+    for (size_t c = next_chunk++;
+         base + c * IDEMPOTENTS_CHUNK_SIZE < last;
+         c = next_chunk++) {
+      element_index_t const begin
+          = std::max(first, base + c * IDEMPOTENTS_CHUNK_SIZE);
+      element_index_t const end
+          = std::min(last, base + (c + 1) * IDEMPOTENTS_CHUNK_SIZE);
+      for (element_index_t k = begin; k < end; k++) {
+        bool is_idem;
+        if (use_graph && _length[k] < complexity) {
+          // this is product_by_reduction, don't have to consider lengths
+          // because they are equal!!
+          element_index_t i = k, j = k;
+          while (j != UNDEFINED) {
+            i = _right->get(i, _first[j]);
+            j = _suffix[j];
+          }
+          is_idem = (i == k);
+        } else {
+          tmp->redefine((*_elements)[k], (*_elements)[k], tid);
+          is_idem = (*tmp == *(*_elements)[k]);
+        }
+        if (is_idem) {
+          _is_idempotent[k / 64] |= uint64_t(1) << (k % 64);
+          nr++;
+        }
+      }
+    }
+    tmp->really_delete();
+    delete tmp;
+    REPORT("found " << nr << " idempotents, "
+                    << timer.string("elapsed time = "));
+  }
+
   void inline Semigroup::closure_update(element_index_t    i,
                                         letter_t           j,
                                         letter_t           b,
@@ -999,14 +2565,14 @@ namespace libsemigroups {
       }
     } else {
       _tmp_product->redefine((*_elements)[i], (*_gens)[j], tid);
-      auto it = _map.find(_tmp_product);
-      if (it == _map.end()) {  // it's new!
+      element_index_t pos = _map.find(_tmp_product);
+      if (pos == UNDEFINED) {  // it's new!
         is_one(_tmp_product, _nr);
         _elements->push_back(_tmp_product->really_copy());
         _first.push_back(b);
         _final.push_back(j);
         _length.push_back(_wordlen + 2);
-        _map.insert(std::make_pair(_elements->back(), _nr));
+        _map.insert(_elements->back(), _nr);
         _prefix.push_back(i);
         _reduced.set(i, j, true);
         _right->set(i, j, _nr);
@@ -1017,25 +2583,25 @@ namespace libsemigroups {
         }
         _enumerate_order.push_back(_nr);
         _nr++;
-      } else if (it->second < old_nr && !old_new[it->second]) {
+      } else if (pos < old_nr && !old_new[pos]) {
         // we didn't process it yet!
-        is_one(_tmp_product, it->second);
-        _first[it->second]  = b;
-        _final[it->second]  = j;
-        _length[it->second] = _wordlen + 2;
-        _prefix[it->second] = i;
+        is_one(_tmp_product, pos);
+        _first[pos]  = b;
+        _final[pos]  = j;
+        _length[pos] = _wordlen + 2;
+        _prefix[pos] = i;
         _reduced.set(i, j, true);
-        _right->set(i, j, it->second);
+        _right->set(i, j, pos);
         if (_wordlen == 0) {
-          _suffix[it->second] = _letter_to_pos[j];
+          _suffix[pos] = _letter_to_pos[j];
         } else {
-          _suffix[it->second] = _right->get(s, j);
+          _suffix[pos] = _right->get(s, j);
         }
-        _enumerate_order.push_back(it->second);
-        old_new[it->second] = true;
-      } else {  // it->second >= old->_nr || old_new[it->second]
+        _enumerate_order.push_back(pos);
+        old_new[pos] = true;
+      } else {  // pos >= old->_nr || old_new[pos]
         // it's old
-        _right->set(i, j, it->second);
+        _right->set(i, j, pos);
         _nrrules++;
       }
     }
@@ -1045,99 +2611,59 @@ namespace libsemigroups {
   // product if we fall out of the R-class of the initial element.
 
   void Semigroup::find_idempotents() {
-    _idempotents_found = true;
-    enumerate();
-
+    std::lock_guard<std::mutex> lg(_mtx);
+    element_index_t const       first = _idempotents_start_pos;
+    element_index_t const       last  = _nr;
+    if (first >= last) {
+      return;
+    }
     Timer timer;
     timer.start();
 
-    size_t sum_word_lengths = 0;
-    for (size_t i = length_non_const(_idempotents_start_pos);
-         i < _lenindex.size();
-         i++) {
-      sum_word_lengths += i * (_lenindex[i] - _lenindex[i - 1]);
-    }
-
-    if (_max_threads == 1 || size() < 823543) {
-      if ((_nr - _idempotents_start_pos) * _tmp_product->complexity()
-          < sum_word_lengths) {
-        for (element_index_t i = _idempotents_start_pos; i < _nr; i++) {
-          _tmp_product->redefine((*_elements)[i], (*_elements)[i]);
-          if (*_tmp_product == *(*_elements)[i]) {
-            _nridempotents++;
-            _idempotents.push_back(i);
-            _is_idempotent.push_back(true);
-          } else {
-            _is_idempotent.push_back(false);
-          }
-        }
-      } else {
-        for (size_t i = _idempotents_start_pos; i < _nr; i++) {
-          // TODO(JDM) redo this to not use product_by_reduction
-          if (product_by_reduction(i, i) == i) {
-            _nridempotents++;
-            _idempotents.push_back(i);
-            _is_idempotent.push_back(true);
-          } else {
-            _is_idempotent.push_back(false);
-          }
-        }
-      }
-    } else {
-      size_t          av_load    = sum_word_lengths / _max_threads;
-      element_index_t begin      = _idempotents_start_pos;
-      element_index_t end        = _idempotents_start_pos;
-      size_t          total_load = 0;
-
-      std::vector<size_t>                       nr(_max_threads, 0);
-      std::vector<std::vector<element_index_t>> idempotents(
-          _max_threads, std::vector<element_index_t>());
-      std::vector<std::vector<bool>> is_idempotent(_max_threads,
-                                                   std::vector<bool>());
-      std::vector<std::thread> threads;
-      glob_reporter.reset_thread_ids();
-
-      // TODO(JDM) use less threads if the av_load is too low
-      for (size_t i = 0; i < _max_threads; i++) {
-        size_t thread_load = 0;
-        if (i != _max_threads - 1) {
-          while (thread_load < av_load) {
-            thread_load += length_const(end);
-            end++;
-          }
-          total_load += thread_load;
-        } else {
-          end         = size();
-          thread_load = sum_word_lengths - total_load;
-        }
+    _is_idempotent.resize((last + 63) / 64, 0);
 
-        REPORT("thread " << i + 1 << " has load " << thread_load)
+    // The Cayley graph can only be used to compute the square of an element
+    // when the semigroup is fully enumerated.
+    bool const   use_graph = is_done();
+    size_t const nr_chunks
+        = (last - 1) / IDEMPOTENTS_CHUNK_SIZE - first / IDEMPOTENTS_CHUNK_SIZE
+          + 1;
+    size_t const nr_threads
+        = std::max(size_t(1), std::min(_max_threads, nr_chunks));
+    std::atomic<size_t> next_chunk(0);
 
+    if (nr_threads == 1) {
+      idempotents_thread(next_chunk, first, last, use_graph);
+    } else {
+      REPORT("using " << nr_threads << " threads");
+      glob_reporter.reset_thread_ids();
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < nr_threads; i++) {
         threads.push_back(std::thread(&Semigroup::idempotents_thread,
                                       this,
-                                      std::ref(nr[i]),
-                                      std::ref(idempotents[i]),
-                                      std::ref(is_idempotent[i]),
-                                      begin,
-                                      end));
-        begin = end;
+                                      std::ref(next_chunk),
+                                      first,
+                                      last,
+                                      use_graph));
       }
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+    }
 
-      for (size_t i = 0; i < _max_threads; i++) {
-        threads[i].join();
-        _nridempotents += nr[i];
+    // Collect the positions of the new idempotents, in order
+    for (size_t w = first / 64; w < _is_idempotent.size(); w++) {
+      uint64_t bits = _is_idempotent[w];
+      if (w == first / 64) {
+        bits &= ~uint64_t(0) << (first % 64);
       }
-      _idempotents.reserve(_nridempotents);
-      _is_idempotent.reserve(size());
-      for (size_t i = 0; i < _max_threads; i++) {
-        _idempotents.insert(
-            _idempotents.end(), idempotents[i].begin(), idempotents[i].end());
-        _is_idempotent.insert(_is_idempotent.end(),
-                              is_idempotent[i].begin(),
-                              is_idempotent[i].end());
+      while (bits != 0) {
+        _idempotents.push_back(64 * w + __builtin_ctzll(bits));
+        bits &= bits - 1;
       }
     }
-    _idempotents_start_pos = _nr;
+    _nridempotents         = _idempotents.size();
+    _idempotents_start_pos = last;
     REPORT(timer.string("elapsed time = "));
   }
 
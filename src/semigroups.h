@@ -20,15 +20,20 @@
 #define LIBSEMIGROUPS_SRC_SEMIGROUPS_H_
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <thread>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "elementmap.h"
 #include "elements.h"
 #include "libsemigroups-debug.h"
+#include "metrics.h"
 #include "recvec.h"
 #include "report.h"
 
@@ -89,7 +94,16 @@ namespace libsemigroups {
     typedef index_t element_index_t;
 
     //! Type for a left or right Cayley graph of a semigroup.
-    typedef RecVec<element_index_t> cayley_graph_t;
+    //!
+    //! The entries are stored in a std::vector by default. If libsemigroups
+    //! is configured with \c --with-cayley-graph-storage=packed, then every
+    //! entry uses only as many bits as the largest entry requires, and if it
+    //! is configured with \c --with-cayley-graph-storage=mmap, then the
+    //! entries are stored in a memory-mapped temporary file, so that the
+    //! Cayley graphs can be larger than the available memory. See
+    //! storage.h for details.
+    typedef RecVec<element_index_t, GraphStorage<element_index_t>>
+        cayley_graph_t;
 
    public:
     //! Deleted.
@@ -155,7 +169,7 @@ namespace libsemigroups {
 
    public:
     //! A default destructor.
-    ~Semigroup();
+    virtual ~Semigroup();
 
     //! Returns the position in the semigroup corresponding to the element
     //! represented by the word \p w.
@@ -169,6 +183,20 @@ namespace libsemigroups {
     //! \sa Semigroup::word_to_element.
     element_index_t word_to_pos(word_t const& w) const;
 
+    //! Puts the position in the semigroup of the element represented by
+    //! \c words[i] into \c result[i], for every \c i.
+    //!
+    //! Every word in \p words must be non-empty and consist of non-negative
+    //! integers less than Semigroup::nrgens. The result is the same as that of
+    //! calling Semigroup::word_to_pos for every word, but the paths in the
+    //! right Cayley graph for several words are followed at once, and large
+    //! numbers of words are shared among threads (see
+    //! Semigroup::set_max_threads).
+    //!
+    //! \sa Semigroup::word_to_pos.
+    void word_to_pos(std::vector<word_t> const&    words,
+                     std::vector<element_index_t>& result) const;
+
     //! Returns a pointer to the element of \c this represented by the word
     //! \p w.
     //!
@@ -247,16 +275,14 @@ namespace libsemigroups {
     //! libsemigroups::Semigroup::UNDEFINED when \p x is in the semigroup,
     //! but not this is not yet known.
     //!
+    //! This method can be called while another thread enumerates \c this;
+    //! it then returns the position of \p x among the elements found before
+    //! the last time the enumeration paused for readers (see
+    //! Semigroup::set_batch_size).
+    //!
     //! \sa Semigroup::position and Semigroup::sorted_position.
     //! FIXME these should be Element const*
-    element_index_t current_position(Element* x) const {
-      if (x->degree() != _degree) {
-        return UNDEFINED;
-      }
-
-      auto it = _map.find(x);
-      return (it == _map.end() ? UNDEFINED : it->second);
-    }
+    element_index_t current_position(Element* x) const;
 
     //! Returns the number of elements in the semigroup that have been
     //! enumerated so far.
@@ -389,6 +415,20 @@ namespace libsemigroups {
     //! transformations together.
     element_index_t fast_product(element_index_t i, element_index_t j) const;
 
+    //! Puts the position in \c this of the product of \c
+    //! this->at(pairs[k].first) and \c this->at(pairs[k].second) into \c
+    //! result[k], for every \c k.
+    //!
+    //! The result is the same as that of calling Semigroup::fast_product for
+    //! every pair in \p pairs, but the paths in the Cayley graphs for several
+    //! pairs are followed at once, and large numbers of pairs are shared among
+    //! threads (see Semigroup::set_max_threads).
+    //!
+    //! \sa Semigroup::fast_product.
+    void fast_product(
+        std::vector<std::pair<element_index_t, element_index_t>> const& pairs,
+        std::vector<element_index_t>& result) const;
+
     //! Returns the position in \c this of the generator with index \p i
     //!
     //! This method asserts that the value of \p i is valid.  In many cases \p
@@ -408,14 +448,26 @@ namespace libsemigroups {
     //!
     //! This method involves fully enumerating the semigroup, if it is not
     //! already fully enumerated.  The value of the positions, and number, of
-    //! idempotents is stored after they are first computed.
+    //! idempotents is stored after they are first computed, and only the
+    //! elements enumerated since the last time that the idempotents were
+    //! computed are checked, using multiple threads if possible (see
+    //! Semigroup::set_max_threads).
     size_t nridempotents();
 
+    //! Returns the number of idempotents among the elements of the semigroup
+    //! that have been enumerated so far.
+    //!
+    //! This method does not enumerate the semigroup any further, and only
+    //! checks the elements enumerated since the last time that the
+    //! idempotents were computed.
+    size_t current_nridempotents();
+
     //! Returns \c true if the element in position \p pos is an idempotent
     //! and \c false if it is not.
     //!
-    //! This method involves fully enumerating the semigroup, if it is not
-    //! already fully enumerated.
+    //! This method enumerates the semigroup until it contains at least
+    //! \p pos + 1 elements, but not necessarily any further, and so \p pos
+    //! must be less than the size of the semigroup.
     bool is_idempotent(element_index_t pos);
 
     //! Returns a const iterator pointing at the first position of an
@@ -456,11 +508,143 @@ namespace libsemigroups {
     //! This is used by, for example, Semigroup::position so that it is
     //! possible to find the position of an element without fully enumerating
     //! the semigroup.
+    //!
+    //! If the batch size is adaptive (see Semigroup::set_adaptive_batch_size),
+    //! then \p batch_size is the least, and initial, value of the batch size.
     // FIXME Make _batch_size mutable and this const
     void set_batch_size(size_t batch_size) {
-      _batch_size = batch_size;
+      _batch_size           = batch_size;
+      _min_batch_size       = batch_size;
+      _batch_size_threshold = LIMIT_MAX;
+    }
+
+    //! Set whether or not the batch size is changed according to the time
+    //! taken to enumerate each batch.
+    //!
+    //! If \p val is \c true, then the batch size is changed after every call
+    //! to Semigroup::enumerate which asks for fewer elements than the batch
+    //! size, such as those made by Semigroup::position, in the same way as the
+    //! congestion window in TCP. The batch size is doubled after every such
+    //! call, until the first call which takes longer than a fixed amount of
+    //! time (a fraction of a second). After this, the batch size is halved
+    //! whenever a call takes longer than this amount of time, and increased
+    //! by the value set by Semigroup::set_batch_size otherwise. Hence finding
+    //! an element a long way into a large semigroup requires relatively few
+    //! calls to Semigroup::enumerate, without any call taking too long. The
+    //! batch size is never less than the value set by
+    //! Semigroup::set_batch_size.
+    //!
+    //! If \p val is \c false, which is the default, then the batch size is
+    //! always the value set by Semigroup::set_batch_size.
+    void set_adaptive_batch_size(bool val) {
+      _adaptive_batch_size = val;
+      if (!val) {
+        set_batch_size(_min_batch_size);
+      }
     }
 
+    //! Set a function to be called after every call to Semigroup::enumerate
+    //! which finds some elements.
+    //!
+    //! The function \p hook is called with the number of elements found, the
+    //! time taken in nanoseconds (measured by a Timer), and the batch size
+    //! for the next call. The elements found per second are also reported
+    //! (see Semigroup::set_report). The function \p hook is called after
+    //! the enumeration has stopped, and so it can call any method of \c this.
+    //!
+    //! The function \p hook is copied by the copy constructor, but not to
+    //! the semigroups returned by Semigroup::copy_add_generators and
+    //! Semigroup::copy_closure, or to those used by Semigroup::closure.
+    void set_batch_hook(std::function<void(size_t, int64_t, size_t)> hook) {
+      _batch_hook = hook;
+    }
+
+    //! Type for the metrics of a semigroup returned by Semigroup::metrics.
+    //!
+    //! All times are in nanoseconds. The counts and times include every call
+    //! to Semigroup::enumerate since \c this was constructed, or since
+    //! Semigroup::reset_metrics was last called.
+    struct metrics_t {
+      //! The number of products of an element and a generator computed using
+      //! Element::redefine.
+      size_t nr_products;
+
+      //! The number of searches of the hash table of elements.
+      size_t nr_lookups;
+
+      //! The total number of slots of the hash table of elements which are
+      //! examined when every element currently in the table is looked up.
+      size_t nr_probes;
+
+      //! The number of elements which are not in the first slot of the hash
+      //! table examined when they are looked up.
+      size_t nr_collisions;
+
+      //! The number of rules found so far, see Semigroup::current_nrrules.
+      size_t nr_rules;
+
+      //! The value in position \c i is the number of elements of length
+      //! \c i + 1 found so far.
+      std::vector<size_t> nr_elements_by_length;
+
+      //! The value in position \c i is the time spent finding the elements of
+      //! length \c i + 1, and so the number of elements of this length found
+      //! per second is \c 1000000000 * nr_elements_by_length[i] /
+      //! time_by_length[i].
+      std::vector<int64_t> time_by_length;
+
+      //! The total time spent in Semigroup::enumerate.
+      int64_t time_enumerate;
+
+      //! An estimate of the time spent in Element::redefine, from the time
+      //! taken by a sample of the products. If more than one thread is used
+      //! (see Semigroup::set_max_threads), then this is the total for all
+      //! threads.
+      int64_t time_redefine;
+
+      //! An estimate of the time spent searching the hash table of elements,
+      //! in the same way as Semigroup::metrics_t::time_redefine.
+      int64_t time_lookup;
+
+      //! The time spent in Semigroup::enumerate, except that in
+      //! Element::redefine and searching the hash table, or \c 0 if the
+      //! estimates of these are larger than
+      //! Semigroup::metrics_t::time_enumerate.
+      int64_t time_bookkeeping;
+
+      //! The number of bytes allocated for the left and right Cayley graphs,
+      //! which depends on the storage selected by the configure option
+      //! --with-cayley-graph-storage.
+      size_t memory_cayley_graphs;
+
+      //! The number of bytes used by the hash table of elements.
+      size_t memory_hash_table;
+
+      //! The number of bytes used by the data defining the minimal
+      //! factorisations of the elements, including the order in which they
+      //! were enumerated.
+      size_t memory_words;
+
+      //! The number of bytes used by the other data of \c this, not including
+      //! the elements themselves.
+      size_t memory_other;
+    };
+
+    //! Returns the current metrics of \c this.
+    //!
+    //! The counters used for this are incremented with relaxed atomic
+    //! loads and stores, in a separate copy for every thread, and so
+    //! collecting the metrics costs very little. This method can be called
+    //! by any number of threads while another thread enumerates \c this, in
+    //! the same way as Semigroup::position.
+    metrics_t metrics() const;
+
+    //! Resets the counts and times returned by Semigroup::metrics to \c 0.
+    //!
+    //! This method must not be called while another thread enumerates \c
+    //! this.
+    void reset_metrics();
+
     //! Requests that the capacity (i.e. number of elements) of the semigroup
     //! be at least enough to contain n elements.
     //!
@@ -498,6 +682,11 @@ namespace libsemigroups {
     //! element \p x if it belongs to the semigroup. The semigroup is
     //! enumerated in batches until \p x is found or the semigroup is fully
     //! enumerated but \p x was not found (see Semigroup::set_batch_size).
+    //!
+    //! This method can be called by any number of threads while another
+    //! thread enumerates \c this. In that case, it waits for the next batch
+    //! to be found instead of enumerating the semigroup itself, and does not
+    //! prevent other threads calling this method at the same time.
     element_index_t position(Element* x);
 
     //! Returns the position of \p x in the sorted array of elements of the
@@ -523,11 +712,12 @@ namespace libsemigroups {
     //! pointer to an element of the semigroup and \c pair.second is the
     //! position of that element in the semigroup. This vector is sorted
     //! according to the Element::operator< method of the elements.
+    //!
+    //! This vector is not used by Semigroup::sorted_at or
+    //! Semigroup::sorted_position, and is only created the first time this
+    //! method is called.
     // TODO(JDM) replace this with a method for sorted_cbegin and sorted_cend.
-    std::vector<std::pair<Element*, element_index_t>>* sorted_elements() {
-      sort_elements();
-      return _sorted;
-    }
+    std::vector<std::pair<Element*, element_index_t>>* sorted_elements();
 
     //! Returns  the element of the semigroup in position \p pos, or a
     //! \c nullptr if there is no such element.
@@ -535,6 +725,9 @@ namespace libsemigroups {
     //! This method attempts to enumerate the semigroup until at least
     //! \c pos + 1 elements have been found. If \p pos is greater than
     //! Semigroup::size, then this method returns \c nullptr.
+    //!
+    //! Like Semigroup::position, this method can be called by any number of
+    //! threads while another thread enumerates \c this.
     Element* at(element_index_t pos);
 
     //! Returns the element of the semigroup in position \p pos.
@@ -598,6 +791,34 @@ namespace libsemigroups {
     //! it factorises an Element instead of using the position of an element.
     word_t* minimal_factorisation(Element* x);
 
+    //! Puts the minimal factorisations of all of the elements of \c this into
+    //! \p letters and \p offsets.
+    //!
+    //! This method fully enumerates the semigroup, and then replaces the
+    //! contents of \p letters with the concatenation of the minimal
+    //! factorisations of the elements in positions \c 0, \c 1, \c 2, and so
+    //! on, and the contents of \p offsets with Semigroup::size + 1 values such
+    //! that the minimal factorisation of the element in position \c pos
+    //! consists of the letters in positions \c offsets[pos] to
+    //! \c offsets[pos + 1] - 1 of \p letters. This is the same as, but much
+    //! faster than, calling Semigroup::minimal_factorisation for every
+    //! element, since every factorisation is obtained by copying part of
+    //! another, and the elements of each length are dealt with using multiple
+    //! threads if possible (see Semigroup::set_max_threads).
+    void minimal_factorisations(std::vector<letter_t>& letters,
+                                std::vector<size_t>&   offsets);
+
+    //! Writes the minimal factorisations of all of the elements of \c this to
+    //! the file \p filename, and returns \c true if this was successful.
+    //!
+    //! The file contains Semigroup::size, the total length of the
+    //! factorisations, and then the values of \c offsets and \c letters as
+    //! described in Semigroup::minimal_factorisations, all as 64-bit integers
+    //! in the byte order of the machine. If possible, the file is
+    //! memory-mapped and the factorisations are found in place, so that they
+    //! are never all held in memory at once.
+    bool minimal_factorisations(std::string const& filename);
+
     //! Changes \p word in-place to contain a word in the generators equal to
     //! the \p pos element of the semigroup.
     //!
@@ -670,6 +891,46 @@ namespace libsemigroups {
     //! \sa Semigroup::reset_next_relation.
     void next_relation(word_t& relation);
 
+    //! This method appends at most \p max of the next relations of the
+    //! presentation defining \c this to \p relations, and returns the number
+    //! appended.
+    //!
+    //! The relations are those that Semigroup::next_relation would return
+    //! if called repeatedly, in the same order, and this method moves
+    //! on the same position in the presentation. Every relation is
+    //! a pair of libsemigroups::word_t which represent the same element, i.e.
+    //! the libsemigroups::relation_t consisting of \c {relation[0]} and \c
+    //! {relation[1]}, or of a factorisation of \c relation[0] followed by \c
+    //! relation[1], and a factorisation of \c relation[2], for every value of
+    //! \c relation found by Semigroup::next_relation. If \c 0 is returned,
+    //! then there are no more relations.
+    //!
+    //! \sa Semigroup::reset_next_relation and Semigroup::relations.
+    size_t next_relations(std::vector<relation_t>& relations, size_t max);
+
+    //! This method appends all of the relations of the presentation defining
+    //! \c this to \p relations, unless \p killed becomes \c true.
+    //!
+    //! The relations appended are the same, and in the same order, as those
+    //! of Semigroup::next_relations called after
+    //! Semigroup::reset_next_relation until it returns \c 0. The relations are
+    //! found in shards of consecutive elements using multiple threads if
+    //! possible (see Semigroup::set_max_threads). This method does not change
+    //! the position used by Semigroup::next_relation. If \p killed becomes \c
+    //! true then \p relations is not modified.
+    void relations(std::vector<relation_t>& relations,
+                   std::atomic<bool>&       killed);
+
+    //! This method appends all of the relations of the presentation defining
+    //! \c this to \p relations.
+    //!
+    //! See Semigroup::relations(std::vector<relation_t>&, std::atomic<bool>&)
+    //! for more details.
+    void relations(std::vector<relation_t>& relations) {
+      std::atomic<bool> killed(false);
+      this->relations(relations, killed);
+    }
+
     //! Enumerate the semigroup until \p limit elements are found or \p killed
     //! is \c true.
     //!
@@ -691,7 +952,19 @@ namespace libsemigroups {
     //! object is destroyed.
     //!
     //! The parameter \p limit defaults to Semigroup::LIMIT_MAX.
-    void enumerate(std::atomic<bool>& killed, size_t limit = LIMIT_MAX);
+    //!
+    //! Every Semigroup::batch_size elements, or sooner if another thread is
+    //! waiting in Semigroup::current_position, Semigroup::position, or
+    //! Semigroup::at, the enumeration pauses to let those threads read the
+    //! elements found so far. No other method of \c this that modifies it,
+    //! such as Semigroup::add_generators, may be called at the same time as
+    //! this method.
+    //!
+    //! This method is overridden by FroidurePin, and so this method does not
+    //! know the type of the elements of the semigroup, and uses the virtual
+    //! methods of Element.
+    virtual void enumerate(std::atomic<bool>& killed,
+                           size_t             limit = LIMIT_MAX);
 
     //! Enumerate the semigroup until \p limit elements are found.
     //!
@@ -790,6 +1063,48 @@ namespace libsemigroups {
     //! should be deleted by the caller.
     Semigroup* copy_closure(std::vector<Element*> const* coll);
 
+    //! Writes the current state of the enumeration of \c this to the file
+    //! \p filename, and returns \c true if this was successful and \c false
+    //! if not.
+    //!
+    //! The file contains the left and right Cayley graphs, and the data
+    //! describing the minimal factorisations of the elements enumerated so
+    //! far, but not the elements themselves, which are recomputed from these
+    //! factorisations by Semigroup::load. The file can only be read by a
+    //! build of libsemigroups on a machine with the same byte order.
+    //!
+    //! The Cayley graphs are stored row by row, as 64-bit integers, starting
+    //! at offsets in the file which are multiples of 4096, so that other
+    //! programs can memory-map them. Semigroup::load does not memory-map
+    //! them, but reads them into new Cayley graphs.
+    //!
+    //! If another thread is enumerating \c this, then this method waits until
+    //! that enumeration has stopped.
+    bool save(std::string const& filename);
+
+    //! Restores the state of an enumeration written by Semigroup::save, and
+    //! returns \c true if this was successful and \c false if not.
+    //!
+    //! This semigroup must have been constructed from the same generators,
+    //! in the same order, as the semigroup which was saved, and it must not
+    //! have been enumerated, i.e. Semigroup::is_begun must return \c false
+    //! and Semigroup::current_size must equal the number of distinct
+    //! generators.
+    //!
+    //! After a successful call, \c this is in the same state as the semigroup
+    //! which was saved, and its enumeration can be continued by calling
+    //! Semigroup::enumerate. The whole file is read, and every element is
+    //! recomputed as the product of its prefix and its final letter, and
+    //! hashed once to rebuild the table used by Semigroup::position. This
+    //! requires one multiplication per element rather than one per element
+    //! and generator, but is not free, and the memory used afterwards is the
+    //! same as if \c this had been enumerated.
+    //!
+    //! If this method returns \c false, because \p filename could not be
+    //! read, is not a file written by Semigroup::save, or was written for
+    //! different generators, then \c this is not modified.
+    bool load(std::string const& filename);
+
     //! This variable is used to indicate that a value is undefined, such as,
     //! for example, the position of an element that does not belong to a
     //! semigroup.
@@ -820,26 +1135,103 @@ namespace libsemigroups {
       _max_threads = std::min(n, std::thread::hardware_concurrency());
     }
 
+   protected:
+    // The implementation of Semigroup::enumerate, where the products of
+    // elements are computed and compared using the methods of TElement
+    // called by their qualified names, so that they are not virtual. Every
+    // element of the semigroup must be an instance of TElement. If TElement
+    // is Element, then the virtual methods are used.
+    //
+    // This is only instantiated, in semigroups.cc, for Element and for the
+    // subclasses of Element for which FroidurePin is provided.
+    template <class TElement>
+    void enumerate_impl(std::atomic<bool>& killed, size_t limit);
+
    private:
-    // Initialise the data member _sorted. We store a list of pairs consisting
-    // of an Element* and element_index_t which is sorted on the first entry
-    // using
-    // the myless subclass. This is done so that we can both get the elements
-    // in sorted order, and find the position of an element in the sorted list
-    // of elements.
+    // Initialise the data members _sorted and _pos_sorted. The vector
+    // _sorted is the permutation of the positions of the elements which sorts
+    // them using the myless subclass, and _pos_sorted is its inverse. This is
+    // done so that we can both get the elements in sorted order, and find the
+    // position of an element in the sorted list of elements.
     void sort_elements();
 
-    // Find the idempotents and store their positions and their number
-    void find_idempotents();
+    // Find the positions of the words in chunks of words, the next of which
+    // is next_chunk, until there are no more chunks, for the batch version of
+    // word_to_pos.
+    void word_to_pos_thread(std::vector<word_t> const&    words,
+                            std::vector<element_index_t>& result,
+                            std::atomic<size_t>&          next_chunk) const;
+
+    // Puts the minimal factorisations of all of the elements into letters and
+    // offsets, which must have room for the total length of the
+    // factorisations, and for _nr + 1 values, respectively.
+    template <typename T>
+    void minimal_factorisations_impl(T* letters, T* offsets) const;
+
+    // Changes the batch size according to the time taken by the last call to
+    // enumerate, in nanoseconds, when the batch size is adaptive.
+    void update_batch_size(int64_t elapsed);
+
+    // Find the relations for the shards of elements, the next of which is
+    // next_shard, until there are no more shards or killed is true, for
+    // relations.
+    void relations_thread(std::vector<std::vector<relation_t>>& shards,
+                          std::atomic<size_t>&                  next_shard,
+                          std::atomic<bool>& killed) const;
+
+    // Find the products of the pairs in chunks of pairs, the next of which
+    // is next_chunk, until there are no more chunks, for the batch version of
+    // fast_product.
+    void fast_product_thread(
+        std::vector<std::pair<element_index_t, element_index_t>> const& pairs,
+        std::vector<element_index_t>& result,
+        std::atomic<size_t>&          next_chunk) const;
+
+    // The methods which read the data of this while another thread
+    // enumerates it call begin_read before and end_read after, and those
+    // that modify the data call begin_write and end_write. Any number of
+    // readers can be between begin_read and end_read at once, as long as no
+    // writer is between begin_write and end_write.
+    void begin_read() const;
+    void end_read() const;
+    void begin_write();
+    void end_write();
+
+    // Pause the enumeration to let readers in, if any are waiting or if
+    // next_pause elements have been found, in which case next_pause is set to
+    // the number of elements at which to pause next. This must only be called
+    // between begin_write and end_write in enumerate_impl.
+    void inline pause_for_readers(index_t& next_pause) {
+      if (_nr >= next_pause
+          || _nr_waiting.load(std::memory_order_relaxed) != 0) {
+        end_write();
+        begin_write();
+        next_pause = _nr + std::min(_batch_size, LIMIT_MAX - _nr);
+      }
+    }
 
-    // Function for counting idempotents in a thread, changes the parameter nr
-    // in place.
+    // If another thread is enumerating this, then wait until it pauses for
+    // readers or stops, unless this has already happened since epoch was
+    // the value of _epoch; otherwise enumerate this until limit elements are
+    // found.
+    void enumerate_or_wait(size_t limit, size_t epoch);
 
-    void idempotents_thread(size_t&                       nr,
-                            std::vector<element_index_t>& idempotents,
-                            std::vector<bool>&            is_idempotent,
-                            element_index_t               begin,
-                            element_index_t               end);
+    // Find the idempotents among the elements enumerated since the last
+    // call, and store their positions and their number.
+    void find_idempotents();
+
+    // Check which of the elements in positions [first, last) are idempotents
+    // and set the corresponding bits of _is_idempotent. The range is split
+    // into chunks, whose indices are taken from next_chunk by every thread
+    // running this method until there are none left, and whose boundaries
+    // are multiples of 64, so that no two threads write to the same word of
+    // _is_idempotent. If use_graph is true, then the right Cayley graph is
+    // used for the elements whose length is less than the complexity of
+    // multiplication.
+    void idempotents_thread(std::atomic<size_t>& next_chunk,
+                            element_index_t      first,
+                            element_index_t      last,
+                            bool                 use_graph);
 
     // Expand the data structures in the semigroup with space for nr elements
 
@@ -860,6 +1252,53 @@ namespace libsemigroups {
       }
     }
 
+    // Multiply the element in position _pos of _enumerate_order by every
+    // generator and update the data structures accordingly. If products is
+    // not nullptr, then products[j] must be the product of this element and
+    // the generator j, and positions[j] must be the position of products[j]
+    // or UNDEFINED, for every j such that _reduced.get(s, j) is true where s
+    // is the suffix of the element; otherwise the products are computed
+    // using _tmp_product.
+    template <class TElement>
+    void inline enumerate_next(Element* const*        products,
+                               element_index_t const* positions,
+                               index_t                limit,
+                               std::atomic<bool>& killed,
+                               bool&              stop,
+                               size_t const&      tid);
+
+    // Compute the products required by enumerate_next for the elements in
+    // positions [first, last) of _enumerate_order, which must all have length
+    // _wordlen + 1, in up to _max_threads threads. The product of the element
+    // in position first + k and the generator j is stored in
+    // products[k * _nrgens + j], and its position in _elements (if any, at
+    // the time of the call) is stored in positions[k * _nrgens + j].
+    template <class TElement>
+    void compute_products(enumerate_index_t             first,
+                          enumerate_index_t             last,
+                          std::vector<Element*>&        products,
+                          std::vector<element_index_t>& positions);
+
+    // Put the product of x and y in xy, using thread_id for Element::redefine,
+    // and return the position of xy, or UNDEFINED. The counters in _counters
+    // for the thread with id thread_id are incremented, and one in every
+    // METRICS_SAMPLE_PERIOD calls in a thread is timed.
+    template <class TElement>
+    element_index_t product_and_find(Element*       xy,
+                                     Element const* x,
+                                     Element const* y,
+                                     size_t         thread_id);
+
+    // Compute the products in compute_products for the elements in positions
+    // [first, last) of _enumerate_order in a single thread.
+    template <class TElement>
+    void compute_products_thread(enumerate_index_t             offset,
+                                 enumerate_index_t             first,
+                                 enumerate_index_t             last,
+                                 std::vector<Element*>&        products,
+                                 std::vector<element_index_t>& positions,
+                                 size_t                        thread_id);
+
     // Update the data structure in add_generators
     void inline closure_update(element_index_t    i,
                                letter_t           j,
@@ -871,20 +1310,29 @@ namespace libsemigroups {
 
     struct myless {
       // For sorting the elements of \c this.
-      explicit myless(Semigroup const& semigroup) : _semigroup(semigroup) {}
+      explicit myless(Semigroup const& semigroup)
+          : _elements(semigroup._elements->data()) {}
 
-      bool operator()(std::pair<Element const*, element_index_t> const& x,
-                      std::pair<Element const*, element_index_t> const& y) {
+      bool operator()(element_index_t x, element_index_t y) const {
+        return *_elements[x] < *_elements[y];
+      }
+
+      bool operator()(std::pair<Element*, element_index_t> const& x,
+                      std::pair<Element*, element_index_t> const& y) const {
         return *(x.first) < *(y.first);
       }
 
-      Semigroup const& _semigroup;
+      Element* const* _elements;
     };
 
     void copy_gens();
 
-    element_index_t _batch_size;
-    element_index_t _degree;
+    bool                                         _adaptive_batch_size;
+    std::function<void(size_t, int64_t, size_t)> _batch_hook;
+    element_index_t                              _batch_size;
+    element_index_t                              _batch_size_threshold;
+    Counters<5>                                  _counters;
+    element_index_t                              _degree;
     std::vector<std::pair<letter_t, letter_t>> _duplicate_gens;
     std::vector<Element*>*         _elements;
     std::vector<letter_t>          _final;
@@ -893,23 +1341,23 @@ namespace libsemigroups {
     std::vector<Element*>*         _gens;
     Element*                       _id;
     std::vector<element_index_t>   _idempotents;
-    bool                           _idempotents_found;
     element_index_t                _idempotents_start_pos;
-    std::vector<bool>              _is_idempotent;
+    std::vector<uint64_t>          _is_idempotent;
     std::vector<element_index_t>   _enumerate_order;
+    bool                           _enumerating;
+    std::atomic<size_t>            _epoch;
     cayley_graph_t*                _left;
     std::vector<index_t>           _length;
     std::vector<enumerate_index_t> _lenindex;
     std::vector<element_index_t>   _letter_to_pos;
-    std::unordered_map<const Element*,
-                       element_index_t,
-                       Element::Hash,
-                       Element::Equal>
-                                  _map;
+    ElementMap<element_index_t>   _map;
     size_t                        _max_threads;
+    element_index_t               _min_batch_size;
     std::vector<bool>             _multiplied;
     std::mutex                    _mtx;
     index_t                       _nr;
+    mutable std::atomic<size_t>   _nr_readers;
+    mutable std::atomic<size_t>   _nr_waiting;
     letter_t                      _nrgens;
     index_t                       _nridempotents;
     size_t                        _nrrules;
@@ -917,14 +1365,108 @@ namespace libsemigroups {
     element_index_t               _pos_one;
     std::vector<element_index_t>* _pos_sorted;
     std::vector<element_index_t>  _prefix;
+    mutable std::condition_variable _read_cv;
+    mutable std::mutex              _read_mtx;
     flags_t                       _reduced;
     letter_t                      _relation_gen;
     enumerate_index_t             _relation_pos;
     cayley_graph_t*               _right;
-    std::vector<std::pair<Element*, element_index_t>>* _sorted;
+    std::vector<element_index_t>* _sorted;
+    std::vector<std::pair<Element*, element_index_t>>* _sorted_elements;
     std::vector<element_index_t> _suffix;
+    std::vector<int64_t>         _time_by_length;
+    int64_t                      _time_enumerate;
     Element*                     _tmp_product;
     size_t                       _wordlen;
+    std::atomic<bool>            _writing;
+  };
+
+  // The subclasses of Element for which Semigroup::enumerate_impl is
+  // instantiated in semigroups.cc, and so for which FroidurePin can be used.
+  // This must be kept in sync with the instantiations in semigroups.cc.
+  template <class TElement>
+  struct is_froidure_pin_element : std::false_type {};
+  template <>
+  struct is_froidure_pin_element<Transformation<u_int8_t>> : std::true_type {};
+  template <>
+  struct is_froidure_pin_element<Transformation<u_int16_t>> : std::true_type {};
+  template <>
+  struct is_froidure_pin_element<Transformation<u_int32_t>> : std::true_type {};
+  template <>
+  struct is_froidure_pin_element<PartialPerm<u_int8_t>> : std::true_type {};
+  template <>
+  struct is_froidure_pin_element<PartialPerm<u_int16_t>> : std::true_type {};
+  template <>
+  struct is_froidure_pin_element<PartialPerm<u_int32_t>> : std::true_type {};
+  template <> struct is_froidure_pin_element<BooleanMat> : std::true_type {};
+  template <>
+  struct is_froidure_pin_element<PackedBooleanMat> : std::true_type {};
+  template <> struct is_froidure_pin_element<Bipartition> : std::true_type {};
+  template <> struct is_froidure_pin_element<PBR> : std::true_type {};
+  template <> struct is_froidure_pin_element<PackedPBR> : std::true_type {};
+
+  //! Class for semigroups generated by instances of a particular subclass of
+  //! Element.
+  //!
+  //! This class is the same as Semigroup except that every element of the
+  //! semigroup must be an instance of the template parameter \p TElement, and
+  //! Semigroup::enumerate multiplies, hashes, and compares elements without
+  //! calling the virtual methods of Element, which is faster. The type
+  //! \p TElement must be one of Transformation<u_int8_t>,
+  //! Transformation<u_int16_t>, Transformation<u_int32_t>,
+  //! PartialPerm<u_int8_t>, PartialPerm<u_int16_t>, PartialPerm<u_int32_t>,
+  //! BooleanMat, PackedBooleanMat, Bipartition, PBR, or PackedPBR, and
+  //! using any other type, such as FixedTransformation, is a compile time
+  //! error.
+  //!
+  //! A FroidurePin can be used wherever a Semigroup can be used.
+  template <class TElement> class FroidurePin : public Semigroup {
+    static_assert(is_froidure_pin_element<TElement>::value,
+                  "FroidurePin is only provided for Transformation, "
+                  "PartialPerm, BooleanMat, PackedBooleanMat, Bipartition, "
+                  "PBR, and PackedPBR");
+
+   public:
+    //! Construct from generators.
+    //!
+    //! See Semigroup::Semigroup; every element of \p gens must be an
+    //! instance of \p TElement.
+    explicit FroidurePin(std::vector<Element*> const* gens) : Semigroup(gens) {
+      check_gens();
+    }
+
+    //! Construct from generators.
+    //!
+    //! See Semigroup::Semigroup; every element of \p gens must be an
+    //! instance of \p TElement.
+    explicit FroidurePin(std::vector<Element*> const& gens) : Semigroup(gens) {
+      check_gens();
+    }
+
+    //! Copy constructor.
+    //!
+    //! See Semigroup::Semigroup(const Semigroup& copy).
+    FroidurePin(FroidurePin const& copy) : Semigroup(copy) {}
+
+    using Semigroup::enumerate;
+
+    //! Enumerate the semigroup until \p limit elements are found or \p killed
+    //! is \c true.
+    //!
+    //! See Semigroup::enumerate(std::atomic<bool>& killed, size_t limit) for
+    //! more details.
+    void enumerate(std::atomic<bool>& killed,
+                   size_t             limit = LIMIT_MAX) override {
+      enumerate_impl<TElement>(killed, limit);
+    }
+
+   private:
+    void check_gens() const {
+      for (size_t i = 0; i < nrgens(); i++) {
+        LIBSEMIGROUPS_ASSERT(dynamic_cast<TElement const*>(gens(i))
+                             != nullptr);
+      }
+    }
   };
 
   //! This is just for backwards compatibility and will disappear in the next
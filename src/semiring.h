@@ -21,8 +21,11 @@
 
 #include <limits.h>
 
+#include <stddef.h>
+
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 
 #include "libsemigroups-debug.h"
 
@@ -70,6 +73,64 @@ namespace libsemigroups {
 
     //! Returns the product of \p x and \p y.
     virtual int64_t prod(int64_t x, int64_t y) const = 0;
+
+    //! Multiplies the matrices \p x and \p y and stores the result in \p xy.
+    //!
+    //! The parameters \p x, \p y, and \p xy must point to the entries of
+    //! square matrices of dimension \p n, stored row by row, and \p xy must
+    //! not overlap \p x or \p y. This is used by MatrixOverSemiring::redefine.
+    //!
+    //! This method calls Semiring::plus and Semiring::prod for every entry. It
+    //! is overridden by the semirings in this file so that the operations are
+    //! not virtual calls and can be inlined.
+    virtual void matrix_product(int64_t const* x,
+                                int64_t const* y,
+                                int64_t*       xy,
+                                size_t         n) const {
+      matrix_product(
+          x,
+          y,
+          xy,
+          n,
+          zero(),
+          [this](int64_t a, int64_t b) { return this->plus(a, b); },
+          [this](int64_t a, int64_t b) { return this->prod(a, b); });
+    }
+
+   protected:
+    //! Multiplies matrices using the functions \p plus and \p prod.
+    //!
+    //! See Semiring::matrix_product for details of \p x, \p y, \p xy, and
+    //! \p n. The parameter \p zero must be the zero of the semiring.
+    //!
+    //! The entries are computed a row at a time: for every \c i and \c k, the
+    //! products of the entry \c x[i][k] and the entries in row \c k of \p y
+    //! are added to the entries in row \c i of \p xy. This inner loop has no
+    //! dependencies between its iterations, and is skipped if \c x[i][k] is
+    //! \p zero, since \p zero annihilates the semiring.
+    template <typename TPlus, typename TProd>
+    static inline void matrix_product(int64_t const* x,
+                                      int64_t const* y,
+                                      int64_t*       xy,
+                                      size_t         n,
+                                      int64_t        zero,
+                                      TPlus          plus,
+                                      TProd          prod) {
+      for (size_t i = 0; i < n; i++) {
+        int64_t* row = xy + i * n;
+        std::fill(row, row + n, zero);
+        for (size_t k = 0; k < n; k++) {
+          int64_t const a = x[i * n + k];
+          if (a == zero) {
+            continue;
+          }
+          int64_t const* yrow = y + k * n;
+          for (size_t j = 0; j < n; j++) {
+            row[j] = plus(row[j], prod(a, yrow[j]));
+          }
+        }
+      }
+    }
   };
 
   //! The usual ring of integers.
@@ -96,6 +157,23 @@ namespace libsemigroups {
     int64_t plus(int64_t x, int64_t y) const override {
       return x + y;
     }
+
+    //! Multiplies the matrices \p x and \p y and stores the result in \p xy.
+    //!
+    //! See Semiring::matrix_product.
+    void matrix_product(int64_t const* x,
+                        int64_t const* y,
+                        int64_t*       xy,
+                        size_t         n) const override {
+      Semiring::matrix_product(
+          x,
+          y,
+          xy,
+          n,
+          0,
+          [](int64_t a, int64_t b) { return a + b; },
+          [](int64_t a, int64_t b) { return a * b; });
+    }
   };
 
   //! The *max-plus semiring* consists of the integers together with negative
@@ -128,6 +206,28 @@ namespace libsemigroups {
     int64_t plus(int64_t x, int64_t y) const override {
       return std::max(x, y);
     }
+
+    //! Multiplies the matrices \p x and \p y and stores the result in \p xy.
+    //!
+    //! See Semiring::matrix_product. Entries of \p x equal to
+    //! Semiring::MINUS_INFTY are skipped, and so only the entries of \p y are
+    //! compared with Semiring::MINUS_INFTY, using a select rather than a
+    //! branch.
+    void matrix_product(int64_t const* x,
+                        int64_t const* y,
+                        int64_t*       xy,
+                        size_t         n) const override {
+      Semiring::matrix_product(
+          x,
+          y,
+          xy,
+          n,
+          MINUS_INFTY,
+          [](int64_t a, int64_t b) { return (a > b ? a : b); },
+          [](int64_t a, int64_t b) {
+            return (b == MINUS_INFTY ? MINUS_INFTY : a + b);
+          });
+    }
   };
 
   //! The *min-plus semiring* consists of the integers together
@@ -160,6 +260,23 @@ namespace libsemigroups {
     int64_t plus(int64_t x, int64_t y) const override {
       return std::min(x, y);
     }
+
+    //! Multiplies the matrices \p x and \p y and stores the result in \p xy.
+    //!
+    //! See Semiring::matrix_product and MaxPlusSemiring::matrix_product.
+    void matrix_product(int64_t const* x,
+                        int64_t const* y,
+                        int64_t*       xy,
+                        size_t         n) const override {
+      Semiring::matrix_product(
+          x,
+          y,
+          xy,
+          n,
+          INFTY,
+          [](int64_t a, int64_t b) { return (a < b ? a : b); },
+          [](int64_t a, int64_t b) { return (b == INFTY ? INFTY : a + b); });
+    }
   };
 
   //! This abstract class provides common methods for its subclasses
@@ -227,6 +344,31 @@ namespace libsemigroups {
                            || y == Semiring::MINUS_INFTY);
       return std::max(x, y);
     }
+
+    //! Multiplies the matrices \p x and \p y and stores the result in \p xy.
+    //!
+    //! See Semiring::matrix_product and MaxPlusSemiring::matrix_product. The
+    //! sum of two entries is the minimum of their sum and the threshold.
+    void matrix_product(int64_t const* x,
+                        int64_t const* y,
+                        int64_t*       xy,
+                        size_t         n) const override {
+      int64_t const t = threshold();
+      Semiring::matrix_product(
+          x,
+          y,
+          xy,
+          n,
+          MINUS_INFTY,
+          [](int64_t a, int64_t b) { return (a > b ? a : b); },
+          [t](int64_t a, int64_t b) -> int64_t {
+            // <b> is checked first, since a + b may overflow otherwise
+            if (b == MINUS_INFTY) {
+              return MINUS_INFTY;
+            }
+            return (a + b < t ? a + b : t);
+          });
+    }
   };
 
   //! The **tropical min-plus semiring** consists of the integers
@@ -277,6 +419,31 @@ namespace libsemigroups {
       }
       return std::min(x, y);
     }
+
+    //! Multiplies the matrices \p x and \p y and stores the result in \p xy.
+    //!
+    //! See Semiring::matrix_product and MaxPlusSemiring::matrix_product. The
+    //! sum of two entries is the minimum of their sum and the threshold.
+    void matrix_product(int64_t const* x,
+                        int64_t const* y,
+                        int64_t*       xy,
+                        size_t         n) const override {
+      int64_t const t = threshold();
+      Semiring::matrix_product(
+          x,
+          y,
+          xy,
+          n,
+          INFTY,
+          [](int64_t a, int64_t b) { return (a < b ? a : b); },
+          [t](int64_t a, int64_t b) -> int64_t {
+            // <b> is checked first, since a + b may overflow otherwise
+            if (b == INFTY) {
+              return INFTY;
+            }
+            return (a + b < t ? a + b : t);
+          });
+    }
   };
 
   //! This class implements the *semiring* consisting of
@@ -332,6 +499,45 @@ namespace libsemigroups {
       return _period;
     }
 
+    //! Multiplies the matrices \p x and \p y and stores the result in \p xy.
+    //!
+    //! See Semiring::matrix_product. Since reducing modulo the congruence
+    //! \f$t = t + p\f$ is a homomorphism from the natural numbers, the entries
+    //! of the product are computed using the usual addition and
+    //! multiplication, and are reduced once at the end, provided that this
+    //! cannot overflow.
+    void matrix_product(int64_t const* x,
+                        int64_t const* y,
+                        int64_t*       xy,
+                        size_t         n) const override {
+      int64_t const max = this->threshold() + _period - 1;
+      if (n != 0 && max <= std::numeric_limits<int32_t>::max()
+          && static_cast<uint64_t>(max) * static_cast<uint64_t>(max)
+                 <= static_cast<uint64_t>(
+                        std::numeric_limits<int64_t>::max() / n)) {
+        Semiring::matrix_product(
+            x,
+            y,
+            xy,
+            n,
+            0,
+            [](int64_t a, int64_t b) { return a + b; },
+            [](int64_t a, int64_t b) { return a * b; });
+        for (size_t i = 0; i < n * n; i++) {
+          xy[i] = thresholdperiod(xy[i]);
+        }
+      } else {
+        Semiring::matrix_product(
+            x,
+            y,
+            xy,
+            n,
+            0,
+            [this](int64_t a, int64_t b) { return thresholdperiod(a + b); },
+            [this](int64_t a, int64_t b) { return thresholdperiod(a * b); });
+      }
+    }
+
    private:
     int64_t thresholdperiod(int64_t x) const {
       int64_t threshold = this->threshold();
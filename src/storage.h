@@ -0,0 +1,501 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+// This file contains the storage policies which can be used by <RecVec>
+// instead of std::vector, and the alias template <GraphStorage> which selects
+// the policy used by the Cayley graphs of a <Semigroup> and the coset tables
+// of a Todd-Coxeter computation.
+//
+// A storage policy for values of type **T** must provide the same methods as
+// std::vector<T> which are used by <RecVec>, i.e. a default constructor, copy
+// constructor and assignment, **size**, **resize**, **reserve**, **clear**,
+// **operator[]**, and the types **iterator** and **const_iterator** with the
+// methods **begin**, **end**, **cbegin**, and **cend**. The function
+// <storage_bytes> must also be overloaded for the policy.
+
+#ifndef LIBSEMIGROUPS_SRC_STORAGE_H_
+#define LIBSEMIGROUPS_SRC_STORAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "libsemigroups-debug.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace libsemigroups {
+
+  //
+  // Storage policy for unsigned integers which stores every value in the
+  // same number of bits, where this number is the least required to store the
+  // largest value stored so far. The maximum value of **T**, which is used to
+  // indicate that a value is undefined, is stored as the value whose bits are
+  // all 1, and so it does not increase the number of bits used. When a value
+  // is stored which requires more bits than are currently used, every value
+  // is repacked, which happens at most once for every possible number of
+  // bits.
+  //
+  // For example, the Cayley graph of a semigroup with 10 ^ 8 elements
+  // requires 27 bits per entry rather than 64.
+  //
+  // The methods **operator[]** and the iterators return values and not
+  // references, and values can only be changed using **operator[]**, which
+  // returns a proxy object when it is not const.
+
+  template <typename T> class PackedStorage {
+    static_assert(std::is_unsigned<T>::value,
+                  "the template parameter T must be unsigned");
+
+   public:
+    // Proxy object returned by the non-const operator[].
+    class reference {
+     public:
+      reference(PackedStorage* storage, size_t pos)
+          : _storage(storage), _pos(pos) {}
+
+      operator T() const {
+        return _storage->get(_pos);
+      }
+
+      reference& operator=(T val) {
+        _storage->set(_pos, val);
+        return *this;
+      }
+
+      reference& operator=(reference const& that) {
+        return *this = static_cast<T>(that);
+      }
+
+     private:
+      PackedStorage* _storage;
+      size_t         _pos;
+    };
+
+    // Random access iterator which does not allow the values to be changed.
+    class const_iterator {
+     public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef T                               value_type;
+      typedef ptrdiff_t                       difference_type;
+      typedef T const*                        pointer;
+      typedef T                               reference;
+
+      const_iterator(PackedStorage const* storage, size_t pos)
+          : _storage(storage), _pos(pos) {}
+
+      T operator*() const {
+        return _storage->get(_pos);
+      }
+
+      T operator[](difference_type n) const {
+        return _storage->get(_pos + n);
+      }
+
+      const_iterator& operator++() {
+        ++_pos;
+        return *this;
+      }
+
+      const_iterator operator++(int) {
+        const_iterator tmp(*this);
+        ++_pos;
+        return tmp;
+      }
+
+      const_iterator& operator--() {
+        --_pos;
+        return *this;
+      }
+
+      const_iterator operator--(int) {
+        const_iterator tmp(*this);
+        --_pos;
+        return tmp;
+      }
+
+      const_iterator& operator+=(difference_type n) {
+        _pos += n;
+        return *this;
+      }
+
+      const_iterator& operator-=(difference_type n) {
+        _pos -= n;
+        return *this;
+      }
+
+      const_iterator operator+(difference_type n) const {
+        return const_iterator(_storage, _pos + n);
+      }
+
+      const_iterator operator-(difference_type n) const {
+        return const_iterator(_storage, _pos - n);
+      }
+
+      difference_type operator-(const_iterator const& that) const {
+        return static_cast<difference_type>(_pos)
+               - static_cast<difference_type>(that._pos);
+      }
+
+      bool operator==(const_iterator const& that) const {
+        return _pos == that._pos;
+      }
+
+      bool operator!=(const_iterator const& that) const {
+        return _pos != that._pos;
+      }
+
+      bool operator<(const_iterator const& that) const {
+        return _pos < that._pos;
+      }
+
+      bool operator<=(const_iterator const& that) const {
+        return _pos <= that._pos;
+      }
+
+      bool operator>(const_iterator const& that) const {
+        return _pos > that._pos;
+      }
+
+      bool operator>=(const_iterator const& that) const {
+        return _pos >= that._pos;
+      }
+
+     private:
+      PackedStorage const* _storage;
+      size_t               _pos;
+    };
+
+    typedef const_iterator iterator;
+
+    PackedStorage() : _data(), _mask(1), _size(0), _width(1) {}
+
+    size_t size() const {
+      return _size;
+    }
+
+    // The number of bits used to store every value.
+    size_t width() const {
+      return _width;
+    }
+
+    void resize(size_t n, T val = 0) {
+      if (n > _size) {
+        if (val != UNDEFINED && val >= _mask) {
+          widen(val);
+        }
+        size_t const old_size = _size;
+        _size                 = n;
+        _data.resize(nr_words(_size, _width), 0);
+        for (size_t i = old_size; i < _size; i++) {
+          set(i, val);
+        }
+      } else {
+        _size = n;
+        _data.resize(nr_words(_size, _width));
+      }
+    }
+
+    // Allocates enough memory for n values of the current width.
+    void reserve(size_t n) {
+      _data.reserve(nr_words(n, _width));
+    }
+
+    // The number of bytes allocated for the values.
+    size_t bytes() const {
+      return _data.capacity() * sizeof(uint64_t);
+    }
+
+    void clear() {
+      _data.clear();
+      _size = 0;
+    }
+
+    T operator[](size_t pos) const {
+      return get(pos);
+    }
+
+    reference operator[](size_t pos) {
+      return reference(this, pos);
+    }
+
+    const_iterator begin() const {
+      return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+      return const_iterator(this, _size);
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+   private:
+    static T const UNDEFINED;
+
+    static size_t nr_words(size_t size, size_t width) {
+      return (size * width + 63) / 64;
+    }
+
+    T get(size_t pos) const {
+      LIBSEMIGROUPS_ASSERT(pos < _size);
+      size_t const bit   = pos * _width;
+      size_t const word  = bit / 64;
+      size_t const shift = bit % 64;
+      uint64_t     val   = _data[word] >> shift;
+      if (shift + _width > 64) {
+        val |= _data[word + 1] << (64 - shift);
+      }
+      val &= _mask;
+      return (val == _mask ? UNDEFINED : static_cast<T>(val));
+    }
+
+    void set(size_t pos, T val) {
+      LIBSEMIGROUPS_ASSERT(pos < _size);
+      if (val != UNDEFINED && val >= _mask) {
+        widen(val);
+      }
+      uint64_t const bits  = (val == UNDEFINED ? _mask : val);
+      size_t const   bit   = pos * _width;
+      size_t const   word  = bit / 64;
+      size_t const   shift = bit % 64;
+      _data[word] = (_data[word] & ~(_mask << shift)) | (bits << shift);
+      if (shift + _width > 64) {
+        _data[word + 1] = (_data[word + 1] & ~(_mask >> (64 - shift)))
+                          | (bits >> (64 - shift));
+      }
+    }
+
+    // Repack the values so that val can be stored.
+    void widen(T val) {
+      size_t width = _width;
+      while (width < 64 && static_cast<uint64_t>(val) >= (1ULL << width) - 1) {
+        width++;
+      }
+      PackedStorage copy;
+      copy._width = width;
+      copy._mask  = (width == 64 ? ~0ULL : (1ULL << width) - 1);
+      copy._size  = _size;
+      copy._data.resize(nr_words(_size, width), 0);
+      for (size_t i = 0; i < _size; i++) {
+        copy.set(i, get(i));
+      }
+      *this = std::move(copy);
+    }
+
+    std::vector<uint64_t> _data;
+    uint64_t              _mask;
+    size_t                _size;
+    size_t                _width;
+  };
+
+  template <typename T>
+  T const PackedStorage<T>::UNDEFINED = std::numeric_limits<T>::max();
+
+#ifdef HAVE_SYS_MMAN_H
+
+  //
+  // Storage policy which stores the values in a memory-mapped temporary file,
+  // so that the operating system can write them to disk when there is not
+  // enough memory to hold them. The file is created in the directory given
+  // by the environment variable TMPDIR, or in /tmp if this is not set, and
+  // it is deleted as soon as it is created, so that it does not outlive the
+  // process.
+  //
+  // The capacity of the file is doubled whenever it is exceeded, and the file
+  // is mapped again without copying. If the file cannot be created, extended,
+  // or mapped, then std::bad_alloc is thrown, as it would be by std::vector.
+
+  template <typename T> class MmapStorage {
+   public:
+    typedef T*       iterator;
+    typedef T const* const_iterator;
+
+    MmapStorage() : _capacity(0), _data(nullptr), _fd(-1), _size(0) {}
+
+    MmapStorage(MmapStorage const& that) : MmapStorage() {
+      reserve(that._size);
+      std::copy(that.cbegin(), that.cend(), _data);
+      _size = that._size;
+    }
+
+    MmapStorage& operator=(MmapStorage const& that) {
+      if (this != &that) {
+        reserve(that._size);
+        std::copy(that.cbegin(), that.cend(), _data);
+        _size = that._size;
+      }
+      return *this;
+    }
+
+    ~MmapStorage() {
+      if (_data != nullptr) {
+        munmap(_data, _capacity * sizeof(T));
+      }
+      if (_fd != -1) {
+        close(_fd);
+      }
+    }
+
+    size_t size() const {
+      return _size;
+    }
+
+    void resize(size_t n, T val = T()) {
+      if (n > _size) {
+        reserve(n);
+        std::fill(_data + _size, _data + n, val);
+      }
+      _size = n;
+    }
+
+    void clear() {
+      _size = 0;
+    }
+
+    T const& operator[](size_t pos) const {
+      LIBSEMIGROUPS_ASSERT(pos < _size);
+      return _data[pos];
+    }
+
+    T& operator[](size_t pos) {
+      LIBSEMIGROUPS_ASSERT(pos < _size);
+      return _data[pos];
+    }
+
+    iterator begin() {
+      return _data;
+    }
+
+    iterator end() {
+      return _data + _size;
+    }
+
+    const_iterator cbegin() const {
+      return _data;
+    }
+
+    const_iterator cend() const {
+      return _data + _size;
+    }
+
+    // The number of bytes of the file which are mapped.
+    size_t bytes() const {
+      return _capacity * sizeof(T);
+    }
+
+    void reserve(size_t n) {
+      if (n <= _capacity) {
+        return;
+      }
+      size_t const page     = sysconf(_SC_PAGESIZE);
+      size_t       capacity = std::max(n, 2 * _capacity);
+      // Round up to a whole number of pages
+      capacity = ((capacity * sizeof(T) + page - 1) / page) * page / sizeof(T);
+
+      if (_fd == -1) {
+        char const* dir = getenv("TMPDIR");
+        std::string path((dir == nullptr ? "/tmp" : dir));
+        path += "/libsemigroups-XXXXXX";
+        std::vector<char> tmpl(path.begin(), path.end());
+        tmpl.push_back('\0');
+        _fd = mkstemp(tmpl.data());
+        if (_fd == -1) {
+          throw std::bad_alloc();
+        }
+        unlink(tmpl.data());
+      }
+      if (ftruncate(_fd, capacity * sizeof(T)) != 0) {
+        throw std::bad_alloc();
+      }
+      if (_data != nullptr) {
+        munmap(_data, _capacity * sizeof(T));
+      }
+      void* data = mmap(nullptr,
+                        capacity * sizeof(T),
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED,
+                        _fd,
+                        0);
+      if (data == MAP_FAILED) {
+        _data     = nullptr;
+        _capacity = 0;
+        _size     = 0;
+        throw std::bad_alloc();
+      }
+      _data     = static_cast<T*>(data);
+      _capacity = capacity;
+    }
+
+   private:
+    size_t _capacity;
+    T*     _data;
+    int    _fd;
+    size_t _size;
+  };
+
+#endif
+
+  // Returns the number of bytes allocated by the storage <vec>.
+  template <typename T> size_t storage_bytes(std::vector<T> const& vec) {
+    return vec.capacity() * sizeof(T);
+  }
+
+  inline size_t storage_bytes(std::vector<bool> const& vec) {
+    return vec.capacity() / 8;
+  }
+
+  template <typename T> size_t storage_bytes(PackedStorage<T> const& storage) {
+    return storage.bytes();
+  }
+
+#ifdef HAVE_SYS_MMAN_H
+  template <typename T> size_t storage_bytes(MmapStorage<T> const& storage) {
+    return storage.bytes();
+  }
+#endif
+
+  // The storage policy used by Semigroup::cayley_graph_t and by the coset
+  // tables of Congruence::TC, which is selected by the configure option
+  // --with-cayley-graph-storage.
+#if defined(LIBSEMIGROUPS_PACKED_CAYLEY_GRAPHS)
+  template <typename T> using GraphStorage = PackedStorage<T>;
+#elif defined(LIBSEMIGROUPS_MMAP_CAYLEY_GRAPHS) && defined(HAVE_SYS_MMAN_H)
+  template <typename T> using GraphStorage = MmapStorage<T>;
+#else
+  template <typename T> using GraphStorage = std::vector<T>;
+#endif
+}  // namespace libsemigroups
+
+#endif  // LIBSEMIGROUPS_SRC_STORAGE_H_
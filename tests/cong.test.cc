@@ -885,3 +885,30 @@ TEST_CASE("Congruence 28: test_less_than",
   Congruence cong("twosided", 2, {relation_t({0, 0}, {0})}, {});
   REQUIRE(!cong.test_less_than({0, 0}, {0}));
 }
+
+TEST_CASE("Congruence 29: metrics", "[quick][congruence][finite][29]") {
+  std::vector<Element*> gens = {new Transformation<u_int16_t>({1, 3, 4, 2, 3}),
+                                new Transformation<u_int16_t>({3, 2, 1, 3, 3})};
+  Semigroup S = Semigroup(gens);
+  S.set_report(CONG_REPORT);
+  really_delete_cont(gens);
+
+  Congruence cong("twosided", &S, {relation_t({0}, {1})});
+  cong.set_report(CONG_REPORT);
+  cong.force_tc();
+
+  Congruence::metrics_t metrics = cong.metrics();
+  REQUIRE(metrics.nr_relations == 0);
+  REQUIRE(metrics.nr_extra == 1);
+  REQUIRE(metrics.nr_cosets_killed == 0);
+
+  REQUIRE(cong.nr_classes() == 1);
+  metrics = cong.metrics();
+  REQUIRE(metrics.nr_relations == cong.relations().size());
+  REQUIRE(metrics.nr_relations == S.nrrules());
+  REQUIRE(metrics.time_init_relations >= 0);
+  REQUIRE(metrics.nr_cosets_defined > 0);
+  REQUIRE(metrics.nr_cosets_active == cong.nr_classes() + 1);
+  REQUIRE(metrics.nr_cosets_killed
+          == metrics.nr_cosets_defined - metrics.nr_cosets_active);
+}
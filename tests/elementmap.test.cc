@@ -0,0 +1,121 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "../src/elementmap.h"
+
+using namespace libsemigroups;
+
+template <typename T> static inline void really_delete_cont(T cont) {
+  for (Element* x : cont) {
+    x->really_delete();
+    delete x;
+  }
+}
+
+// Returns all the transformations of degree 4 in lexicographic order.
+static std::vector<Element*> all_transformations_4() {
+  std::vector<Element*> out;
+  for (u_int16_t i = 0; i < 256; i++) {
+    out.push_back(new Transformation<u_int16_t>(
+        {static_cast<u_int16_t>(i & 3),
+         static_cast<u_int16_t>((i >> 2) & 3),
+         static_cast<u_int16_t>((i >> 4) & 3),
+         static_cast<u_int16_t>((i >> 6) & 3)}));
+  }
+  return out;
+}
+
+TEST_CASE("ElementMap 01: find and insert",
+          "[quick][util][elementmap][01]") {
+  std::vector<Element*> elts = all_transformations_4();
+  ElementMap<size_t>    map(&elts);
+  REQUIRE(map.size() == 0);
+  REQUIRE(map.find(elts[0]) == ElementMap<size_t>::UNDEFINED);
+
+  for (size_t i = 0; i < elts.size(); i += 2) {
+    map.insert(elts[i], i);
+  }
+  REQUIRE(map.size() == 128);
+
+  std::vector<Element*> copies;
+  for (size_t i = 0; i < elts.size(); i++) {
+    copies.push_back(elts[i]->really_copy());
+    if (i % 2 == 0) {
+      REQUIRE(map.find(copies.back()) == i);
+    } else {
+      REQUIRE(map.find(copies.back()) == ElementMap<size_t>::UNDEFINED);
+    }
+  }
+  really_delete_cont(copies);
+  really_delete_cont(elts);
+}
+
+TEST_CASE("ElementMap 02: reserve and bytes",
+          "[quick][util][elementmap][02]") {
+  std::vector<Element*> elts = all_transformations_4();
+  ElementMap<size_t>    map(&elts, 0);
+  size_t                empty = map.bytes();
+
+  map.reserve(elts.size());
+  size_t reserved = map.bytes();
+  REQUIRE(reserved > empty);
+
+  for (size_t i = 0; i < elts.size(); i++) {
+    map.insert(elts[i], i);
+  }
+  REQUIRE(map.bytes() == reserved);
+  REQUIRE(map.size() == elts.size());
+  for (size_t i = 0; i < elts.size(); i++) {
+    REQUIRE(map.find(elts[i]) == i);
+  }
+  really_delete_cont(elts);
+}
+
+TEST_CASE("ElementMap 03: concurrent_find_or_insert",
+          "[quick][util][elementmap][multithread][03]") {
+  std::vector<Element*> elts = all_transformations_4();
+  ElementMap<size_t>    map(&elts);
+
+  std::vector<std::thread> threads;
+  for (size_t k = 0; k < 4; k++) {
+    threads.push_back(std::thread([&map, &elts, k]() {
+      for (size_t i = k; i < elts.size(); i += 4) {
+        map.concurrent_find_or_insert(elts[i], i);
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(map.size() == elts.size());
+
+  std::vector<Element*> copies;
+  for (size_t i = 0; i < elts.size(); i++) {
+    copies.push_back(elts[i]->really_copy());
+    REQUIRE(map.concurrent_find(copies.back()) == i);
+    REQUIRE(map.concurrent_find_or_insert(copies.back(), 1000) == i);
+  }
+  REQUIRE(map.size() == elts.size());
+  really_delete_cont(copies);
+  really_delete_cont(elts);
+}
@@ -16,6 +16,10 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <functional>
+#include <limits>
+#include <vector>
+
 #include "catch.hpp"
 
 #include "../src/elements.h"
@@ -342,6 +346,92 @@ TEST_CASE("PartialPerm 06: u_int32_t delete/copy",
   zz.really_delete();
 }
 
+TEST_CASE("FixedTransformation 01: methods",
+          "[quick][element][transformation][fixed][01]") {
+  Element* x = new FixedTransformation<3>({0, 1, 0});
+  Element* y = new FixedTransformation<3>({0, 1, 0});
+  REQUIRE(*x == *y);
+  x->redefine(y, y);
+  REQUIRE(*x == *y);
+  REQUIRE((*x < *y) == false);
+
+  Element* expected = new FixedTransformation<3>({0, 0, 0});
+  REQUIRE(*expected < *x);
+  delete expected;
+
+  REQUIRE(x->degree() == 3);
+  REQUIRE(x->complexity() == 3);
+  Element* id = x->identity();
+  expected    = new FixedTransformation<3>({0, 1, 2});
+  REQUIRE(*id == *expected);
+  delete expected;
+
+  x->redefine(id, y);
+  REQUIRE(*x == *y);
+
+  Element* z = new Transformation<u_int16_t>({0, 1, 0});
+  REQUIRE(x->hash_value() == z->hash_value());
+  z->really_delete();
+  delete z;
+
+  x->really_delete();
+  delete x;
+  delete y;
+  delete id;
+}
+
+TEST_CASE("FixedTransformation 02: delete/copy",
+          "[quick][element][transformation][fixed][02]") {
+  Element* x = new FixedTransformation<10, u_int16_t>(
+      {9, 7, 3, 5, 3, 4, 2, 7, 7, 1});
+  Element* y = x->really_copy();
+  delete x;
+
+  Element* expected = new FixedTransformation<10, u_int16_t>(
+      {9, 7, 3, 5, 3, 4, 2, 7, 7, 1});
+  REQUIRE(*y == *expected);
+
+  FixedTransformation<10, u_int16_t> yy
+      = *static_cast<FixedTransformation<10, u_int16_t>*>(y);
+  REQUIRE(yy == *y);
+  delete y;
+  REQUIRE(yy == *expected);
+
+  Element* z = new FixedTransformation<10, u_int16_t>(
+      {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+  z->copy(expected);
+  REQUIRE(*z == *expected);
+  delete z;
+  delete expected;
+}
+
+TEST_CASE("FixedPartialPerm 01: methods",
+          "[quick][element][pperm][fixed][01]") {
+  u_int8_t const U = FixedPartialPerm<5>::UNDEFINED;
+  Element*       x = new FixedPartialPerm<5>({4, 0, U, 1, U});
+  Element*       y = new FixedPartialPerm<5>({U, 3, 2, U, 0});
+
+  Element* xy = x->identity();
+  xy->redefine(x, y);
+  Element* expected = new FixedPartialPerm<5>({0, U, U, 3, U});
+  REQUIRE(*xy == *expected);
+  delete expected;
+
+  xy->redefine(y, x);
+  expected = new FixedPartialPerm<5>({U, 1, U, U, 4});
+  REQUIRE(*xy == *expected);
+  delete expected;
+
+  Element* z = new PartialPerm<u_int8_t>({4, 0, U, 1, U});
+  REQUIRE(x->hash_value() == z->hash_value());
+  z->really_delete();
+  delete z;
+
+  delete x;
+  delete y;
+  delete xy;
+}
+
 TEST_CASE("BooleanMat 01: methods", "[quick][element][booleanmat][01]") {
   Element* x = new BooleanMat({{1, 0, 1}, {0, 1, 0}, {0, 1, 0}});
   Element* y = new BooleanMat({{0, 0, 0}, {0, 0, 0}, {0, 0, 0}});
@@ -401,6 +491,96 @@ TEST_CASE("BooleanMat 03: delete/copy", "[quick][element][booleanmat][03]") {
   delete expected;
 }
 
+TEST_CASE("PackedBooleanMat 01: methods",
+          "[quick][element][booleanmat][packed][01]") {
+  Element* x = new PackedBooleanMat({{1, 0, 1}, {0, 1, 0}, {0, 1, 0}});
+  Element* y = new PackedBooleanMat({{0, 0, 0}, {0, 0, 0}, {0, 0, 0}});
+  Element* z = new PackedBooleanMat({{0, 0, 0}, {0, 0, 0}, {0, 0, 0}});
+  REQUIRE(*y == *z);
+  z->redefine(x, y);
+  REQUIRE(*y == *z);
+  z->redefine(y, x);
+  REQUIRE(*y == *z);
+  REQUIRE(!(*y < *z));
+  REQUIRE(x->degree() == 3);
+  REQUIRE(x->complexity() == 9);
+  Element* id = x->identity();
+  z->redefine(id, x);
+  REQUIRE(*z == *x);
+  z->redefine(x, id);
+  REQUIRE(*z == *x);
+  z->redefine(x, x);
+  Element* expected = new PackedBooleanMat({{1, 1, 1}, {0, 1, 0}, {0, 1, 0}});
+  REQUIRE(*z == *expected);
+  REQUIRE(z->hash_value() == expected->hash_value());
+
+  Element* w = z->really_copy();
+  REQUIRE(*w == *z);
+  REQUIRE(static_cast<PackedBooleanMat*>(w)->get(0, 2));
+  REQUIRE(!static_cast<PackedBooleanMat*>(w)->get(1, 2));
+
+  for (Element* e : {x, y, z, id, expected, w}) {
+    e->really_delete();
+    delete e;
+  }
+}
+
+TEST_CASE("PackedBooleanMat 02: products agree with BooleanMat",
+          "[quick][element][booleanmat][packed][02]") {
+  for (size_t n : {1, 5, 8, 63, 64, 65, 130}) {
+    std::vector<std::vector<bool>> xm(n, std::vector<bool>(n)),
+        ym(n, std::vector<bool>(n));
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < n; j++) {
+        xm[i][j] = ((i * 7 + j * 3) % 5 == 0);
+        ym[i][j] = ((i * 11 + j * 13) % 7 < 2);
+      }
+    }
+    BooleanMat       x(xm), y(ym), xy(xm);
+    PackedBooleanMat px(xm), py(ym), pxy(xm);
+    xy.redefine(&x, &y);
+    pxy.redefine(&px, &py);
+    PackedBooleanMat expected(xy);
+    REQUIRE(pxy == expected);
+    REQUIRE(pxy.degree() == n);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < n; j++) {
+        REQUIRE(pxy.get(i, j) == xy[i * n + j]);
+      }
+    }
+    for (Element* e : std::vector<Element*>({&x, &y, &xy, &px, &py, &pxy,
+                                             &expected})) {
+      e->really_delete();
+    }
+  }
+}
+
+TEST_CASE("PackedBooleanMat 03: transpose",
+          "[quick][element][booleanmat][packed][03]") {
+  for (size_t n : {3, 64, 100}) {
+    std::vector<std::vector<bool>> m(n, std::vector<bool>(n));
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < n; j++) {
+        m[i][j] = ((i * 5 + j) % 3 == 0);
+      }
+    }
+    PackedBooleanMat  x(m);
+    PackedBooleanMat* t = x.transpose();
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < n; j++) {
+        REQUIRE(t->get(j, i) == x.get(i, j));
+      }
+    }
+    PackedBooleanMat* tt = t->transpose();
+    REQUIRE(*tt == x);
+    x.really_delete();
+    for (Element* e : {t, tt}) {
+      e->really_delete();
+      delete e;
+    }
+  }
+}
+
 TEST_CASE("Bipartition 01: overridden methods",
           "[quick][element][bipart][01]") {
   Element* x = new Bipartition(
@@ -563,6 +743,99 @@ TEST_CASE("Bipartition 05: degree 0", "[quick][element][bipart][05]") {
   delete x;
 }
 
+static u_int32_t const UNDEF = std::numeric_limits<u_int32_t>::max();
+
+// Returns the blocks of a bipartition of degree n whose points lie in at most
+// k blocks, chosen using a simple linear congruential generator from seed.
+static std::vector<u_int32_t>
+bipartition_blocks(size_t n, size_t k, size_t seed) {
+  std::vector<u_int32_t> out(2 * n);
+  std::vector<u_int32_t> lookup(k, UNDEF);
+  u_int32_t              next = 0;
+  for (size_t i = 0; i < 2 * n; i++) {
+    seed             = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    u_int32_t& block = lookup[(seed >> 33) % k];
+    if (block == UNDEF) {
+      block = next++;
+    }
+    out[i] = block;
+  }
+  return out;
+}
+
+// Returns the blocks of the product of bipartitions with blocks x and y,
+// computed by fusing the points 0, ..., 3n - 1, where the points n, ..., 2n - 1
+// are the lower points of x and the upper points of y.
+static std::vector<u_int32_t> bipartition_product(std::vector<u_int32_t> x,
+                                                  std::vector<u_int32_t> y) {
+  size_t const           n = x.size() / 2;
+  std::vector<u_int32_t> part(3 * n);
+  for (size_t i = 0; i < 3 * n; i++) {
+    part[i] = i;
+  }
+  std::function<u_int32_t(u_int32_t)> find = [&part, &find](u_int32_t i) {
+    return (part[i] == i ? i : find(part[i]));
+  };
+  auto unite = [&part, &find](u_int32_t i, u_int32_t j) {
+    part[find(i)] = find(j);
+  };
+  for (size_t i = 0; i < 2 * n; i++) {
+    for (size_t j = 0; j < i; j++) {
+      if (x[i] == x[j]) {
+        unite(i, j);
+      }
+      if (y[i] == y[j]) {
+        unite(i + n, j + n);
+      }
+    }
+  }
+  std::vector<u_int32_t> out;
+  std::vector<u_int32_t> lookup(3 * n, UNDEF);
+  u_int32_t              next = 0;
+  for (size_t i = 0; i < 3 * n; i++) {
+    if (i < n || i >= 2 * n) {
+      if (lookup[find(i)] == UNDEF) {
+        lookup[find(i)] = next++;
+      }
+      out.push_back(lookup[find(i)]);
+    }
+  }
+  return out;
+}
+
+TEST_CASE("Bipartition 06: products", "[quick][element][bipart][06]") {
+  // The numbers of blocks are chosen so that every type of scratch space used
+  // by Bipartition::redefine is used.
+  for (size_t n : {1, 2, 5, 16, 63, 64, 127, 128, 300, 600}) {
+    for (size_t k : {size_t(1), size_t(3), n, 2 * n}) {
+      for (size_t seed = 0; seed < 3; seed++) {
+        Bipartition x(bipartition_blocks(n, k, seed));
+        Bipartition y(bipartition_blocks(n, k, seed + 10));
+        Bipartition xy(n);
+        xy.redefine(&x, &y, 0);
+        Bipartition expected(bipartition_product(
+            std::vector<u_int32_t>(x.begin(), x.end()),
+            std::vector<u_int32_t>(y.begin(), y.end())));
+        REQUIRE(xy == expected);
+        REQUIRE(xy.nr_blocks() == expected.nr_blocks());
+        REQUIRE(xy.rank() == expected.rank());
+        // The cached values are reset by redefine
+        xy.redefine(&y, &x, 0);
+        Bipartition yx(bipartition_product(
+            std::vector<u_int32_t>(y.begin(), y.end()),
+            std::vector<u_int32_t>(x.begin(), x.end())));
+        REQUIRE(xy == yx);
+        REQUIRE(xy.nr_left_blocks() == yx.nr_left_blocks());
+        REQUIRE(xy.rank() == yx.rank());
+        for (Element* e :
+             std::vector<Element*>({&x, &y, &xy, &expected, &yx})) {
+          e->really_delete();
+        }
+      }
+    }
+  }
+}
+
 TEST_CASE("ProjectiveMaxPlusMatrix 01: methods",
           "[quick][element][matrix][01]") {
   Semiring* sr = new MaxPlusSemiring();
@@ -1115,6 +1388,43 @@ TEST_CASE("MatrixOverSemiring 18: NaturalSemiring delete/copy",
   delete sr;
 }
 
+TEST_CASE("MatrixOverSemiring 19: tropical semirings and infinite entries",
+          "[quick][element][matrix][19]") {
+  int64_t const inf = Semiring::INFTY;
+  Semiring*     sr  = new TropicalMinPlusSemiring(33);
+  Element*      x
+      = new MatrixOverSemiring({{inf, 2, 5}, {1, inf, inf}, {3, 4, inf}}, sr);
+  Element* y = x->identity();
+  y->redefine(x, x);
+  Element* expected
+      = new MatrixOverSemiring({{3, 9, inf}, {inf, 3, 6}, {5, 5, 8}}, sr);
+  REQUIRE(*y == *expected);
+  x->really_delete();
+  delete x;
+  y->really_delete();
+  delete y;
+  expected->really_delete();
+  delete expected;
+  delete sr;
+
+  int64_t const minf = Semiring::MINUS_INFTY;
+  sr                 = new TropicalMaxPlusSemiring(33);
+  x                  = new MatrixOverSemiring(
+      {{minf, 2, 5}, {1, minf, minf}, {3, 4, minf}}, sr);
+  y = x->identity();
+  y->redefine(x, x);
+  expected = new MatrixOverSemiring(
+      {{8, 9, minf}, {minf, 3, 6}, {5, 5, 8}}, sr);
+  REQUIRE(*y == *expected);
+  x->really_delete();
+  delete x;
+  y->really_delete();
+  delete y;
+  expected->really_delete();
+  delete expected;
+  delete sr;
+}
+
 TEST_CASE("PBR 01: methods", "[quick][element][pbr][01]") {
   Element* x = new PBR(new std::vector<std::vector<u_int32_t>>(
       {{1}, {4}, {3}, {1}, {0, 2}, {0, 3, 4, 5}}));
@@ -1278,3 +1588,143 @@ TEST_CASE("PBR 05: delete/copy", "[quick][element][pbr][05]") {
   a->really_delete();
   delete a;
 }
+
+// Returns a PBR of degree n where every point is adjacent to about k other
+// points, chosen using a simple linear congruential generator from seed.
+static std::vector<std::vector<u_int32_t>>
+random_pbr(size_t n, size_t k, size_t seed) {
+  std::vector<std::vector<u_int32_t>> out(2 * n);
+  for (size_t i = 0; i < 2 * n; i++) {
+    for (size_t j = 0; j < 2 * n; j++) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      if ((seed >> 33) % (2 * n) < k) {
+        out[i].push_back(j);
+      }
+    }
+  }
+  return out;
+}
+
+// Returns the product of x and y, computed by a depth first search of the
+// middle points, where (m, false) is the middle point m reached by an edge of
+// x, and (m, true) is the middle point m reached by an edge of y.
+static std::vector<std::vector<u_int32_t>>
+pbr_product(std::vector<std::vector<u_int32_t>> const& x,
+            std::vector<std::vector<u_int32_t>> const& y) {
+  size_t const                        n = x.size() / 2;
+  std::vector<std::vector<u_int32_t>> out(2 * n);
+  for (size_t i = 0; i < 2 * n; i++) {
+    std::vector<bool>                        adj(2 * n, false);
+    std::vector<bool>                        seen(2 * n, false);
+    std::vector<std::pair<u_int32_t, bool>> stack;
+    auto visit = [&](u_int32_t j, bool via_y) {
+      // A point of the product is reached by an edge of x to 0, ..., n - 1
+      // or an edge of y to n, ..., 2n - 1.
+      if (via_y == (j >= n)) {
+        adj[j] = true;
+      } else {
+        u_int32_t const m = (via_y ? j : j - n);
+        if (!seen[m + via_y * n]) {
+          seen[m + via_y * n] = true;
+          stack.emplace_back(m, via_y);
+        }
+      }
+    };
+    for (u_int32_t j : (i < n ? x[i] : y[i])) {
+      visit(j, i >= n);
+    }
+    while (!stack.empty()) {
+      u_int32_t const m     = stack.back().first;
+      bool const      via_y = stack.back().second;
+      stack.pop_back();
+      for (u_int32_t j : (via_y ? x[m + n] : y[m])) {
+        visit(j, !via_y);
+      }
+    }
+    for (u_int32_t j = 0; j < 2 * n; j++) {
+      if (adj[j]) {
+        out[i].push_back(j);
+      }
+    }
+  }
+  return out;
+}
+
+TEST_CASE("PBR 06: products", "[quick][element][pbr][06]") {
+  for (size_t n : {1, 2, 3, 10, 31, 32, 33, 70}) {
+    for (size_t k : {0, 1, 2, 5}) {
+      for (size_t seed = 0; seed < 3; seed++) {
+        std::vector<std::vector<u_int32_t>> xadj = random_pbr(n, k, seed);
+        std::vector<std::vector<u_int32_t>> yadj = random_pbr(n, k, seed + 7);
+        PBR                                 x(xadj), y(yadj), xy(xadj);
+        PBR expected(pbr_product(xadj, yadj));
+        xy.redefine(&x, &y, 0);
+        REQUIRE(xy == expected);
+        for (Element* e : std::vector<Element*>({&x, &y, &xy, &expected})) {
+          e->really_delete();
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("PackedPBR 01: methods", "[quick][element][pbr][packed][01]") {
+  std::vector<std::vector<u_int32_t>> xadj
+      = {{1}, {4}, {3}, {1}, {0, 2}, {0, 3, 4, 5}};
+  Element* x = new PackedPBR(xadj);
+  Element* y = new PackedPBR(
+      std::vector<std::vector<u_int32_t>>({{1, 2}, {0, 1}, {0, 2, 3},
+                                           {0, 1, 2}, {3}, {0, 3, 4, 5}}));
+  REQUIRE(!(*x == *y));
+  y->redefine(x, x);
+  Element* z = new PackedPBR(std::vector<std::vector<u_int32_t>>(
+      {{1}, {4}, {0, 2}, {0, 2}, {0, 1, 2, 3, 4}, {1, 3, 4, 5}}));
+  REQUIRE(*y == *z);
+  REQUIRE(y->hash_value() == z->hash_value());
+  REQUIRE(static_cast<PackedPBR*>(z)->get(4, 3));
+  REQUIRE(!static_cast<PackedPBR*>(z)->get(5, 0));
+  z->really_delete();
+  delete z;
+
+  REQUIRE(x->degree() == 3);
+  REQUIRE(y->degree() == 3);
+  Element* id = x->identity();
+  y->redefine(id, x);
+  REQUIRE(*y == *x);
+  y->redefine(x, id);
+  REQUIRE(*y == *x);
+
+  Element* w = x->really_copy();
+  REQUIRE(*w == *x);
+  PBR       p(xadj);
+  PackedPBR q(p);
+  REQUIRE(q == *x);
+
+  for (Element* e : std::vector<Element*>({x, y, id, w})) {
+    e->really_delete();
+    delete e;
+  }
+  p.really_delete();
+  q.really_delete();
+}
+
+TEST_CASE("PackedPBR 02: products agree with PBR",
+          "[quick][element][pbr][packed][02]") {
+  for (size_t n : {1, 2, 3, 10, 31, 32, 33, 70}) {
+    for (size_t k : {0, 1, 2, 5}) {
+      std::vector<std::vector<u_int32_t>> xadj = random_pbr(n, k, 1);
+      std::vector<std::vector<u_int32_t>> yadj = random_pbr(n, k, 2);
+      PBR                                 x(xadj), y(yadj), xy(xadj);
+      PackedPBR                           px(xadj), py(yadj), pxy(xadj);
+      xy.redefine(&x, &y, 0);
+      pxy.redefine(&px, &py);
+      PackedPBR expected(xy);
+      REQUIRE(pxy == expected);
+      REQUIRE(pxy.degree() == n);
+      for (Element* e : std::vector<Element*>(
+               {&x, &y, &xy, &px, &py, &pxy, &expected})) {
+        e->really_delete();
+      }
+    }
+  }
+}
@@ -0,0 +1,102 @@
+//
+// libsemigroups - C++ library for semigroups and monoids
+// Copyright (C) 2017 James D. Mitchell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "../src/kernels.h"
+
+using namespace libsemigroups;
+
+// Returns a random transformation of degree n
+static std::vector<u_int8_t> random_transf(std::mt19937& mt, size_t n) {
+  std::uniform_int_distribution<size_t> dist(0, n - 1);
+  std::vector<u_int8_t>                 out(n);
+  for (auto& x : out) {
+    x = static_cast<u_int8_t>(dist(mt));
+  }
+  return out;
+}
+
+// Returns a random partial perm of degree n
+static std::vector<u_int8_t> random_pperm(std::mt19937& mt, size_t n) {
+  std::vector<u_int8_t> out(n);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = static_cast<u_int8_t>(i);
+  }
+  std::shuffle(out.begin(), out.end(), mt);
+  std::uniform_int_distribution<size_t> dist(0, 3);
+  for (auto& x : out) {
+    if (dist(mt) == 0) {
+      x = 255;
+    }
+  }
+  return out;
+}
+
+TEST_CASE("kernels 01: compose", "[quick][kernels][01]") {
+  std::mt19937 mt(17);
+  for (size_t n = 1; n < 100; n++) {
+    for (size_t k = 0; k < 10; k++) {
+      std::vector<u_int8_t> x = random_transf(mt, n);
+      std::vector<u_int8_t> y = random_transf(mt, n);
+      std::vector<u_int8_t> expected(n), result(n);
+      compose<u_int8_t>(x.data(), y.data(), expected.data(), n);
+      compose(x.data(), y.data(), result.data(), n);
+      REQUIRE(result == expected);
+      for (size_t i = 0; i < n; i++) {
+        REQUIRE(expected[i] == y[x[i]]);
+      }
+    }
+  }
+}
+
+TEST_CASE("kernels 02: compose_partial", "[quick][kernels][02]") {
+  std::mt19937 mt(17);
+  for (size_t n = 1; n < 100; n++) {
+    for (size_t k = 0; k < 10; k++) {
+      std::vector<u_int8_t> x = random_pperm(mt, n);
+      std::vector<u_int8_t> y = random_pperm(mt, n);
+      std::vector<u_int8_t> expected(n), result(n);
+      compose_partial<u_int8_t>(x.data(), y.data(), expected.data(), n);
+      compose_partial(x.data(), y.data(), result.data(), n);
+      REQUIRE(result == expected);
+      for (size_t i = 0; i < n; i++) {
+        REQUIRE(expected[i] == (x[i] == 255 ? 255 : y[x[i]]));
+      }
+    }
+  }
+}
+
+TEST_CASE("kernels 03: hash_images", "[quick][kernels][03]") {
+  std::mt19937 mt(17);
+  for (size_t n = 1; n < 100; n++) {
+    std::vector<u_int8_t> x = random_transf(mt, n);
+    size_t                seed = 0;
+    for (auto val : x) {
+      seed *= n;
+      seed += val;
+    }
+    REQUIRE(hash_images(x.data(), n) == seed);
+    std::vector<u_int32_t> y(x.begin(), x.end());
+    REQUIRE(hash_images(y.data(), n) == seed);
+  }
+}
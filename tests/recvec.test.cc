@@ -16,6 +16,11 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
 #include "catch.hpp"
 
 #include "../src/recvec.h"
@@ -298,3 +303,143 @@ TEST_CASE("RecVec 16: method row_cbegin and row_cend",
     }
   }
 }
+
+// Performs the same operations on a RecVec<size_t, TStorage> and on a
+// std::vector of std::vectors, and checks that the results agree.
+template <class TStorage> static void test_storage() {
+  typedef RecVec<size_t, TStorage> recvec_t;
+  size_t const                     undef = std::numeric_limits<size_t>::max();
+  std::mt19937                     mt(17);
+  std::uniform_int_distribution<size_t> dist(0, 1 << 20);
+
+  recvec_t                         rv(3, 5, undef);
+  std::vector<std::vector<size_t>> expected(5, std::vector<size_t>(3, undef));
+  auto                             check_it = [&rv, &expected]() {
+    if (rv.nr_rows() != expected.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < rv.nr_rows(); i++) {
+      if (rv.nr_cols() != expected[i].size()) {
+        return false;
+      }
+      for (size_t j = 0; j < rv.nr_cols(); j++) {
+        if (rv.get(i, j) != expected[i][j]) {
+          return false;
+        }
+      }
+      if (!std::equal(rv.row_cbegin(i), rv.row_cend(i), expected[i].begin())) {
+        return false;
+      }
+    }
+    return true;
+  };
+  REQUIRE(check_it());
+
+  for (size_t k = 0; k < 10; k++) {
+    for (size_t i = 0; i < rv.nr_rows(); i++) {
+      for (size_t j = 0; j < rv.nr_cols(); j += 2) {
+        size_t val = (dist(mt) >> (2 * k));
+        rv.set(i, j, val);
+        expected[i][j] = val;
+      }
+    }
+    REQUIRE(check_it());
+    rv.add_rows(k + 1);
+    expected.resize(expected.size() + k + 1,
+                    std::vector<size_t>(rv.nr_cols(), undef));
+    REQUIRE(check_it());
+    rv.add_cols(k);
+    for (auto& row : expected) {
+      row.resize(row.size() + k, undef);
+    }
+    REQUIRE(check_it());
+  }
+
+  REQUIRE(rv.count(0, undef)
+          == static_cast<size_t>(
+                 std::count(expected[0].begin(), expected[0].end(), undef)));
+
+  recvec_t copy(rv);
+  REQUIRE(copy.nr_rows() == rv.nr_rows());
+  for (size_t i = 0; i < rv.nr_rows(); i++) {
+    REQUIRE(std::equal(rv.row_cbegin(i), rv.row_cend(i), copy.row_cbegin(i)));
+  }
+
+  recvec_t more(rv, 2);
+  for (auto& row : expected) {
+    row.resize(row.size() + 2, undef);
+  }
+  std::swap(rv, more);
+  REQUIRE(check_it());
+
+  RecVec<size_t> other(rv.nr_cols(), 3, 666);
+  rv.append(other);
+  expected.resize(expected.size() + 3,
+                  std::vector<size_t>(rv.nr_cols(), 666));
+  REQUIRE(check_it());
+
+  size_t const nr_rows = rv.nr_rows();
+  rv.reserve(nr_rows + 10);
+  REQUIRE(rv.nr_rows() == nr_rows);
+  REQUIRE(check_it());
+  rv.add_rows(10);
+  expected.resize(expected.size() + 10,
+                  std::vector<size_t>(rv.nr_cols(), undef));
+  REQUIRE(check_it());
+
+  rv.clear();
+  REQUIRE(rv.size() == 0);
+  REQUIRE(rv.nr_rows() == 0);
+}
+
+TEST_CASE("RecVec 17: std::vector storage", "[quick][util][recvec][17]") {
+  test_storage<std::vector<size_t>>();
+}
+
+TEST_CASE("RecVec 18: packed storage", "[quick][util][recvec][18]") {
+  test_storage<PackedStorage<size_t>>();
+
+  PackedStorage<u_int32_t> ps;
+  ps.resize(100, std::numeric_limits<u_int32_t>::max());
+  REQUIRE(ps.width() == 1);
+  REQUIRE(std::all_of(ps.cbegin(), ps.cend(), [](u_int32_t val) {
+    return val == std::numeric_limits<u_int32_t>::max();
+  }));
+  ps[10] = 0;
+  REQUIRE(ps.width() == 1);
+  ps[11] = 1;
+  REQUIRE(ps.width() == 2);
+  ps[12] = 1000;
+  REQUIRE(ps.width() == 10);
+  ps[13] = std::numeric_limits<u_int32_t>::max() - 1;
+  REQUIRE(ps.width() == 32);
+  REQUIRE(ps[10] == 0);
+  REQUIRE(ps[11] == 1);
+  REQUIRE(ps[12] == 1000);
+  REQUIRE(ps[13] == std::numeric_limits<u_int32_t>::max() - 1);
+  REQUIRE(ps[14] == std::numeric_limits<u_int32_t>::max());
+  REQUIRE(ps.size() == 100);
+
+  RecVec<bool, PackedStorage<bool>> flags(3, 4, false);
+  flags.set(2, 1, true);
+  REQUIRE(flags.get(2, 1));
+  REQUIRE(!flags.get(2, 0));
+  REQUIRE(flags.count(2, true) == 1);
+}
+
+#ifdef HAVE_SYS_MMAN_H
+TEST_CASE("RecVec 19: mmap storage", "[quick][util][recvec][19]") {
+  test_storage<MmapStorage<size_t>>();
+
+  // Large enough to require the file to be extended and mapped again
+  RecVec<u_int32_t, MmapStorage<u_int32_t>> rv(4, 0, 7);
+  for (size_t i = 0; i < 100000; i++) {
+    rv.add_rows(1);
+    rv.set(i, i % 4, i);
+  }
+  for (size_t i = 0; i < 100000; i++) {
+    REQUIRE(rv.get(i, i % 4) == i);
+    REQUIRE(rv.get(i, (i + 1) % 4) == 7);
+  }
+}
+#endif
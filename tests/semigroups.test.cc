@@ -16,6 +16,13 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <stdio.h>
+
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <string>
+
 #include "../src/semigroups.h"
 #include "catch.hpp"
 
@@ -2651,3 +2658,827 @@ TEST_CASE("Semigroup 65: my favourite example without reserve",
   S.set_report(SEMIGROUPS_REPORT);
   REQUIRE(S.size() == 597369);
 }
+
+TEST_CASE("Semigroup 66: enumerate with more than 1 thread",
+          "[quick][semigroup][finite][multithread][66]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S = Semigroup(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_max_threads(1);
+
+  Semigroup T = Semigroup(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  T.set_max_threads(4);
+  really_delete_cont(gens);
+
+  T.enumerate(10000);
+  REQUIRE(T.current_size() >= 10000);
+  REQUIRE(T.current_size() < 46656);
+
+  REQUIRE(S.size() == 46656);
+  REQUIRE(T.size() == 46656);
+  REQUIRE(S.nrrules() == T.nrrules());
+
+  Semigroup::cayley_graph_t const* Sright = S.right_cayley_graph();
+  Semigroup::cayley_graph_t const* Tright = T.right_cayley_graph();
+  Semigroup::cayley_graph_t const* Sleft  = S.left_cayley_graph();
+  Semigroup::cayley_graph_t const* Tleft  = T.left_cayley_graph();
+  for (size_t i = 0; i < S.size(); i++) {
+    REQUIRE(*S.at(i) == *T.at(i));
+    REQUIRE(S.length_const(i) == T.length_const(i));
+    for (size_t j = 0; j < S.nrgens(); j++) {
+      REQUIRE(Sright->get(i, j) == Tright->get(i, j));
+      REQUIRE(Sleft->get(i, j) == Tleft->get(i, j));
+    }
+  }
+}
+
+TEST_CASE("Semigroup 67: transformations of fixed degree",
+          "[quick][semigroup][finite][67]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int8_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int8_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int8_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S = Semigroup(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+
+  gens = {new FixedTransformation<6>({1, 2, 3, 4, 5, 0}),
+          new FixedTransformation<6>({1, 0, 2, 3, 4, 5}),
+          new FixedTransformation<6>({0, 0, 2, 3, 4, 5})};
+  Semigroup T = Semigroup(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+
+  REQUIRE(T.size() == 46656);
+  REQUIRE(T.nrrules() == S.nrrules());
+  REQUIRE(T.nridempotents() == S.nridempotents());
+
+  Element* x = new FixedTransformation<6>({5, 4, 3, 2, 1, 0});
+  Element* y = new Transformation<u_int8_t>({5, 4, 3, 2, 1, 0});
+  REQUIRE(T.position(x) == S.position(y));
+  delete x;
+  y->really_delete();
+  delete y;
+}
+
+TEST_CASE("Semigroup 68: FroidurePin of transformations",
+          "[quick][semigroup][finite][68]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S = Semigroup(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+
+  FroidurePin<Transformation<u_int16_t>> T(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+
+  T.enumerate(10000);
+  REQUIRE(T.current_size() >= 10000);
+  REQUIRE(T.current_size() < 46656);
+
+  // The virtual enumerate is called through a reference to a Semigroup
+  Semigroup& U = T;
+  REQUIRE(U.size() == 46656);
+  REQUIRE(S.size() == 46656);
+  REQUIRE(S.nrrules() == T.nrrules());
+
+  Semigroup::cayley_graph_t const* Sright = S.right_cayley_graph();
+  Semigroup::cayley_graph_t const* Tright = T.right_cayley_graph();
+  Semigroup::cayley_graph_t const* Sleft  = S.left_cayley_graph();
+  Semigroup::cayley_graph_t const* Tleft  = T.left_cayley_graph();
+  for (size_t i = 0; i < S.size(); i++) {
+    REQUIRE(*S.at(i) == *T.at(i));
+    for (size_t j = 0; j < S.nrgens(); j++) {
+      REQUIRE(Sright->get(i, j) == Tright->get(i, j));
+      REQUIRE(Sleft->get(i, j) == Tleft->get(i, j));
+    }
+  }
+
+  FroidurePin<Transformation<u_int16_t>> V(T);
+  REQUIRE(V.size() == 46656);
+}
+
+TEST_CASE("Semigroup 69: FroidurePin of other types of elements",
+          "[quick][semigroup][finite][69]") {
+  std::vector<Element*> gens
+      = {new Bipartition(
+             {0, 1, 2, 1, 0, 2, 1, 0, 2, 2, 0, 0, 2, 0, 3, 4, 4, 1, 3, 0}),
+         new Bipartition(
+             {0, 1, 1, 1, 1, 2, 3, 2, 4, 5, 5, 2, 4, 2, 1, 1, 1, 2, 3, 2}),
+         new Bipartition(
+             {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0})};
+  Semigroup                S = Semigroup(gens);
+  FroidurePin<Bipartition> T(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  T.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+  REQUIRE(T.size() == S.size());
+  REQUIRE(T.nrrules() == S.nrrules());
+
+  gens = {new BooleanMat({{0, 1, 0, 0}, {1, 0, 0, 0}, {0, 0, 1, 0},
+                          {0, 0, 0, 1}}),
+          new BooleanMat({{0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1},
+                          {1, 0, 0, 0}}),
+          new BooleanMat({{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0},
+                          {1, 0, 0, 1}}),
+          new BooleanMat({{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0},
+                          {0, 0, 0, 0}})};
+  Semigroup               U = Semigroup(gens);
+  FroidurePin<BooleanMat> X(gens);
+  U.set_report(SEMIGROUPS_REPORT);
+  X.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+  REQUIRE(X.size() == U.size());
+  REQUIRE(X.nrrules() == U.nrrules());
+
+  gens = {new PBR(new std::vector<std::vector<u_int32_t>>(
+              {{1}, {4}, {3}, {1}, {0, 2}, {0, 3, 4, 5}})),
+          new PBR(new std::vector<std::vector<u_int32_t>>(
+              {{1, 2}, {0, 1}, {0, 2, 3}, {0, 1, 2}, {3}, {0, 3, 4, 5}}))};
+  Semigroup        V = Semigroup(gens);
+  FroidurePin<PBR> W(gens);
+  V.set_report(SEMIGROUPS_REPORT);
+  W.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+  REQUIRE(W.size() == V.size());
+  REQUIRE(W.nrrules() == V.nrrules());
+}
+
+TEST_CASE("Semigroup 70: packed boolean matrices",
+          "[quick][semigroup][finite][70]") {
+  std::vector<std::vector<std::vector<bool>>> mats
+      = {{{0, 1, 0, 0}, {1, 0, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}},
+         {{0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}, {1, 0, 0, 0}},
+         {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {1, 0, 0, 1}},
+         {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 0}}};
+  std::vector<Element*> gens;
+  std::vector<Element*> packed_gens;
+  for (auto const& mat : mats) {
+    gens.push_back(new BooleanMat(mat));
+    packed_gens.push_back(new PackedBooleanMat(mat));
+  }
+  Semigroup                     S = Semigroup(gens);
+  FroidurePin<PackedBooleanMat> T(packed_gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  T.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+  really_delete_cont(packed_gens);
+
+  REQUIRE(T.size() == S.size());
+  REQUIRE(T.nrrules() == S.nrrules());
+  REQUIRE(T.nridempotents() == S.nridempotents());
+  for (size_t i = 0; i < S.size(); i++) {
+    PackedBooleanMat x(*static_cast<BooleanMat const*>(S.at(i)));
+    REQUIRE(*T.at(i) == x);
+    x.really_delete();
+  }
+}
+
+TEST_CASE("Semigroup 71: packed PBRs", "[quick][semigroup][finite][71]") {
+  std::vector<std::vector<std::vector<u_int32_t>>> adjs
+      = {{{1}, {4}, {3}, {1}, {0, 2}, {0, 3, 4, 5}},
+         {{1, 2}, {0, 1}, {0, 2, 3}, {0, 1, 2}, {3}, {0, 3, 4, 5}}};
+  std::vector<Element*> gens;
+  std::vector<Element*> packed_gens;
+  for (auto const& adj : adjs) {
+    gens.push_back(new PBR(adj));
+    packed_gens.push_back(new PackedPBR(adj));
+  }
+  Semigroup              S = Semigroup(gens);
+  FroidurePin<PackedPBR> T(packed_gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  T.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+  really_delete_cont(packed_gens);
+
+  REQUIRE(T.size() == S.size());
+  REQUIRE(T.nrrules() == S.nrrules());
+  REQUIRE(T.nridempotents() == S.nridempotents());
+  for (size_t i = 0; i < S.size(); i++) {
+    PackedPBR x(*static_cast<PBR const*>(S.at(i)));
+    REQUIRE(*T.at(i) == x);
+    x.really_delete();
+  }
+}
+
+// Checks that S and T are equal, element by element, and have the same
+// Cayley graphs and minimal factorisations.
+static void test_same_semigroup(Semigroup& S, Semigroup& T) {
+  REQUIRE(S.size() == T.size());
+  REQUIRE(S.nrrules() == T.nrrules());
+  REQUIRE(S.nridempotents() == T.nridempotents());
+  for (size_t i = 0; i < S.size(); i++) {
+    REQUIRE(*S.at(i) == *T.at(i));
+    REQUIRE(S.length_const(i) == T.length_const(i));
+    word_t* u = S.minimal_factorisation(i);
+    word_t* v = T.minimal_factorisation(i);
+    REQUIRE(*u == *v);
+    delete u;
+    delete v;
+    for (size_t j = 0; j < S.nrgens(); j++) {
+      REQUIRE(S.right_cayley_graph()->get(i, j)
+              == T.right_cayley_graph()->get(i, j));
+      REQUIRE(S.left_cayley_graph()->get(i, j)
+              == T.left_cayley_graph()->get(i, j));
+    }
+  }
+}
+
+TEST_CASE("Semigroup 72: save and load",
+          "[quick][semigroup][finite][72]") {
+  std::string const     filename = "libsemigroups-semigroup-72.tmp";
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_batch_size(1000);
+
+  // Save before and after enumerating, and part way through.
+  for (size_t limit : {0, 1000, 20000, 50000}) {
+    S.enumerate(limit);
+    REQUIRE(S.save(filename));
+
+    FroidurePin<Transformation<u_int16_t>> T(gens);
+    T.set_report(SEMIGROUPS_REPORT);
+    REQUIRE(T.load(filename));
+    REQUIRE(T.current_size() == S.current_size());
+    REQUIRE(T.current_nrrules() == S.current_nrrules());
+    REQUIRE(T.current_max_word_length() == S.current_max_word_length());
+    REQUIRE(T.is_begun() == S.is_begun());
+    REQUIRE(T.is_done() == S.is_done());
+
+    Semigroup U(gens);
+    U.set_report(SEMIGROUPS_REPORT);
+    test_same_semigroup(T, U);
+    REQUIRE(T.is_done());
+  }
+  REQUIRE(S.size() == 46656);
+  REQUIRE(S.is_done());
+  std::remove(filename.c_str());
+  really_delete_cont(gens);
+}
+
+TEST_CASE("Semigroup 73: save and load, failures",
+          "[quick][semigroup][finite][73]") {
+  std::string const     filename = "libsemigroups-semigroup-73.tmp";
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 0}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4})};
+  std::vector<Element*> other
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 0}),
+         new Transformation<u_int16_t>({0, 1, 2, 3, 3})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_batch_size(100);
+  S.enumerate(500);
+  REQUIRE(S.save(filename));
+
+  // The file does not exist
+  Semigroup T(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  REQUIRE(!T.load(filename + "-does-not-exist"));
+
+  // Different generators
+  Semigroup U(other);
+  U.set_report(SEMIGROUPS_REPORT);
+  REQUIRE(!U.load(filename));
+  REQUIRE(U.current_size() == 3);
+  Semigroup X(other);
+  X.set_report(SEMIGROUPS_REPORT);
+  test_same_semigroup(U, X);
+
+  // Fewer generators
+  std::vector<Element*> fewer(gens.begin(), gens.begin() + 2);
+  Semigroup             V(fewer);
+  V.set_report(SEMIGROUPS_REPORT);
+  REQUIRE(!V.load(filename));
+
+  // Already enumerated
+  T.enumerate(100);
+  REQUIRE(!T.load(filename));
+
+  // Truncated
+  Semigroup W(gens);
+  W.set_report(SEMIGROUPS_REPORT);
+  {
+    std::ifstream     in(filename, std::ios::binary);
+    std::string const contents((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() - 8);
+  }
+  REQUIRE(!W.load(filename));
+  REQUIRE(W.current_size() == 3);
+  REQUIRE(W.size() == 3125);
+
+  // Indices out of range: the header consists of 14 fields followed by the
+  // offsets of the sections, and the suffixes and right Cayley graph are
+  // sections 8 and 11.
+  auto corrupt = [&filename](size_t section, size_t pos, uint64_t val) {
+    std::fstream file(filename,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    uint64_t     offset;
+    file.seekg((14 + section) * sizeof(uint64_t));
+    file.read(reinterpret_cast<char*>(&offset), sizeof(uint64_t));
+    file.seekp(offset + pos * sizeof(uint64_t));
+    file.write(reinterpret_cast<char const*>(&val), sizeof(uint64_t));
+  };
+  for (size_t section : {8, 11}) {
+    REQUIRE(S.save(filename));
+    corrupt(section, 100, 1000000);
+    Semigroup Y(gens);
+    Y.set_report(SEMIGROUPS_REPORT);
+    REQUIRE(!Y.load(filename));
+    REQUIRE(Y.current_size() == 3);
+  }
+
+  std::remove(filename.c_str());
+  really_delete_cont(gens);
+  really_delete_cont(other);
+}
+
+TEST_CASE("Semigroup 74: idempotents found incrementally",
+          "[quick][semigroup][finite][multithread][74]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_batch_size(1000);
+  S.set_max_threads(1);
+
+  Semigroup T(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  T.set_batch_size(1000);
+  T.set_max_threads(4);
+  really_delete_cont(gens);
+
+  // Check the idempotents directly
+  std::vector<bool> expected;
+  size_t            nr = 0;
+  S.enumerate(1000);
+  REQUIRE(!S.is_done());
+  REQUIRE(S.current_nridempotents() <= S.current_size());
+  for (size_t i = 0; i < S.current_size(); i++) {
+    Element* x = S.at(i)->really_copy();
+    x->redefine(S.at(i), S.at(i));
+    expected.push_back(*x == *S.at(i));
+    nr += expected.back();
+    x->really_delete();
+    delete x;
+    REQUIRE(S.is_idempotent(i) == expected[i]);
+  }
+  REQUIRE(S.current_nridempotents() == nr);
+  REQUIRE(!S.is_done());
+
+  // is_idempotent does not enumerate T fully
+  REQUIRE(T.is_idempotent(5000) == S.is_idempotent(5000));
+  REQUIRE(!T.is_done());
+  REQUIRE(T.current_nridempotents() == S.current_nridempotents());
+
+  REQUIRE(S.nridempotents() == 1057);
+  REQUIRE(T.nridempotents() == 1057);
+  REQUIRE(std::equal(S.idempotents_cbegin(),
+                     S.idempotents_cend(),
+                     T.idempotents_cbegin()));
+  size_t count = 0;
+  for (auto it = S.idempotents_cbegin(); it < S.idempotents_cend(); ++it) {
+    REQUIRE(S.is_idempotent(*it));
+    REQUIRE(T.is_idempotent(*it));
+    if (it != S.idempotents_cbegin()) {
+      REQUIRE(*(it - 1) < *it);
+    }
+    count++;
+  }
+  REQUIRE(count == 1057);
+  for (size_t i = 0; i < S.size(); i++) {
+    REQUIRE(S.is_idempotent(i) == T.is_idempotent(i));
+  }
+}
+
+TEST_CASE("Semigroup 75: sorted elements, multiple threads",
+          "[quick][semigroup][finite][multithread][75]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_max_threads(3);
+  really_delete_cont(gens);
+
+  REQUIRE(S.size() == 46656);
+  for (size_t i = 0; i < S.size(); i++) {
+    REQUIRE(S.sorted_position(S.at(i)) == S.position_to_sorted_position(i));
+    REQUIRE(S.sorted_at(S.position_to_sorted_position(i)) == S.at(i));
+    if (i > 0) {
+      REQUIRE(*S.sorted_at(i - 1) < *S.sorted_at(i));
+    }
+  }
+  REQUIRE(S.sorted_at(46656) == nullptr);
+  REQUIRE(S.position_to_sorted_position(46656) == Semigroup::UNDEFINED);
+
+  std::vector<std::pair<Element*, Semigroup::element_index_t>>* sorted
+      = S.sorted_elements();
+  REQUIRE(sorted->size() == S.size());
+  for (size_t i = 0; i < sorted->size(); i++) {
+    REQUIRE((*sorted)[i].first == S.sorted_at(i));
+    REQUIRE((*sorted)[i].first == S.at((*sorted)[i].second));
+  }
+
+  // The elements are sorted again after adding generators
+  gens = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+          new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0})};
+  Semigroup T(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  T.set_max_threads(3);
+  really_delete_cont(gens);
+  REQUIRE(T.size() == 720);
+  REQUIRE(T.position_to_sorted_position(719) < 720);
+
+  gens = {new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  T.add_generators(gens);
+  really_delete_cont(gens);
+  REQUIRE(T.size() == 46656);
+  for (size_t i = 0; i < T.size(); i++) {
+    REQUIRE(*T.sorted_at(i) == *S.sorted_at(i));
+    REQUIRE(T.sorted_position(S.sorted_at(i)) == i);
+  }
+}
+
+TEST_CASE("Semigroup 76: word_to_pos and fast_product for many arguments",
+          "[quick][semigroup][finite][multithread][76]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+  REQUIRE(S.size() == 46656);
+
+  std::vector<word_t> words;
+  for (size_t i = 0; i < S.size(); i++) {
+    word_t* v = S.minimal_factorisation(i);
+    words.push_back(*v);
+    delete v;
+    word_t w;
+    for (size_t j = 0; j < i % 20 + 1; j++) {
+      w.push_back((i * j + i / 7) % S.nrgens());
+    }
+    words.push_back(w);
+  }
+  std::vector<std::pair<Semigroup::element_index_t,
+                        Semigroup::element_index_t>>
+      pairs;
+  for (size_t i = 0; i < S.size(); i++) {
+    pairs.push_back(std::make_pair(i, (i * 7919) % S.size()));
+  }
+
+  for (size_t nr_threads : {1, 3}) {
+    S.set_max_threads(nr_threads);
+    std::vector<Semigroup::element_index_t> result;
+    S.word_to_pos(words, result);
+    REQUIRE(result.size() == words.size());
+    for (size_t i = 0; i < words.size(); i++) {
+      REQUIRE(result[i] == S.word_to_pos(words[i]));
+    }
+    REQUIRE(result[0] == 0);
+    REQUIRE(result[2 * 1000] == 1000);
+
+    S.fast_product(pairs, result);
+    REQUIRE(result.size() == pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+      REQUIRE(result[i] == S.fast_product(pairs[i].first, pairs[i].second));
+    }
+  }
+
+  std::vector<Semigroup::element_index_t> result = {1, 2, 3};
+  S.word_to_pos(std::vector<word_t>(), result);
+  REQUIRE(result.empty());
+}
+
+TEST_CASE("Semigroup 77: position and at while enumerating",
+          "[quick][semigroup][finite][multithread][77]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup T(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  REQUIRE(T.size() == 46656);
+
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_batch_size(128);
+  really_delete_cont(gens);
+
+  std::atomic<size_t> nr_wrong(0);
+  std::vector<std::thread> readers;
+  for (size_t k = 0; k < 3; k++) {
+    readers.push_back(std::thread([&S, &T, &nr_wrong, k]() {
+      for (size_t i = k; i < 46656; i += 97) {
+        size_t j = 46655 - i;
+        if (S.position(T.at(j)) != j || !(*S.at(i) == *T.at(i))
+            || S.current_position(T.at(i)) != i) {
+          nr_wrong++;
+        }
+      }
+      if (S.at(46656) != nullptr) {
+        nr_wrong++;
+      }
+    }));
+  }
+  std::thread writer([&S]() { S.enumerate(); });
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  writer.join();
+
+  REQUIRE(nr_wrong == 0);
+  REQUIRE(S.is_done());
+  REQUIRE(S.size() == 46656);
+}
+
+TEST_CASE("Semigroup 78: closure with many elements",
+          "[quick][semigroup][finite][78]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({0, 1, 2, 3, 3, 3})};
+  std::vector<Element*> coll
+      = {new Transformation<u_int16_t>({0, 0, 1, 1, 2, 2}),
+         new Transformation<u_int16_t>({5, 4, 3, 2, 1, 0}),
+         new Transformation<u_int16_t>({0, 1, 2, 3, 4, 4}),
+         new Transformation<u_int16_t>({3, 3, 3, 3, 3, 3}),
+         new Transformation<u_int16_t>({1, 1, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({0, 0, 0, 1, 1, 1}),
+         new Transformation<u_int16_t>({2, 3, 4, 5, 0, 0}),
+         new Transformation<u_int16_t>({0, 1, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({4, 4, 4, 0, 1, 2}),
+         new Transformation<u_int16_t>({5, 0, 1, 2, 3, 4})};
+
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  REQUIRE(S.size() == 17856);
+
+  Semigroup T(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  std::vector<Element*> singleton(1, nullptr);
+  for (Element* x : coll) {
+    if (!T.test_membership(x)) {
+      singleton[0] = x;
+      T.add_generators(singleton);
+    }
+  }
+
+  S.closure(coll);
+  REQUIRE(S.size() == 46656);
+  REQUIRE(S.nrgens() == 5);
+  REQUIRE(*S.gens(3) == *coll[0]);
+  REQUIRE(*S.gens(4) == *coll[2]);
+  REQUIRE(S.size() == T.size());
+  REQUIRE(S.nrgens() == T.nrgens());
+  for (size_t i = 0; i < S.size(); i++) {
+    REQUIRE(T.test_membership(S.at(i)));
+  }
+  really_delete_cont(gens);
+  really_delete_cont(coll);
+}
+
+TEST_CASE("Semigroup 79: relations in bulk",
+          "[quick][semigroup][finite][multithread][79]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_max_threads(4);
+  really_delete_cont(gens);
+
+  std::vector<relation_t> expected;
+  word_t                  relation;
+  S.next_relation(relation);
+  while (!relation.empty()) {
+    if (relation.size() == 2) {
+      expected.push_back(
+          std::make_pair(word_t({relation[0]}), word_t({relation[1]})));
+    } else {
+      word_t lhs, rhs;
+      S.factorisation(lhs, relation[0]);
+      lhs.push_back(relation[1]);
+      S.factorisation(rhs, relation[2]);
+      expected.push_back(std::make_pair(lhs, rhs));
+    }
+    S.next_relation(relation);
+  }
+  REQUIRE(expected.size() == 6918);
+  REQUIRE(expected[0] == relation_t(word_t({2}), word_t({0})));
+
+  std::vector<relation_t> result;
+  S.relations(result);
+  REQUIRE(result == expected);
+
+  result.clear();
+  S.reset_next_relation();
+  while (S.next_relations(result, 1000) == 1000) {
+  }
+  REQUIRE(result == expected);
+  REQUIRE(S.next_relations(result, 1000) == 0);
+
+  result.clear();
+  std::atomic<bool> killed(true);
+  S.relations(result, killed);
+  REQUIRE(result.empty());
+}
+
+TEST_CASE("Semigroup 80: minimal factorisations of all elements",
+          "[quick][semigroup][finite][multithread][80]") {
+  std::string const     filename = "libsemigroups-semigroup-80.tmp";
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0})};
+  std::vector<Element*> extra
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_max_threads(4);
+  S.enumerate(100);
+  S.add_generators(extra);
+  really_delete_cont(gens);
+  really_delete_cont(extra);
+
+  std::vector<letter_t> letters;
+  std::vector<size_t>   offsets;
+  S.minimal_factorisations(letters, offsets);
+  REQUIRE(S.is_done());
+  REQUIRE(offsets.size() == 46657);
+  REQUIRE(offsets.back() == letters.size());
+
+  word_t word;
+  for (size_t i = 0; i < S.size(); i++) {
+    S.minimal_factorisation(word, i);
+    REQUIRE(word
+            == word_t(letters.begin() + offsets[i],
+                      letters.begin() + offsets[i + 1]));
+  }
+
+  REQUIRE(S.minimal_factorisations(filename));
+  std::ifstream         file(filename, std::ios::binary);
+  std::vector<uint64_t> data(2 + offsets.size() + letters.size());
+  file.read(reinterpret_cast<char*>(data.data()),
+            data.size() * sizeof(uint64_t));
+  REQUIRE(file.gcount() == data.size() * sizeof(uint64_t));
+  REQUIRE(file.peek() == EOF);
+  REQUIRE(data[0] == 46656);
+  REQUIRE(data[1] == letters.size());
+  REQUIRE(std::equal(offsets.begin(), offsets.end(), data.begin() + 2));
+  REQUIRE(std::equal(
+      letters.begin(), letters.end(), data.begin() + 2 + offsets.size()));
+  file.close();
+  std::remove(filename.c_str());
+
+  REQUIRE(!S.minimal_factorisations("/nonexistent-directory/" + filename));
+}
+
+TEST_CASE("Semigroup 81: adaptive batch size",
+          "[quick][semigroup][finite][81]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  S.set_batch_size(16);
+  S.set_adaptive_batch_size(true);
+
+  size_t nr_calls    = 0;
+  size_t nr_elements = 0;
+  S.set_batch_hook(
+      [&nr_calls, &nr_elements, &S](
+          size_t nr, int64_t elapsed, size_t batch_size) {
+        nr_calls++;
+        nr_elements += nr;
+        REQUIRE(elapsed >= 0);
+        REQUIRE(batch_size == S.batch_size());
+        REQUIRE(batch_size >= 16);
+      });
+
+  Transformation<u_int16_t> x({5, 5, 4, 3, 2, 1});
+  REQUIRE(S.position(&x) != Semigroup::UNDEFINED);
+  REQUIRE(nr_calls > 0);
+  REQUIRE(nr_elements == S.current_size() - 3);
+  REQUIRE(S.batch_size() > 16);
+
+  S.size();
+  REQUIRE(nr_elements == 46653);
+  // Far fewer calls to enumerate than the 46653 / 16 required if the batch
+  // size was fixed.
+  REQUIRE(nr_calls < 100);
+
+  S.set_adaptive_batch_size(false);
+  REQUIRE(S.batch_size() == 16);
+  really_delete_cont(gens);
+
+  // The hook is not passed on to the semigroups returned by
+  // copy_add_generators
+  gens = {new Transformation<u_int16_t>({1, 0, 2, 3}),
+          new Transformation<u_int16_t>({1, 2, 3, 0})};
+  Semigroup T(gens);
+  T.set_report(SEMIGROUPS_REPORT);
+  T.set_batch_size(16);
+  nr_calls = 0;
+  T.set_batch_hook([&nr_calls](size_t, int64_t, size_t) { nr_calls++; });
+  REQUIRE(T.size() == 24);
+  size_t const nr_calls_T = nr_calls;
+  REQUIRE(nr_calls_T > 0);
+
+  std::vector<Element*> coll = {new Transformation<u_int16_t>({0, 0, 2, 3})};
+  Semigroup*            U    = T.copy_add_generators(&coll);
+  U->set_batch_size(16);
+  REQUIRE(U->size() == 256);
+  REQUIRE(nr_calls == nr_calls_T);
+  delete U;
+  really_delete_cont(gens);
+  really_delete_cont(coll);
+}
+
+TEST_CASE("Semigroup 82: metrics", "[quick][semigroup][finite][82]") {
+  std::vector<Element*> gens
+      = {new Transformation<u_int16_t>({1, 0, 2, 3, 4, 5}),
+         new Transformation<u_int16_t>({1, 2, 3, 4, 5, 0}),
+         new Transformation<u_int16_t>({0, 0, 2, 3, 4, 5})};
+  Semigroup S(gens);
+  S.set_report(SEMIGROUPS_REPORT);
+  really_delete_cont(gens);
+
+  Semigroup::metrics_t metrics = S.metrics();
+  REQUIRE(metrics.nr_products == 0);
+  REQUIRE(metrics.nr_elements_by_length == std::vector<size_t>({3}));
+
+  S.enumerate(10000);
+  metrics = S.metrics();
+  REQUIRE(metrics.nr_products > 0);
+  REQUIRE(std::accumulate(metrics.nr_elements_by_length.begin(),
+                          metrics.nr_elements_by_length.end(),
+                          size_t(0))
+          == S.current_size());
+
+  S.size();
+  metrics = S.metrics();
+  REQUIRE(metrics.nr_rules == S.nrrules());
+  // Every product of an element and a generator is either a rule or a new
+  // element, but not every rule requires a product to be computed.
+  REQUIRE(metrics.nr_products <= S.nrrules() + S.size() - 3);
+  REQUIRE(metrics.nr_lookups >= metrics.nr_products);
+  REQUIRE(metrics.nr_probes >= S.size());
+  REQUIRE(metrics.nr_collisions <= S.size());
+  REQUIRE(std::accumulate(metrics.nr_elements_by_length.begin(),
+                          metrics.nr_elements_by_length.end(),
+                          size_t(0))
+          == 46656);
+  REQUIRE(metrics.nr_elements_by_length.size()
+          == S.current_max_word_length());
+  REQUIRE(metrics.time_by_length.size()
+          == metrics.nr_elements_by_length.size());
+  REQUIRE(metrics.time_by_length[0] == 0);
+  REQUIRE(metrics.time_enumerate > 0);
+  REQUIRE(metrics.time_redefine > 0);
+  REQUIRE(metrics.time_lookup > 0);
+  REQUIRE(metrics.time_bookkeeping >= 0);
+#ifdef LIBSEMIGROUPS_PACKED_CAYLEY_GRAPHS
+  // Every entry requires only 16 bits
+  REQUIRE(metrics.memory_cayley_graphs > 0);
+  REQUIRE(metrics.memory_cayley_graphs
+          < 2 * 46656 * 3 * sizeof(Semigroup::element_index_t));
+#else
+  REQUIRE(metrics.memory_cayley_graphs
+          >= 2 * 46656 * 3 * sizeof(Semigroup::element_index_t));
+#endif
+  REQUIRE(metrics.memory_hash_table > 0);
+  REQUIRE(metrics.memory_words > 0);
+  REQUIRE(metrics.memory_other > 0);
+
+  S.reset_metrics();
+  metrics = S.metrics();
+  REQUIRE(metrics.nr_products == 0);
+  REQUIRE(metrics.time_enumerate == 0);
+  REQUIRE(metrics.nr_rules == S.nrrules());
+}
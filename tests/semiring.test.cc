@@ -16,6 +16,9 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <random>
+#include <vector>
+
 #include "../src/semiring.h"
 #include "catch.hpp"
 
@@ -41,3 +44,85 @@ TEST_CASE("Semiring 02: threshold 0 [NaturalSemiring]",
 
   delete sr;
 }
+
+// Returns a random matrix of dimension n whose entries are between lo and hi,
+// or are equal to special (with probability about 1 / 4).
+static std::vector<int64_t> random_matrix(std::mt19937& mt,
+                                          size_t        n,
+                                          int64_t       lo,
+                                          int64_t       hi,
+                                          int64_t       special) {
+  std::uniform_int_distribution<int64_t> dist(lo, hi);
+  std::uniform_int_distribution<size_t>  coin(0, 3);
+  std::vector<int64_t>                   out(n * n);
+  for (auto& x : out) {
+    x = (coin(mt) == 0 ? special : dist(mt));
+  }
+  return out;
+}
+
+// Checks that sr->matrix_product agrees with Semiring::matrix_product, which
+// uses Semiring::plus and Semiring::prod.
+static void test_matrix_product(Semiring const* sr,
+                                int64_t         lo,
+                                int64_t         hi,
+                                int64_t         special) {
+  std::mt19937 mt(17);
+  for (size_t n = 1; n < 20; n++) {
+    for (size_t k = 0; k < 10; k++) {
+      std::vector<int64_t> x = random_matrix(mt, n, lo, hi, special);
+      std::vector<int64_t> y = random_matrix(mt, n, lo, hi, special);
+      std::vector<int64_t> expected(n * n), result(n * n);
+      sr->Semiring::matrix_product(x.data(), y.data(), expected.data(), n);
+      sr->matrix_product(x.data(), y.data(), result.data(), n);
+      REQUIRE(result == expected);
+    }
+  }
+}
+
+TEST_CASE("Semiring 03: matrix_product [Integers]", "[quick][semiring][03]") {
+  Semiring* sr = new Integers();
+  test_matrix_product(sr, -10, 10, 0);
+  delete sr;
+}
+
+TEST_CASE("Semiring 04: matrix_product [MaxPlusSemiring]",
+          "[quick][semiring][04]") {
+  Semiring* sr = new MaxPlusSemiring();
+  test_matrix_product(sr, -10, 10, Semiring::MINUS_INFTY);
+  delete sr;
+}
+
+TEST_CASE("Semiring 05: matrix_product [MinPlusSemiring]",
+          "[quick][semiring][05]") {
+  Semiring* sr = new MinPlusSemiring();
+  test_matrix_product(sr, -10, 10, Semiring::INFTY);
+  delete sr;
+}
+
+TEST_CASE("Semiring 06: matrix_product [TropicalMaxPlusSemiring]",
+          "[quick][semiring][06]") {
+  Semiring* sr = new TropicalMaxPlusSemiring(33);
+  test_matrix_product(sr, 0, 33, Semiring::MINUS_INFTY);
+  delete sr;
+}
+
+TEST_CASE("Semiring 07: matrix_product [TropicalMinPlusSemiring]",
+          "[quick][semiring][07]") {
+  Semiring* sr = new TropicalMinPlusSemiring(11);
+  test_matrix_product(sr, 0, 11, Semiring::INFTY);
+  delete sr;
+}
+
+TEST_CASE("Semiring 08: matrix_product [NaturalSemiring]",
+          "[quick][semiring][08]") {
+  Semiring* sr = new NaturalSemiring(11, 3);
+  test_matrix_product(sr, 0, 13, 0);
+  delete sr;
+
+  // The entries are too large to reduce only at the end
+  int64_t const t = int64_t(1) << 31;
+  sr              = new NaturalSemiring(t, 5);
+  test_matrix_product(sr, t - 10, t + 4, 0);
+  delete sr;
+}
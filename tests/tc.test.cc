@@ -20,9 +20,11 @@
 // achieved by calling cong->tc() before calculating anything about the
 // congruence.
 
+#include <new>
 #include <utility>
 
 #include "../src/cong.h"
+#include "../src/cong/cosettable.h"
 #include "catch.hpp"
 
 #define TC_REPORT false
@@ -607,3 +609,362 @@ TEST_CASE("TC 16: test packing phase", "[quick][tc][finite][16]") {
   cong2.set_report_interval(10);
   REQUIRE(cong2.nr_classes() == 78);
 }
+
+TEST_CASE("TC 17: strategies and lookahead policies",
+          "[quick][tc][finite][17]") {
+  std::vector<relation_t> rels
+      = {relation_t({0, 0, 0}, {0}),
+         relation_t({1, 0, 0}, {1, 0}),
+         relation_t({1, 0, 1, 1, 1}, {1, 0}),
+         relation_t({1, 1, 1, 1, 1}, {1, 1}),
+         relation_t({1, 1, 0, 1, 1, 0}, {1, 0, 1, 0, 1, 1}),
+         relation_t({0, 0, 1, 0, 1, 1, 0}, {0, 1, 0, 1, 1, 0}),
+         relation_t({0, 0, 1, 1, 0, 1, 0}, {0, 1, 1, 0, 1, 0}),
+         relation_t({0, 1, 0, 1, 0, 1, 0}, {1, 0, 1, 0, 1, 0}),
+         relation_t({1, 0, 1, 0, 1, 0, 1}, {1, 0, 1, 0, 1, 0}),
+         relation_t({1, 0, 1, 0, 1, 1, 0}, {1, 0, 1, 0, 1, 1}),
+         relation_t({1, 0, 1, 1, 0, 1, 0}, {1, 0, 1, 1, 0, 1}),
+         relation_t({1, 1, 0, 1, 0, 1, 0}, {1, 0, 1, 0, 1, 0}),
+         relation_t({1, 1, 1, 1, 0, 1, 0}, {1, 0, 1, 0}),
+         relation_t({0, 0, 1, 1, 1, 0, 1, 0}, {1, 1, 1, 0, 1, 0})};
+  std::vector<relation_t> extra = {relation_t({0, 1, 1}, {1, 0})};
+  std::vector<word_t>     words = {{0}, {1}, {0, 1}, {1, 0}, {1, 1, 0, 1}};
+
+  for (std::string type : {"twosided", "left", "right"}) {
+    for (std::vector<relation_t> const& ex :
+         {std::vector<relation_t>(), extra}) {
+      Congruence expected(type, 2, rels, ex);
+      expected.set_report(TC_REPORT);
+      expected.force_tc();
+      size_t const nr = expected.nr_classes();
+
+      for (Congruence::tc_strategy_t strategy :
+           {Congruence::TC_HLT, Congruence::TC_FELSCH, Congruence::TC_HYBRID}) {
+        for (Congruence::tc_lookahead_t lookahead :
+             {Congruence::TC_LOOKAHEAD_PARTIAL,
+              Congruence::TC_LOOKAHEAD_FULL,
+              Congruence::TC_LOOKAHEAD_NONE}) {
+          Congruence cong(type, 2, rels, ex);
+          cong.set_report(TC_REPORT);
+          cong.force_tc();
+          cong.set_pack(10);
+          cong.set_tc_strategy(strategy);
+          cong.set_tc_lookahead(lookahead, 0);
+          REQUIRE(cong.nr_classes() == nr);
+          for (word_t const& w1 : words) {
+            for (word_t const& w2 : words) {
+              REQUIRE(cong.test_equals(w1, w2)
+                      == expected.test_equals(w1, w2));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("TC 18: Felsch and hybrid strategies over a semigroup",
+          "[quick][tc][finite][18]") {
+  std::vector<Element*> vec = {new Transformation<u_int16_t>({1, 3, 4, 2, 3}),
+                               new Transformation<u_int16_t>({3, 2, 1, 3, 3})};
+  Semigroup S = Semigroup(vec);
+  S.set_report(TC_REPORT);
+  REQUIRE(S.size() == 88);
+
+  vec.push_back(new Transformation<u_int16_t>({3, 4, 4, 4, 4}));
+  word_t w1;
+  S.factorisation(w1, S.position(vec.back()));
+
+  vec.push_back(new Transformation<u_int16_t>({3, 1, 3, 3, 3}));
+  word_t w2;
+  S.factorisation(w2, S.position(vec.back()));
+
+  std::vector<relation_t> extra({relation_t(w1, w2)});
+
+  for (Congruence::tc_strategy_t strategy :
+       {Congruence::TC_FELSCH, Congruence::TC_HYBRID}) {
+    Congruence cong1("twosided", &S, extra);
+    cong1.set_report(TC_REPORT);
+    cong1.force_tc();
+    cong1.set_pack(10);
+    cong1.set_tc_strategy(strategy);
+    REQUIRE(cong1.nr_classes() == 21);
+
+    Congruence cong2("twosided", &S, extra);
+    cong2.set_report(TC_REPORT);
+    cong2.force_tc_prefill();
+    cong2.set_tc_strategy(strategy);
+    REQUIRE(cong2.nr_classes() == 21);
+
+    Congruence cong3("left", &S, extra);
+    cong3.set_report(TC_REPORT);
+    cong3.force_tc();
+    cong3.set_tc_strategy(strategy);
+    REQUIRE(cong3.nr_classes() == 69);
+  }
+  really_delete_cont(vec);
+}
+
+TEST_CASE("TC 19: statistics of the strategies", "[quick][tc][finite][19]") {
+  // A monoid presentation for PSL(2, 7), where 0 is the identity
+  std::vector<relation_t> rels
+      = {relation_t({0, 0}, {0}),
+         relation_t({0, 1}, {1}),
+         relation_t({1, 0}, {1}),
+         relation_t({0, 2}, {2}),
+         relation_t({2, 0}, {2}),
+         relation_t({1, 1}, {0}),
+         relation_t({2, 2, 2}, {0}),
+         relation_t({1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2}, {0}),
+         relation_t(
+             {1, 2, 2, 1, 2, 1, 2, 2, 1, 2, 1, 2, 2, 1, 2, 1, 2, 2, 1, 2},
+             {0})};
+
+  Congruence hlt("twosided", 3, rels, std::vector<relation_t>());
+  hlt.set_report(TC_REPORT);
+  hlt.force_tc();
+  hlt.set_pack(10);
+  REQUIRE(hlt.nr_classes() == 168);
+  Congruence::metrics_t m1 = hlt.metrics();
+  REQUIRE(!m1.tc_felsch);
+  REQUIRE(m1.nr_lookaheads > 0);
+  REQUIRE(m1.nr_deductions == 0);
+  REQUIRE(m1.nr_cosets_active == 169);
+  REQUIRE(m1.nr_cosets_max >= m1.nr_cosets_active);
+  REQUIRE(m1.nr_cosets_defined >= m1.nr_cosets_max);
+
+  Congruence none("twosided", 3, rels, std::vector<relation_t>());
+  none.set_report(TC_REPORT);
+  none.force_tc();
+  none.set_pack(10);
+  none.set_tc_lookahead(Congruence::TC_LOOKAHEAD_NONE);
+  REQUIRE(none.nr_classes() == 168);
+  Congruence::metrics_t m2 = none.metrics();
+  REQUIRE(m2.nr_lookaheads == 0);
+  REQUIRE(m2.nr_lookahead_killed == 0);
+
+  Congruence felsch("twosided", 3, rels, std::vector<relation_t>());
+  felsch.set_report(TC_REPORT);
+  felsch.force_tc();
+  felsch.set_tc_strategy(Congruence::TC_FELSCH);
+  REQUIRE(felsch.nr_classes() == 168);
+  Congruence::metrics_t m3 = felsch.metrics();
+  REQUIRE(m3.tc_felsch);
+  REQUIRE(m3.nr_lookaheads == 0);
+  REQUIRE(m3.nr_deductions > 0);
+  REQUIRE(m3.nr_cosets_active == 169);
+  REQUIRE(m3.nr_cosets_defined < m1.nr_cosets_defined);
+
+  Congruence hybrid("twosided", 3, rels, std::vector<relation_t>());
+  hybrid.set_report(TC_REPORT);
+  hybrid.force_tc();
+  hybrid.set_pack(10);
+  hybrid.set_tc_strategy(Congruence::TC_HYBRID);
+  REQUIRE(hybrid.nr_classes() == 168);
+  Congruence::metrics_t m4 = hybrid.metrics();
+  REQUIRE(m4.tc_felsch);
+  REQUIRE(m4.nr_lookaheads > 0);
+  REQUIRE(m4.nr_deductions > 0);
+  REQUIRE(m4.nr_cosets_defined < m1.nr_cosets_defined);
+}
+
+template <class TCosetTable> static void test_coset_table() {
+  size_t const UNDEFINED = TCosetTable::UNDEFINED;
+  TCosetTable  table(3, 2);
+  REQUIRE(table.nr_cols() == 3);
+  REQUIRE(table.nr_rows() == 2);
+  for (size_t c = 0; c < 2; c++) {
+    for (size_t i = 0; i < 3; i++) {
+      REQUIRE(table.get(c, i) == UNDEFINED);
+      REQUIRE(table.preim_init(c, i) == UNDEFINED);
+      REQUIRE(table.preim_next(c, i) == UNDEFINED);
+    }
+  }
+  table.add_rows(3);
+  REQUIRE(table.nr_rows() == 5);
+  for (size_t c = 0; c < 5; c++) {
+    for (size_t i = 0; i < 3; i++) {
+      table.set(c, i, c + i);
+      table.set_preim_init(c, i, 2 * c + i);
+      table.set_preim_next(c, i, 3 * c + i);
+    }
+  }
+  table.set(4, 2, UNDEFINED);
+  for (size_t c = 0; c < 5; c++) {
+    for (size_t i = 0; i < 3; i++) {
+      REQUIRE(table.get(c, i) == (c == 4 && i == 2 ? UNDEFINED : c + i));
+      REQUIRE(table.preim_init(c, i) == 2 * c + i);
+      REQUIRE(table.preim_next(c, i) == 3 * c + i);
+    }
+  }
+  TCosetTable copy(table);
+  copy.set(0, 0, 5000000000);
+  REQUIRE(copy.get(0, 0) == 5000000000);
+  REQUIRE(copy.get(4, 2) == UNDEFINED);
+  REQUIRE(copy.preim_next(4, 2) == 14);
+  copy.add_rows();
+  REQUIRE(copy.get(5, 1) == UNDEFINED);
+  REQUIRE(table.get(0, 0) == 0);
+}
+
+TEST_CASE("TC 20: coset table layouts", "[quick][tc][20]") {
+  test_coset_table<SplitCosetTable>();
+  test_coset_table<InterleavedCosetTable>();
+
+  InterleavedCosetTable table(2, 2);
+  table.set(1, 1, 4294967294);
+  REQUIRE(!table.is_wide());
+  REQUIRE(table.get(1, 1) == 4294967294);
+  table.set(1, 0, 4294967295);
+  REQUIRE(table.is_wide());
+  REQUIRE(table.get(1, 0) == 4294967295);
+  REQUIRE(table.get(1, 1) == 4294967294);
+  REQUIRE(table.get(0, 0) == InterleavedCosetTable::UNDEFINED);
+}
+
+// A monoid presentation for the symmetric group of degree 6, where 0 is the
+// identity and 1, ..., 5 are the Coxeter generators.
+static std::vector<relation_t> symmetric_group_6_relations() {
+  std::vector<relation_t> rels;
+  for (letter_t i = 0; i <= 5; i++) {
+    rels.push_back(relation_t({0, i}, {i}));
+    rels.push_back(relation_t({i, 0}, {i}));
+  }
+  for (letter_t i = 1; i <= 5; i++) {
+    rels.push_back(relation_t({i, i}, {0}));
+    for (letter_t j = i + 1; j <= 5; j++) {
+      if (j == i + 1) {
+        rels.push_back(relation_t({i, j, i, j, i, j}, {0}));
+      } else {
+        rels.push_back(relation_t({i, j, i, j}, {0}));
+      }
+    }
+  }
+  return rels;
+}
+
+TEST_CASE("TC 21: parallel lookahead", "[quick][tc][finite][21]") {
+  std::vector<relation_t> rels = symmetric_group_6_relations();
+
+  Congruence serial("twosided", 6, rels, std::vector<relation_t>());
+  serial.set_report(TC_REPORT);
+  serial.force_tc();
+  serial.set_pack(2000);
+  REQUIRE(serial.nr_classes() == 720);
+  Congruence::metrics_t m1 = serial.metrics();
+  REQUIRE(m1.nr_lookaheads > 0);
+
+  for (Congruence::tc_lookahead_t lookahead :
+       {Congruence::TC_LOOKAHEAD_PARTIAL, Congruence::TC_LOOKAHEAD_FULL}) {
+    for (size_t nr_threads : {2, 4}) {
+      Congruence cong("twosided", 6, rels, std::vector<relation_t>());
+      cong.set_report(TC_REPORT);
+      cong.force_tc();
+      cong.set_pack(2000);
+      cong.set_tc_lookahead(lookahead);
+      cong.set_tc_lookahead_threads(nr_threads);
+      REQUIRE(cong.nr_classes() == 720);
+      Congruence::metrics_t m2 = cong.metrics();
+      REQUIRE(m2.nr_lookaheads > 0);
+      REQUIRE(m2.nr_lookahead_killed > 0);
+      REQUIRE(cong.word_to_class_index({1, 2, 1})
+              == cong.word_to_class_index({2, 1, 2}));
+      REQUIRE(cong.word_to_class_index({1, 2})
+              != cong.word_to_class_index({2, 1}));
+    }
+  }
+}
+
+TEST_CASE("TC 22: large coincidences", "[quick][tc][finite][22]") {
+  // The monoid presentation for the symmetric group of degree 6, together
+  // with a relation which collapses it to a group of order 2, which causes
+  // some very large coincidences.
+  std::vector<relation_t> rels = symmetric_group_6_relations();
+  rels.push_back(relation_t({1, 2, 3, 4, 5}, {5, 4, 3, 2, 1}));
+
+  for (Congruence::tc_strategy_t strategy :
+       {Congruence::TC_HLT, Congruence::TC_FELSCH, Congruence::TC_HYBRID}) {
+    Congruence cong("twosided", 6, rels, std::vector<relation_t>());
+    cong.set_report(TC_REPORT);
+    cong.force_tc();
+    cong.set_tc_strategy(strategy);
+    REQUIRE(cong.nr_classes() == 2);
+    Congruence::metrics_t m = cong.metrics();
+    REQUIRE(m.nr_table_rewrites > 0);
+    REQUIRE(m.nr_cosets_active == 3);
+    REQUIRE(cong.word_to_class_index({1}) == cong.word_to_class_index({5}));
+    REQUIRE(cong.word_to_class_index({0})
+            == cong.word_to_class_index({1, 2}));
+    REQUIRE(cong.word_to_class_index({0}) != cong.word_to_class_index({3}));
+  }
+}
+
+TEST_CASE("TC 23: memory limit", "[quick][tc][finite][23]") {
+  std::vector<relation_t> rels = symmetric_group_6_relations();
+
+  Congruence cong1("twosided", 6, rels, std::vector<relation_t>());
+  cong1.set_report(TC_REPORT);
+  cong1.force_tc();
+  REQUIRE(cong1.nr_classes() == 720);
+  Congruence::metrics_t m1 = cong1.metrics();
+  REQUIRE(m1.nr_lookaheads == 0);
+
+  // Lookaheads are forced, so that fewer cosets are stored at once
+  Congruence cong2("twosided", 6, rels, std::vector<relation_t>());
+  cong2.set_report(TC_REPORT);
+  cong2.force_tc();
+  cong2.set_tc_memory_limit(150000);
+  REQUIRE(cong2.nr_classes() == 720);
+  Congruence::metrics_t m2 = cong2.metrics();
+  REQUIRE(m2.nr_lookaheads > 0);
+  REQUIRE(m2.nr_cosets_max < m1.nr_cosets_max);
+
+  // The limit is too small, but the algorithm can be continued once it is
+  // raised
+  Congruence cong3("twosided", 6, rels, std::vector<relation_t>());
+  cong3.set_report(TC_REPORT);
+  cong3.force_tc();
+  cong3.set_tc_memory_limit(1000);
+  REQUIRE_THROWS_AS(cong3.nr_classes(), std::bad_alloc const&);
+  REQUIRE(!cong3.is_done());
+  cong3.set_tc_memory_limit(0);
+  REQUIRE(cong3.nr_classes() == 720);
+  REQUIRE(cong3.word_to_class_index({1, 2, 1})
+          == cong3.word_to_class_index({2, 1, 2}));
+
+  // The same for one-sided congruences over the semigroup from TC 18, where
+  // the limit is reached while the extra relations are being applied.
+  std::vector<Element*> vec = {new Transformation<u_int16_t>({1, 3, 4, 2, 3}),
+                               new Transformation<u_int16_t>({3, 2, 1, 3, 3})};
+  Semigroup S = Semigroup(vec);
+  S.set_report(TC_REPORT);
+  REQUIRE(S.size() == 88);
+
+  vec.push_back(new Transformation<u_int16_t>({3, 4, 4, 4, 4}));
+  word_t w1;
+  S.factorisation(w1, S.position(vec.back()));
+
+  vec.push_back(new Transformation<u_int16_t>({3, 1, 3, 3, 3}));
+  word_t w2;
+  S.factorisation(w2, S.position(vec.back()));
+
+  std::vector<relation_t> extra({relation_t(w1, w2)});
+
+  Congruence cong4("left", &S, extra);
+  cong4.set_report(TC_REPORT);
+  cong4.force_tc();
+  cong4.set_tc_memory_limit(1);
+  REQUIRE_THROWS_AS(cong4.nr_classes(), std::bad_alloc const&);
+  cong4.set_tc_memory_limit(0);
+  REQUIRE(cong4.nr_classes() == 69);
+
+  Congruence cong5("right", &S, extra);
+  cong5.set_report(TC_REPORT);
+  cong5.force_tc();
+  cong5.set_tc_memory_limit(1);
+  REQUIRE_THROWS_AS(cong5.nr_classes(), std::bad_alloc const&);
+  cong5.set_tc_memory_limit(0);
+  REQUIRE(cong5.nr_classes() == 72);
+
+  really_delete_cont(vec);
+}